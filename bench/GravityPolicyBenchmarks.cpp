@@ -0,0 +1,95 @@
+#include "benchmark/benchmark.h"
+#include "Sim/BruteForceCPU.hpp"
+#include "Sim/GravityPolicy.hpp"
+#include "Sim/ParticleStore.hpp"
+#include "Sim/IParticleSeeder.hpp"
+
+#include <vector>
+
+namespace
+{
+    std::vector<Particle> SeedParticles(size_t num)
+    {
+        std::vector<Particle> particles(num);
+        CreateParticleSeeder(particles, EParticleSeeder::Galaxy)->Seed();
+
+        return particles;
+    }
+}
+
+// One target against every source, the inner loop of the brute force engine
+template <class Law>
+static void BM_GravityPolicyKernel(benchmark::State& state)
+{
+    using Real = typename Law::Real;
+
+    auto particles = SeedParticles(static_cast<size_t>(state.range(0)));
+    ParticleStore store;
+    store.Load(particles);
+
+    const size_t num = store.Size();
+    std::vector<Real> mass(num);
+
+    for(size_t i = 0; i < num; ++i)
+        mass[i] = static_cast<Real>(store.Mass[i] / 1e30);
+
+    for(auto _ : state)
+    {
+        for(size_t i = 0; i < num; i += 64)
+        {
+            const Real xi = store.PosX[i], yi = store.PosY[i], zi = store.PosZ[i];
+            Real fx = 0, fy = 0, fz = 0;
+
+            for(size_t j = 0; j < num; ++j)
+            {
+                Real dx = xi - store.PosX[j];
+                Real dy = yi - store.PosY[j];
+                Real dz = zi - store.PosZ[j];
+
+                Real d2 = dx * dx + dy * dy + dz * dz;
+                if(d2 <= Real(0)) continue;
+
+                Real k = mass[j] * Law::Kernel(d2);
+
+                fx += k * dx;
+                fy += k * dy;
+                fz += k * dz;
+            }
+
+            benchmark::DoNotOptimize(fx);
+            benchmark::DoNotOptimize(fy);
+            benchmark::DoNotOptimize(fz);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * ((num + 63) / 64) * num);
+}
+
+// A full step of the engine specialised for the law
+template <class Law>
+static void BM_GravityPolicyBruteForce(benchmark::State& state)
+{
+    auto particles = SeedParticles(static_cast<size_t>(state.range(0)));
+
+    BruteForceCPUSim<Law> sim(nullptr);
+    sim.Init(particles);
+
+    for(auto _ : state)
+        sim.Update(0.0f);
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(BM_GravityPolicyKernel, Phys::Plummer<double>)->Arg(16384);
+BENCHMARK_TEMPLATE(BM_GravityPolicyKernel, Phys::Plummer<float>)->Arg(16384);
+BENCHMARK_TEMPLATE(BM_GravityPolicyKernel, Phys::Spline<double>)->Arg(16384);
+BENCHMARK_TEMPLATE(BM_GravityPolicyKernel, Phys::Spline<float>)->Arg(16384);
+BENCHMARK_TEMPLATE(BM_GravityPolicyKernel, Phys::Unsoftened<double>)->Arg(16384);
+BENCHMARK_TEMPLATE(BM_GravityPolicyKernel, Phys::Unsoftened<float>)->Arg(16384);
+
+BENCHMARK_TEMPLATE(BM_GravityPolicyBruteForce, Phys::Plummer<double>)->Arg(4096)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_GravityPolicyBruteForce, Phys::Plummer<float>)->Arg(4096)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_GravityPolicyBruteForce, Phys::Spline<double>)->Arg(4096)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_GravityPolicyBruteForce, Phys::Spline<float>)->Arg(4096)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_GravityPolicyBruteForce, Phys::Unsoftened<double>)->Arg(4096)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_GravityPolicyBruteForce, Phys::Unsoftened<float>)->Arg(4096)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,99 @@
+#include "benchmark/benchmark.h"
+#include "Sim/Octree.hpp"
+#include "Sim/LinearOctree.hpp"
+#include "Sim/IParticleSeeder.hpp"
+
+namespace
+{
+    const BoundingCube Bounds = {
+        { -4000.0f, -4000.0f, -4000.0f },
+        { +4000.0f, +4000.0f, +4000.0f }
+    };
+
+    std::vector<Particle> SeedParticles(size_t num)
+    {
+        std::vector<Particle> particles(num);
+        CreateParticleSeeder(particles, EParticleSeeder::Random)->Seed();
+
+        return particles;
+    }
+
+    std::unique_ptr<Octree> BuildOctree(std::vector<Particle>& particles)
+    {
+        auto tree = std::make_unique<Octree>(Bounds);
+
+        for(auto& p : particles)
+            tree->Add(&p);
+
+        tree->CalculateMass();
+
+        return tree;
+    }
+}
+
+static void BM_OctreeBuild(benchmark::State& state)
+{
+    auto particles = SeedParticles(static_cast<size_t>(state.range(0)));
+
+    for(auto _ : state)
+    {
+        auto tree = BuildOctree(particles);
+        benchmark::DoNotOptimize(tree->TotalMass);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_LinearOctreeBuild(benchmark::State& state)
+{
+    auto particles = SeedParticles(static_cast<size_t>(state.range(0)));
+    ParticleStore store;
+    store.Load(particles);
+
+    LinearOctree tree;
+
+    for(auto _ : state)
+    {
+        tree.Build(Bounds, store);
+        benchmark::DoNotOptimize(tree.GetNodes()[0].TotalMass);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_OctreeTraverse(benchmark::State& state)
+{
+    auto particles = SeedParticles(static_cast<size_t>(state.range(0)));
+    auto tree = BuildOctree(particles);
+
+    for(auto _ : state)
+    {
+        for(auto& p : particles)
+            benchmark::DoNotOptimize(tree->CalculateForce(&p));
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_LinearOctreeTraverse(benchmark::State& state)
+{
+    auto particles = SeedParticles(static_cast<size_t>(state.range(0)));
+    ParticleStore store;
+    store.Load(particles);
+
+    LinearOctree tree;
+    tree.Build(Bounds, store);
+
+    for(auto _ : state)
+    {
+        for(uint32_t i = 0; i < particles.size(); ++i)
+            benchmark::DoNotOptimize(tree.CalculateForce(i));
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_OctreeBuild)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LinearOctreeBuild)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_OctreeTraverse)->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LinearOctreeTraverse)->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,149 @@
+#include "benchmark/benchmark.h"
+#include "Sim/Morton.hpp"
+#include "Sim/Physics.hpp"
+#include "Sim/LinearOctree.hpp"
+#include "Sim/IParticleSeeder.hpp"
+
+#include <cmath>
+
+namespace
+{
+    const BoundingCube Bounds = {
+        { -4000.0f, -4000.0f, -4000.0f },
+        { +4000.0f, +4000.0f, +4000.0f }
+    };
+
+    const size_t NumParticles = 50000;
+    const size_t NumSamples = 256;
+    const double TargetError = 1e-3;
+
+    struct Scene
+    {
+        ParticleStore Store;
+        MortonSorter Sorter;
+        size_t NumInside = 0;
+        std::vector<Vec3d> Exact;
+    };
+
+    // Sorted particles and the brute force forces on the sampled ones, shared by every benchmark
+    Scene& GetScene()
+    {
+        static Scene scene;
+
+        if(!scene.Exact.empty())
+            return scene;
+
+        std::vector<Particle> particles(NumParticles);
+        CreateParticleSeeder(particles, EParticleSeeder::Galaxy)->Seed();
+
+        scene.Store.Load(particles);
+
+        TaskScheduler scheduler;
+        scene.NumInside = scene.Sorter.Sort(scene.Store, Bounds, scheduler);
+
+        const auto& store = scene.Store;
+
+        for(size_t s = 0; s < NumSamples; ++s)
+        {
+            size_t i = s * (store.Size() / NumSamples);
+            Vec3d force;
+
+            for(size_t j = 0; j < store.Size(); ++j)
+            {
+                double dx = static_cast<double>(store.PosX[i]) - store.PosX[j];
+                double dy = static_cast<double>(store.PosY[i]) - store.PosY[j];
+                double dz = static_cast<double>(store.PosZ[i]) - store.PosZ[j];
+
+                double d2 = dx * dx + dy * dy + dz * dz;
+                if(i == j || d2 <= 0.0) continue;
+
+                double f = Phys::Gravity(store.Mass[i], store.Mass[j], d2) / std::sqrt(d2);
+                force += Vec3d(f * dx, f * dy, f * dz);
+            }
+
+            scene.Exact.push_back(force);
+        }
+
+        return scene;
+    }
+
+    // RMS relative force error over the samples, adds the interactions of the sampled particles
+    double MeasureError(const Scene& scene, const LinearOctree& tree, uint32_t* interactions)
+    {
+        double errorSq = 0.0, magnitudeSq = 0.0;
+
+        for(size_t s = 0; s < NumSamples; ++s)
+        {
+            size_t i = s * (scene.Store.Size() / NumSamples);
+
+            Vec3d force = tree.CalculateForce(static_cast<uint32_t>(i), interactions);
+            const Vec3d& exact = scene.Exact[s];
+
+            double ex = force.x - exact.x, ey = force.y - exact.y, ez = force.z - exact.z;
+
+            errorSq += ex * ex + ey * ey + ez * ez;
+            magnitudeSq += exact.x * exact.x + exact.y * exact.y + exact.z * exact.z;
+        }
+
+        return std::sqrt(errorSq / magnitudeSq);
+    }
+
+    // Largest theta whose error is within the target, found by bisection
+    double FindTheta(const Scene& scene, LinearOctree& tree)
+    {
+        double low = 0.05, high = 4.0;
+
+        for(int i = 0; i < 16; ++i)
+        {
+            Octree::Theta = std::sqrt(low * high);
+            tree.BuildSorted(Bounds, scene.Store, scene.Sorter.GetKeys(), scene.NumInside);
+
+            if(MeasureError(scene, tree, nullptr) > TargetError)
+                high = Octree::Theta;
+            else
+                low = Octree::Theta;
+        }
+
+        return low;
+    }
+}
+
+// Arguments are the opening criterion and whether quadrupoles are on, theta is tuned to TargetError first
+static void BM_OpeningCriterion(benchmark::State& state)
+{
+    Scene& scene = GetScene();
+
+    const double oldTheta = Octree::Theta;
+
+    LinearOctree::Criterion = static_cast<EOpeningCriterion>(state.range(0));
+    LinearOctree::UseQuadrupoles = state.range(1) != 0;
+
+    LinearOctree tree;
+    double theta = FindTheta(scene, tree);
+
+    Octree::Theta = theta;
+    tree.BuildSorted(Bounds, scene.Store, scene.Sorter.GetKeys(), scene.NumInside);
+
+    uint32_t interactions = 0;
+    double error = MeasureError(scene, tree, &interactions);
+
+    for(auto _ : state)
+    {
+        for(uint32_t i = 0; i < scene.Store.Size(); ++i)
+            benchmark::DoNotOptimize(tree.CalculateForce(i));
+    }
+
+    state.counters["theta"] = theta;
+    state.counters["error"] = error;
+    state.counters["interactions/particle"] = static_cast<double>(interactions) / NumSamples;
+    state.SetItemsProcessed(state.iterations() * scene.Store.Size());
+
+    Octree::Theta = oldTheta;
+    LinearOctree::Criterion = EOpeningCriterion::Classic;
+    LinearOctree::UseQuadrupoles = false;
+}
+
+BENCHMARK(BM_OpeningCriterion)
+    ->ArgNames({ "criterion", "quadrupole" })
+    ->ArgsProduct({ { 0, 1, 2 }, { 0, 1 } })
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,102 @@
+#include "benchmark/benchmark.h"
+#include "Sim/Physics.hpp"
+#include "Sim/ParticleStore.hpp"
+#include "Sim/IParticleSeeder.hpp"
+
+namespace
+{
+    const DirectX::SimpleMath::Vector3 Attractor(100.0f, 50.0f, -20.0f);
+
+    std::vector<Particle> SeedParticles(size_t num)
+    {
+        std::vector<Particle> particles(num);
+        CreateParticleSeeder(particles, EParticleSeeder::Random)->Seed();
+
+        return particles;
+    }
+}
+
+// Reads position and mass only, the access pattern of a force evaluation
+static void BM_ParticleForcePass(benchmark::State& state)
+{
+    auto particles = SeedParticles(static_cast<size_t>(state.range(0)));
+
+    for(auto _ : state)
+    {
+        double total = 0.0;
+
+        for(const auto& p : particles)
+            total += Phys::Gravity(p.Mass, 1e30, DirectX::SimpleMath::Vector3::DistanceSquared(p.Position, Attractor));
+
+        benchmark::DoNotOptimize(total);
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(Particle));
+}
+
+static void BM_ParticleStoreForcePass(benchmark::State& state)
+{
+    auto particles = SeedParticles(static_cast<size_t>(state.range(0)));
+    ParticleStore store;
+    store.Load(particles);
+
+    for(auto _ : state)
+    {
+        double total = 0.0;
+
+        for(size_t i = 0; i < store.Size(); ++i)
+            total += Phys::Gravity(store.Mass[i], 1e30, DirectX::SimpleMath::Vector3::DistanceSquared(store.GetPosition(i), Attractor));
+
+        benchmark::DoNotOptimize(total);
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0) * (3 * sizeof(float) + sizeof(double)));
+}
+
+static void BM_ParticleIntegrate(benchmark::State& state)
+{
+    auto particles = SeedParticles(static_cast<size_t>(state.range(0)));
+    const double dt = 1e-6;
+
+    for(auto _ : state)
+    {
+        for(auto& p : particles)
+        {
+            p.Velocity += (p.Forces / p.Mass) * dt;
+            auto vel = (p.Velocity * dt) / Phys::StarSystemScale;
+            p.Position += DirectX::SimpleMath::Vector3(static_cast<float>(vel.x), static_cast<float>(vel.y), static_cast<float>(vel.z));
+        }
+
+        benchmark::ClobberMemory();
+    }
+}
+
+static void BM_ParticleStoreIntegrate(benchmark::State& state)
+{
+    auto particles = SeedParticles(static_cast<size_t>(state.range(0)));
+    ParticleStore store;
+    store.Load(particles);
+
+    const double dt = 1e-6;
+
+    for(auto _ : state)
+    {
+        for(size_t i = 0; i < store.Size(); ++i)
+        {
+            store.VelX[i] += (store.ForceX[i] / store.Mass[i]) * dt;
+            store.VelY[i] += (store.ForceY[i] / store.Mass[i]) * dt;
+            store.VelZ[i] += (store.ForceZ[i] / store.Mass[i]) * dt;
+
+            store.PosX[i] += static_cast<float>((store.VelX[i] * dt) / Phys::StarSystemScale);
+            store.PosY[i] += static_cast<float>((store.VelY[i] * dt) / Phys::StarSystemScale);
+            store.PosZ[i] += static_cast<float>((store.VelZ[i] * dt) / Phys::StarSystemScale);
+        }
+
+        benchmark::ClobberMemory();
+    }
+}
+
+BENCHMARK(BM_ParticleForcePass)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ParticleStoreForcePass)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ParticleIntegrate)->Arg(1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ParticleStoreIntegrate)->Arg(1000000)->Unit(benchmark::kMillisecond);
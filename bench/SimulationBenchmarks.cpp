@@ -0,0 +1,316 @@
+//
+// SimulationBenchmarks.cpp
+//
+// Times full steps of every CPU simulation across particle count, seeder, theta and thread count.
+// Built as nbody_sim_bench, results are written to sim_bench.json and sim_bench.csv, or the
+// files given by --json=<file> and --csv=<file>. The usual --benchmark_* flags apply,
+// e.g. --benchmark_filter=BarnesHut/Galaxy to run part of the sweep.
+//
+
+#include "benchmark/benchmark.h"
+#include "Sim/Octree.hpp"
+#include "Sim/Precompute.hpp"
+#include "Core/TaskScheduler.hpp"
+
+#include <map>
+#include <cctype>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+namespace
+{
+    const ENBodySim Sims[] = {
+        ENBodySim::BruteForceCPU,
+        ENBodySim::BruteForceSIMD,
+        ENBodySim::BarnesHut,
+        ENBodySim::FastMultipole
+    };
+
+    const EParticleSeeder Seeders[] = {
+        EParticleSeeder::Random,
+        EParticleSeeder::Galaxy,
+        EParticleSeeder::StarSystem
+    };
+
+    const char* SeederNames[] = { "Random", "Galaxy", "StarSystem" };
+
+    // Only Barnes-Hut reads Octree::Theta, the other simulations run once with theta 0
+    const double Thetas[] = { 0.5, 1.0, 2.0 };
+
+    const int MinParticles = 1000;
+    const int MaxParticles = 4000000;
+
+    // The brute force simulations are O(n^2), larger counts take minutes a step
+    const int MaxBruteForceParticles = 64000;
+
+    // Powers of two up to the hardware thread count, plus the hardware thread count
+    std::vector<uint32_t> GetThreadCounts()
+    {
+        uint32_t hardware = std::max(std::thread::hardware_concurrency(), 1u);
+        std::vector<uint32_t> counts;
+
+        for(uint32_t threads = 1; threads < hardware; threads *= 2)
+            counts.push_back(threads);
+
+        counts.push_back(hardware);
+
+        return counts;
+    }
+
+    bool IsBruteForce(ENBodySim sim)
+    {
+        return sim == ENBodySim::BruteForceCPU || sim == ENBodySim::BruteForceSIMD;
+    }
+
+    std::string GetName(ENBodySim sim)
+    {
+        std::string name = NBodySimGetName(sim);
+        name.erase(std::remove_if(name.begin(), name.end(), [](char c) { return !std::isalnum(static_cast<unsigned char>(c)); }), name.end());
+
+        return name;
+    }
+
+    /*
+        Simulations are created once per type and thread count and re-initialised for each benchmark,
+        rather than starting new worker threads for each of the hundreds of benchmarks in the sweep.
+    */
+    class SimCache
+    {
+        public:
+            INBodySim* Get(ENBodySim type, uint32_t threads)
+            {
+                auto& sim = Sims[std::make_pair(type, threads)];
+
+                if(!sim)
+                {
+                    TaskScheduler::NumThreads = threads;
+                    sim = CreateNBodySim(nullptr, type);
+                    TaskScheduler::NumThreads = 0;
+                }
+
+                return sim.get();
+            }
+
+        private:
+            std::map<std::pair<ENBodySim, uint32_t>, std::unique_ptr<INBodySim>> Sims;
+    };
+
+    struct Config
+    {
+        ENBodySim Sim;
+        EParticleSeeder Seeder;
+        int NumParticles;
+        double Theta;
+        uint32_t Threads;
+    };
+
+    void BM_Simulation(benchmark::State& state, SimCache* cache, Config config)
+    {
+        std::vector<Particle> particles(config.NumParticles);
+        CreateParticleSeeder(particles, config.Seeder)->Seed();
+
+        const double oldTheta = Octree::Theta;
+
+        if(config.Theta > 0.0)
+            Octree::Theta = config.Theta;
+
+        INBodySim* sim = cache->Get(config.Sim, config.Threads);
+        sim->Init(particles);
+
+        // Same timestep as the precompute runner
+        const float dt = PrecomputeSettings().Timestep;
+        double totalNs = 0.0;
+
+        for(auto _ : state)
+        {
+            auto start = std::chrono::steady_clock::now();
+            sim->Update(dt);
+            auto end = std::chrono::steady_clock::now();
+
+            totalNs += std::chrono::duration<double, std::nano>(end - start).count();
+        }
+
+        state.counters["particles"] = config.NumParticles;
+        state.counters["theta"] = config.Theta;
+        state.counters["threads"] = config.Threads;
+        state.counters["ns_per_particle_step"] = totalNs / (static_cast<double>(state.iterations()) * config.NumParticles);
+        state.SetItemsProcessed(state.iterations() * config.NumParticles);
+
+        Octree::Theta = oldTheta;
+    }
+
+    void RegisterBenchmarks(SimCache* cache)
+    {
+        auto threadCounts = GetThreadCounts();
+
+        for(ENBodySim sim : Sims)
+        {
+            for(int seeder = 0; seeder < 3; ++seeder)
+            {
+                for(int num = MinParticles; num <= MaxParticles; num *= 4)
+                {
+                    if(IsBruteForce(sim) && num > MaxBruteForceParticles)
+                        break;
+
+                    std::vector<double> thetas(1, 0.0);
+
+                    if(sim == ENBodySim::BarnesHut)
+                        thetas.assign(std::begin(Thetas), std::end(Thetas));
+
+                    for(double theta : thetas)
+                    {
+                        for(uint32_t threads : threadCounts)
+                        {
+                            Config config = { sim, Seeders[seeder], num, theta, threads };
+
+                            std::string name = GetName(sim) + "/" + SeederNames[seeder] +
+                                "/n:" + std::to_string(num) +
+                                "/theta:" + std::to_string(theta).substr(0, 3) +
+                                "/threads:" + std::to_string(threads);
+
+                            benchmark::RegisterBenchmark(name.c_str(), BM_Simulation, cache, config)
+                                ->Unit(benchmark::kMillisecond)
+                                ->UseRealTime();
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Forwards every report to several reporters, so one run produces the console, JSON and CSV output
+    class MultiReporter : public benchmark::BenchmarkReporter
+    {
+        public:
+            void Add(benchmark::BenchmarkReporter* reporter) { Reporters.push_back(reporter); }
+
+            bool ReportContext(const Context& context) override
+            {
+                bool ok = true;
+
+                for(auto reporter : Reporters)
+                    ok = reporter->ReportContext(context) && ok;
+
+                return ok;
+            }
+
+            void ReportRuns(const std::vector<Run>& reports) override
+            {
+                for(auto reporter : Reporters)
+                    reporter->ReportRuns(reports);
+            }
+
+            void Finalize() override
+            {
+                for(auto reporter : Reporters)
+                    reporter->Finalize();
+            }
+
+        private:
+            std::vector<benchmark::BenchmarkReporter*> Reporters;
+    };
+
+    // One row per run with the sweep parameters as columns, for spreadsheets and regression scripts
+    class SweepCSVReporter : public benchmark::BenchmarkReporter
+    {
+        public:
+            bool ReportContext(const Context&) override
+            {
+                GetOutputStream() << "name,iterations,real_time_ms,particles,theta,threads,ns_per_particle_step\n";
+                return true;
+            }
+
+            void ReportRuns(const std::vector<Run>& reports) override
+            {
+                std::ostream& out = GetOutputStream();
+
+                for(const auto& run : reports)
+                {
+                    out << run.benchmark_name() << ","
+                        << run.iterations << ","
+                        << run.GetAdjustedRealTime() << ","
+                        << GetCounter(run, "particles") << ","
+                        << GetCounter(run, "theta") << ","
+                        << GetCounter(run, "threads") << ","
+                        << GetCounter(run, "ns_per_particle_step") << "\n";
+                }
+
+                out.flush();
+            }
+
+        private:
+            static double GetCounter(const Run& run, const char* name)
+            {
+                auto counter = run.counters.find(name);
+                return counter != run.counters.end() ? counter->second.value : 0.0;
+            }
+    };
+
+    // Removes --name=<value> from the arguments, returns whether it was found
+    bool TakeArgument(int& argc, char** argv, const char* name, std::string& value)
+    {
+        const size_t length = std::strlen(name);
+
+        for(int i = 1; i < argc; ++i)
+        {
+            if(std::strncmp(argv[i], name, length) == 0 && argv[i][length] == '=')
+            {
+                value = argv[i] + length + 1;
+
+                for(int j = i; j < argc - 1; ++j)
+                    argv[j] = argv[j + 1];
+
+                --argc;
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string jsonFile = "sim_bench.json", csvFile = "sim_bench.csv";
+
+    TakeArgument(argc, argv, "--json", jsonFile);
+    TakeArgument(argc, argv, "--csv", csvFile);
+
+    benchmark::Initialize(&argc, argv);
+
+    if(benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    std::ofstream json(jsonFile), csv(csvFile);
+
+    if(!json || !csv)
+    {
+        std::cerr << "Could not open " << jsonFile << " or " << csvFile << std::endl;
+        return 1;
+    }
+
+    benchmark::ConsoleReporter console;
+    benchmark::JSONReporter jsonReporter;
+    SweepCSVReporter csvReporter;
+
+    jsonReporter.SetOutputStream(&json);
+    jsonReporter.SetErrorStream(&std::cerr);
+    csvReporter.SetOutputStream(&csv);
+    csvReporter.SetErrorStream(&std::cerr);
+
+    MultiReporter reporter;
+    reporter.Add(&console);
+    reporter.Add(&jsonReporter);
+    reporter.Add(&csvReporter);
+
+    SimCache cache;
+    RegisterBenchmarks(&cache);
+
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+
+    return 0;
+}
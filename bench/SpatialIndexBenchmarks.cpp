@@ -0,0 +1,65 @@
+#include "benchmark/benchmark.h"
+#include "Core/Maths.hpp"
+#include "Core/SpatialIndex.hpp"
+#include "Sim/IParticleSeeder.hpp"
+
+#include <vector>
+
+namespace
+{
+    std::vector<Particle> SeedParticles(size_t num)
+    {
+        std::vector<Particle> particles(num);
+        CreateParticleSeeder(particles, EParticleSeeder::Galaxy)->Seed();
+
+        return particles;
+    }
+
+    // Walks a camera like path through the particles
+    DirectX::SimpleMath::Vector3 QueryPoint(size_t i)
+    {
+        float t = static_cast<float>(i % 1000) / 1000.0f;
+        return DirectX::SimpleMath::Vector3(-500.0f + 1000.0f * t, 20.0f * t, 100.0f - 200.0f * t);
+    }
+}
+
+// The closest object query as Galaxy did it before the index
+static void BM_SpatialIndexLinearScan(benchmark::State& state)
+{
+    auto particles = SeedParticles(static_cast<size_t>(state.range(0)));
+    size_t i = 0, id = 0;
+
+    for(auto _ : state)
+    {
+        benchmark::DoNotOptimize(Maths::ClosestParticle(QueryPoint(i++), particles, &id));
+        benchmark::DoNotOptimize(id);
+    }
+}
+
+static void BM_SpatialIndexNearest(benchmark::State& state)
+{
+    auto particles = SeedParticles(static_cast<size_t>(state.range(0)));
+
+    SpatialIndex index;
+    index.Build(particles);
+
+    size_t i = 0;
+
+    for(auto _ : state)
+        benchmark::DoNotOptimize(index.Nearest(QueryPoint(i++)));
+}
+
+static void BM_SpatialIndexBuild(benchmark::State& state)
+{
+    auto particles = SeedParticles(static_cast<size_t>(state.range(0)));
+    SpatialIndex index;
+
+    for(auto _ : state)
+        index.Build(particles);
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_SpatialIndexLinearScan)->Arg(500000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SpatialIndexNearest)->Arg(500000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SpatialIndexBuild)->Arg(500000)->Unit(benchmark::kMillisecond);
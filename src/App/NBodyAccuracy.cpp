@@ -0,0 +1,223 @@
+//
+// NBodyAccuracy.cpp
+//
+// Compares a simulation's forces with a long double all pairs reference on the same
+// initial conditions, for each theta (Barnes-Hut) or expansion order (Fast Multipole) given.
+// Prints RMS, 99th percentile and maximum relative error with the time per step, and with
+// -b the cheapest setting whose 99th percentile error is within the budget.
+// Fast Multipole runs can also be measured with mixed precision P2P (-x double,mixed),
+// each mixed run is then also compared with the double run of the same order.
+//
+
+#include "Sim/Octree.hpp"
+#include "Sim/Precompute.hpp"
+#include "Sim/ParticleFile.hpp"
+#include "Sim/FastMultipole.hpp"
+#include "Sim/ForceAccuracy.hpp"
+#include "Services/Log.hpp"
+
+#include <map>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <iostream>
+#include <cxxopts.hpp>
+
+namespace
+{
+    struct Setting
+    {
+        std::string Name;
+        double Value;
+        bool Mixed;
+    };
+
+    std::vector<double> ParseList(const std::string& list)
+    {
+        std::vector<double> values;
+        std::stringstream ss(list);
+        std::string item;
+
+        while(std::getline(ss, item, ','))
+        {
+            if(!item.empty())
+                values.push_back(std::stod(item));
+        }
+
+        return values;
+    }
+
+    // Sets the tunable a setting stands for, read by the simulation on its next Update
+    void Apply(ENBodySim sim, const Setting& setting)
+    {
+        if(sim == ENBodySim::BarnesHut)
+            Octree::Theta = setting.Value;
+        else if(sim == ENBodySim::FastMultipole)
+        {
+            FastMultipole::Order = static_cast<int>(setting.Value);
+            FastMultipole::MixedPrecision = setting.Mixed;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    cxxopts::Options options("nbody_accuracy", "Measure simulation force error against an all pairs reference");
+
+    int particles = 16000, samples = 1000, steps = 5;
+    float timestep = 0.02f, budget = 0.0f;
+    std::string file = "", thetas = "", orders = "", precisions = "double";
+    std::string simName = "barneshut", seederName = "galaxy";
+
+    options.add_options()
+        ("m,sim", "Simulation, e.g. barneshut, fastmultipole, bruteforcesimd", cxxopts::value<std::string>(simName))
+        ("e,seeder", "Seeder when not loading a file: random, galaxy or starsystem", cxxopts::value<std::string>(seederName))
+        ("p,particles", "Number of particles", cxxopts::value<int>(particles))
+        ("f,file", "Load initial conditions from the data directory", cxxopts::value<std::string>(file))
+        ("t,theta", "Comma separated Barnes-Hut thetas to measure", cxxopts::value<std::string>(thetas))
+        ("r,order", "Comma separated Fast Multipole expansion orders to measure", cxxopts::value<std::string>(orders))
+        ("x,precision", "Comma separated Fast Multipole P2P precisions to measure, double and mixed", cxxopts::value<std::string>(precisions))
+        ("n,samples", "Particles compared with the reference", cxxopts::value<int>(samples))
+        ("k,steps", "Steps timed for each setting", cxxopts::value<int>(steps))
+        ("s,timestep", "Timestep of the timed steps", cxxopts::value<float>(timestep))
+        ("b,budget", "99th percentile relative error budget, picks the cheapest setting within it", cxxopts::value<float>(budget))
+        ("h,help", "Print usage");
+
+    auto result = options.parse(argc, argv);
+
+    if(result.count("help") > 0)
+    {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    ENBodySim simType;
+    EParticleSeeder seederType;
+
+    if(!FindNBodySim(simName, simType))
+    {
+        LOGE("Unknown simulation " + simName)
+        return 1;
+    }
+
+    if(!FindParticleSeeder(seederName, seederType))
+    {
+        LOGE("Unknown seeder " + seederName)
+        return 1;
+    }
+
+    std::vector<Setting> settings;
+
+    if(simType == ENBodySim::BarnesHut)
+    {
+        for(double theta : ParseList(thetas.empty() ? std::to_string(Octree::Theta) : thetas))
+            settings.push_back({ "theta", theta, false });
+    }
+    else if(simType == ENBodySim::FastMultipole)
+    {
+        std::vector<bool> mixed;
+        std::stringstream ss(precisions);
+        std::string precision;
+
+        while(std::getline(ss, precision, ','))
+        {
+            if(precision != "double" && precision != "mixed")
+            {
+                LOGE("Unknown precision " + precision)
+                return 1;
+            }
+
+            mixed.push_back(precision == "mixed");
+        }
+
+        for(double order : ParseList(orders.empty() ? std::to_string(FastMultipole::Order) : orders))
+        {
+            for(bool m : mixed)
+                settings.push_back({ "order", order, m });
+        }
+    }
+    else
+    {
+        settings.push_back({ "default", 0.0, false });
+    }
+
+    std::vector<Particle> initial(particles);
+
+    if(file.length() > 0)
+    {
+        if(!ParticleFile::Load(file, initial))
+            return 1;
+    }
+    else
+    {
+        CreateParticleSeeder(initial, seederType)->Seed();
+    }
+
+    auto sim = CreateNBodySim(nullptr, simType);
+
+    if(!sim)
+        return 1;
+
+    auto sampled = ForceAccuracy::SampleParticles(initial.size(), static_cast<size_t>(samples));
+
+    auto referenceStart = std::chrono::steady_clock::now();
+    auto reference = ForceAccuracy::ReferenceForces(initial, sampled);
+    auto referenceTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - referenceStart).count();
+
+    LOGM("Reference forces for " + std::to_string(sampled.size()) + " of " + std::to_string(initial.size()) +
+         " particles in " + std::to_string(referenceTime) + "s")
+
+    // Same units as the windowed app, the timestep is given per 60th of a second
+    const float dt = timestep * (1.0f / 60.0f);
+
+    std::printf("%-16s %-9s %12s %12s %12s %12s\n", "setting", "precision", "rms", "p99", "max", "ms/step");
+
+    const Setting* cheapest = nullptr;
+    double cheapestMs = 0.0;
+
+    // Forces of the last double run at each setting value, to compare the mixed runs with
+    std::map<double, std::vector<Vec3d>> doubleForces;
+
+    for(const auto& setting : settings)
+    {
+        Apply(simType, setting);
+
+        std::vector<Particle> run = initial;
+        auto measured = ForceAccuracy::Measure(*sim, run, sampled, reference, dt, steps);
+
+        std::printf("%-8s %7.3g %-9s %12.3e %12.3e %12.3e %12.3f\n", setting.Name.c_str(), setting.Value,
+                    setting.Mixed ? "mixed" : "double", measured.RMS, measured.P99, measured.Max, measured.StepMs);
+
+        // Measure leaves the forces of the evaluation before the timed steps on the particles
+        if(!setting.Mixed)
+        {
+            auto& forces = doubleForces[setting.Value];
+            forces.clear();
+
+            for(uint32_t i : sampled)
+                forces.push_back(run[i].Forces);
+        }
+        else if(doubleForces.count(setting.Value) > 0)
+        {
+            auto drift = ForceAccuracy::Compare(run, sampled, doubleForces[setting.Value]);
+
+            std::printf("%-16s %-9s %12.3e %12.3e %12.3e\n", "", "vs double", drift.RMS, drift.P99, drift.Max);
+        }
+
+        if(budget > 0.0f && measured.P99 <= budget && (!cheapest || measured.StepMs < cheapestMs))
+        {
+            cheapest = &setting;
+            cheapestMs = measured.StepMs;
+        }
+    }
+
+    if(budget > 0.0f)
+    {
+        if(cheapest)
+            std::printf("Cheapest within a p99 budget of %g: %s %g (%.3f ms/step)\n", budget, cheapest->Name.c_str(), cheapest->Value, cheapestMs);
+        else
+            std::printf("No setting is within a p99 budget of %g\n", budget);
+    }
+
+    return 0;
+}
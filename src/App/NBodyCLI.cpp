@@ -0,0 +1,92 @@
+//
+// NBodyCLI.cpp
+//
+// Precomputes simulations without a window, the entry point of the headless build.
+// Takes the same -c/-t/-s/-p/-f options as the windowed app.
+// Also rewrites legacy raw particle files as snapshots with --convert.
+//
+
+#include "Sim/Precompute.hpp"
+#include "Sim/ParticleFile.hpp"
+#include "Services/Log.hpp"
+
+#include <thread>
+#include <iostream>
+#include <cxxopts.hpp>
+
+int main(int argc, char** argv)
+{
+    cxxopts::Options options("nbody_cli", "Precompute gravitational simulations without a window");
+
+    bool compute = true;
+    int simtime = 10, particles = 4000, frames = 0;
+    float timestep = 0.02f;
+    std::string file = "", output = "", convert = "", record = "";
+    int recordInterval = 1, checkpointInterval = 0;
+    bool resume = false;
+    std::string simName = "barneshut", seederName = "starsystem";
+
+    options.add_options()
+        ("c,compute", "Precompute a simulation, always on for this runner", cxxopts::value<bool>(compute))
+        ("t,simtime", "Time to run the precomputed simulation for", cxxopts::value<int>(simtime))
+        ("s,timestep", "Timestep", cxxopts::value<float>(timestep))
+        ("p,particles", "Number of particles", cxxopts::value<int>(particles))
+        ("f,file", "Load previous computation", cxxopts::value<std::string>(file))
+        ("n,frames", "Number of steps to run instead of simtime seconds", cxxopts::value<int>(frames))
+        ("m,sim", "Simulation, e.g. barneshut, fastmultipole, bruteforcesimd", cxxopts::value<std::string>(simName))
+        ("e,seeder", "Seeder when not loading a file: random, galaxy or starsystem", cxxopts::value<std::string>(seederName))
+        ("o,output", "File name to save to in the data directory", cxxopts::value<std::string>(output))
+        ("r,record", "Record a trajectory to this file in the data directory", cxxopts::value<std::string>(record))
+        ("record-every", "Steps between recorded trajectory frames", cxxopts::value<int>(recordInterval))
+        ("k,checkpoint-every", "Steps between checkpoints of the run, which --resume continues from", cxxopts::value<int>(checkpointInterval))
+        ("resume", "Continue the run saving to -o from its newest checkpoint, -n counts the steps already run", cxxopts::value<bool>(resume))
+        ("convert", "Rewrite a legacy particle file in the data directory as a snapshot, in place unless -o is given", cxxopts::value<std::string>(convert))
+        ("h,help", "Print usage");
+
+    auto result = options.parse(argc, argv);
+
+    if(result.count("help") > 0)
+    {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    if(!convert.empty())
+        return ParticleFile::ConvertLegacy(convert, output.empty() ? convert : output) ? 0 : 1;
+
+    if(resume && output.empty())
+    {
+        LOGE("--resume needs the -o name of the run to continue")
+        return 1;
+    }
+
+    PrecomputeSettings settings;
+
+    if(!FindNBodySim(simName, settings.Sim))
+    {
+        LOGE("Unknown simulation " + simName)
+        return 1;
+    }
+
+    if(!FindParticleSeeder(seederName, settings.Seeder))
+    {
+        LOGE("Unknown seeder " + seederName)
+        return 1;
+    }
+
+    // Same units as the windowed app, the timestep is given per 60th of a second
+    settings.Timestep = timestep * (1.0f / 60.0f);
+    settings.SimTime = simtime;
+    settings.Frames = frames;
+    settings.NumParticles = particles;
+    settings.File = file;
+    settings.Output = output;
+    settings.CheckpointInterval = checkpointInterval;
+    settings.Resume = resume;
+    settings.Trajectory = record;
+    settings.RecordInterval = recordInterval;
+
+    LOGM("Using " + std::to_string(std::thread::hardware_concurrency()) + " hardware threads")
+
+    return RunPrecompute(settings).empty() ? 1 : 0;
+}
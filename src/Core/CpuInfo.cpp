@@ -0,0 +1,104 @@
+#include "CpuInfo.hpp"
+
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    #define CPUINFO_X86 1
+#else
+    #define CPUINFO_X86 0
+#endif
+
+#if CPUINFO_X86
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#endif
+
+namespace
+{
+#if CPUINFO_X86
+    void CpuId(int leaf, int subleaf, uint32_t regs[4])
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuidex(info, leaf, subleaf);
+
+        for(int i = 0; i < 4; ++i)
+            regs[i] = static_cast<uint32_t>(info[i]);
+#else
+        __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    }
+
+    uint64_t XGetBV()
+    {
+#ifdef _MSC_VER
+        return _xgetbv(0);
+#else
+        uint32_t eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+    }
+
+    struct Features
+    {
+        bool AVX2 = false;
+        bool AVX512 = false;
+
+        Features()
+        {
+            uint32_t regs[4];
+
+            CpuId(0, 0, regs);
+            uint32_t maxLeaf = regs[0];
+
+            if(maxLeaf < 7)
+                return;
+
+            CpuId(1, 0, regs);
+
+            bool osxsave = (regs[2] & (1U << 27)) != 0;
+            bool avx     = (regs[2] & (1U << 28)) != 0;
+            bool fma     = (regs[2] & (1U << 12)) != 0;
+
+            if(!osxsave || !avx)
+                return;
+
+            uint64_t xcr0 = XGetBV();
+
+            CpuId(7, 0, regs);
+
+            // XMM and YMM state, then opmask and ZMM state on top for AVX-512
+            AVX2   = fma && (regs[1] & (1U << 5)) != 0 && (xcr0 & 0x06) == 0x06;
+            AVX512 = AVX2 && (regs[1] & (1U << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+        }
+    };
+
+    const Features& GetFeatures()
+    {
+        static Features features;
+        return features;
+    }
+#endif
+}
+
+bool CpuInfo::HasAVX2()
+{
+#if CPUINFO_X86
+    return GetFeatures().AVX2;
+#else
+    return false;
+#endif
+}
+
+bool CpuInfo::HasAVX512()
+{
+#if CPUINFO_X86
+    return GetFeatures().AVX512;
+#else
+    return false;
+#endif
+}
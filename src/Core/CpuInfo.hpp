@@ -0,0 +1,8 @@
+#pragma once
+
+namespace CpuInfo
+{
+    // Both check the CPU flags and that the OS saves the wider registers
+    bool HasAVX2();
+    bool HasAVX512();
+}
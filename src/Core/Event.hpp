@@ -24,7 +24,13 @@ enum class EEvent
     DrawDebugChanged,
     TrackParticle,
     LoadParticleFile,
+    LoadTrajectory,
     BHThetaChanged,
+    BHCriterionChanged,
+    BHQuadrupolesChanged,
+    BHRebuildThresholdChanged,
+    FMMOrderChanged,
+    FMMMixedPrecisionChanged,
     UseBloomChanged,
     UseSplattingChanged,
     SandboxBloomBaseChanged
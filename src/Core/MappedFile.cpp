@@ -0,0 +1,104 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if(file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+
+    if(!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if(mapping == nullptr)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if(data == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    File = file;
+    Mapping = mapping;
+    Data = static_cast<const uint8_t*>(data);
+    Size = static_cast<uint64_t>(size.QuadPart);
+#else
+    int file = open(path.c_str(), O_RDONLY);
+
+    if(file < 0)
+        return false;
+
+    struct stat info;
+
+    if(fstat(file, &info) != 0 || info.st_size == 0)
+    {
+        close(file);
+        return false;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+    // The mapping keeps its own reference to the file
+    close(file);
+
+    if(data == MAP_FAILED)
+        return false;
+
+    Data = static_cast<const uint8_t*>(data);
+    Size = static_cast<uint64_t>(info.st_size);
+#endif
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if(!Data)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(Data);
+    CloseHandle(Mapping);
+    CloseHandle(File);
+
+    File = nullptr;
+    Mapping = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(Data), static_cast<size_t>(Size));
+#endif
+
+    Data = nullptr;
+    Size = 0;
+}
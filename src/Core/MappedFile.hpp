@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+/*
+    Read only memory mapping of a whole file. The pages are loaded by the OS
+    on first touch, so opening is cheap however large the file is and readers
+    work straight from the page cache with no copy.
+*/
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // False if the file can't be opened or is empty
+    bool Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const { return Data != nullptr; }
+
+    const uint8_t* GetData() const { return Data; }
+    uint64_t GetSize() const { return Size; }
+
+private:
+    const uint8_t* Data = nullptr;
+    uint64_t Size = 0;
+
+#ifdef _WIN32
+    void* File = nullptr;
+    void* Mapping = nullptr;
+#endif
+};
@@ -1,5 +1,8 @@
 #include "Maths.hpp"
 
+#include <cmath>
+#include <cstdlib>
+
 int Maths::RandInt(int min, int max)
 {
     return (rand() % (max - min)) + min;
@@ -1,8 +1,9 @@
 #pragma once
 
+#include <limits>
 #include <vector>
-#include <d3d11.h>
-#include <SimpleMath.h>
+
+#include "Core/SimpleMath.hpp"
 
 #include "Render/Misc/Particle.hpp"
 
@@ -62,7 +63,7 @@ namespace Maths
     template <class T>
     const T& ClosestParticle(const DirectX::SimpleMath::Vector3& pos, const std::vector<T>& particles, size_t* outID = nullptr)
     {
-        const T* closest;
+        const T* closest = nullptr;
         size_t id = 0;
         float distance = (std::numeric_limits<float>::max)();
 
@@ -0,0 +1,17 @@
+#include "SimpleMath.hpp"
+
+#ifdef NBODY_HEADLESS
+
+namespace DirectX
+{
+    namespace SimpleMath
+    {
+        const Vector3 Vector3::Zero(0.0f, 0.0f, 0.0f);
+        const Vector3 Vector3::One(1.0f, 1.0f, 1.0f);
+        const Vector3 Vector3::UnitX(1.0f, 0.0f, 0.0f);
+        const Vector3 Vector3::UnitY(0.0f, 1.0f, 0.0f);
+        const Vector3 Vector3::UnitZ(0.0f, 0.0f, 1.0f);
+    }
+}
+
+#endif
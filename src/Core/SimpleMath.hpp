@@ -0,0 +1,243 @@
+#pragma once
+
+/*
+    DirectX::SimpleMath for code shared with the headless build.
+    Windows builds use DirectXTK's SimpleMath. Headless builds (NBODY_HEADLESS) get
+    the portable subset below instead, with the same names, memory layout and
+    conventions (row vectors, x y z w colours), covering what the simulations,
+    seeders and logging use.
+*/
+#ifndef NBODY_HEADLESS
+
+#include <d3d11.h>
+#include <SimpleMath.h>
+
+#else
+
+#include <cmath>
+#include <cstring>
+
+namespace DirectX
+{
+    const float XM_PI = 3.141592654f;
+
+    namespace SimpleMath
+    {
+        struct Matrix;
+
+        struct Vector2
+        {
+            float x, y;
+
+            Vector2() : x(0.0f), y(0.0f) {}
+            explicit Vector2(float v) : x(v), y(v) {}
+            Vector2(float _x, float _y) : x(_x), y(_y) {}
+
+            Vector2& operator+=(const Vector2& v) { x += v.x; y += v.y; return *this; }
+            Vector2& operator-=(const Vector2& v) { x -= v.x; y -= v.y; return *this; }
+
+            float Length() const { return std::sqrt(x * x + y * y); }
+            float LengthSquared() const { return x * x + y * y; }
+
+            static float Distance(const Vector2& a, const Vector2& b)
+            {
+                float dx = a.x - b.x, dy = a.y - b.y;
+                return std::sqrt(dx * dx + dy * dy);
+            }
+
+            static float DistanceSquared(const Vector2& a, const Vector2& b)
+            {
+                float dx = a.x - b.x, dy = a.y - b.y;
+                return dx * dx + dy * dy;
+            }
+        };
+
+        inline Vector2 operator+(const Vector2& a, const Vector2& b) { return Vector2(a.x + b.x, a.y + b.y); }
+        inline Vector2 operator-(const Vector2& a, const Vector2& b) { return Vector2(a.x - b.x, a.y - b.y); }
+        inline Vector2 operator*(const Vector2& a, float s) { return Vector2(a.x * s, a.y * s); }
+
+        struct Vector3
+        {
+            float x, y, z;
+
+            Vector3() : x(0.0f), y(0.0f), z(0.0f) {}
+            explicit Vector3(float v) : x(v), y(v), z(v) {}
+            Vector3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+
+            bool operator==(const Vector3& v) const { return x == v.x && y == v.y && z == v.z; }
+            bool operator!=(const Vector3& v) const { return !(*this == v); }
+
+            Vector3& operator+=(const Vector3& v) { x += v.x; y += v.y; z += v.z; return *this; }
+            Vector3& operator-=(const Vector3& v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
+            Vector3& operator*=(const Vector3& v) { x *= v.x; y *= v.y; z *= v.z; return *this; }
+            Vector3& operator*=(float s) { x *= s; y *= s; z *= s; return *this; }
+            Vector3& operator/=(float s) { x /= s; y /= s; z /= s; return *this; }
+
+            Vector3 operator+() const { return *this; }
+            Vector3 operator-() const { return Vector3(-x, -y, -z); }
+
+            float Length() const { return std::sqrt(x * x + y * y + z * z); }
+            float LengthSquared() const { return x * x + y * y + z * z; }
+            float Dot(const Vector3& v) const { return x * v.x + y * v.y + z * v.z; }
+
+            Vector3 Cross(const Vector3& v) const
+            {
+                return Vector3(y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x);
+            }
+
+            void Normalize()
+            {
+                float length = Length();
+
+                if(length > 0.0f)
+                {
+                    x /= length;
+                    y /= length;
+                    z /= length;
+                }
+            }
+
+            static float Distance(const Vector3& a, const Vector3& b)
+            {
+                return Vector3(a.x - b.x, a.y - b.y, a.z - b.z).Length();
+            }
+
+            static float DistanceSquared(const Vector3& a, const Vector3& b)
+            {
+                return Vector3(a.x - b.x, a.y - b.y, a.z - b.z).LengthSquared();
+            }
+
+            static Vector3 Lerp(const Vector3& a, const Vector3& b, float t)
+            {
+                return Vector3(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t);
+            }
+
+            static Vector3 Min(const Vector3& a, const Vector3& b)
+            {
+                return Vector3(a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y, a.z < b.z ? a.z : b.z);
+            }
+
+            static Vector3 Max(const Vector3& a, const Vector3& b)
+            {
+                return Vector3(a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y, a.z > b.z ? a.z : b.z);
+            }
+
+            static Vector3 Transform(const Vector3& v, const Matrix& m);
+
+            static const Vector3 Zero;
+            static const Vector3 One;
+            static const Vector3 UnitX;
+            static const Vector3 UnitY;
+            static const Vector3 UnitZ;
+        };
+
+        inline Vector3 operator+(const Vector3& a, const Vector3& b) { return Vector3(a.x + b.x, a.y + b.y, a.z + b.z); }
+        inline Vector3 operator-(const Vector3& a, const Vector3& b) { return Vector3(a.x - b.x, a.y - b.y, a.z - b.z); }
+        inline Vector3 operator*(const Vector3& a, const Vector3& b) { return Vector3(a.x * b.x, a.y * b.y, a.z * b.z); }
+        inline Vector3 operator*(const Vector3& a, float s) { return Vector3(a.x * s, a.y * s, a.z * s); }
+        inline Vector3 operator*(float s, const Vector3& a) { return Vector3(a.x * s, a.y * s, a.z * s); }
+        inline Vector3 operator/(const Vector3& a, float s) { return Vector3(a.x / s, a.y / s, a.z / s); }
+
+        struct Vector4
+        {
+            float x, y, z, w;
+
+            Vector4() : x(0.0f), y(0.0f), z(0.0f), w(0.0f) {}
+            Vector4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+        };
+
+        struct Color
+        {
+            float x, y, z, w;
+
+            Color() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) {}
+            Color(float r, float g, float b) : x(r), y(g), z(b), w(1.0f) {}
+            Color(float r, float g, float b, float a) : x(r), y(g), z(b), w(a) {}
+
+            bool operator==(const Color& c) const { return x == c.x && y == c.y && z == c.z && w == c.w; }
+            bool operator!=(const Color& c) const { return !(*this == c); }
+
+            float R() const { return x; }
+            float G() const { return y; }
+            float B() const { return z; }
+            float A() const { return w; }
+        };
+
+        struct Matrix
+        {
+            float m[4][4];
+
+            Matrix()
+            {
+                std::memset(m, 0, sizeof(m));
+                m[0][0] = m[1][1] = m[2][2] = m[3][3] = 1.0f;
+            }
+
+            Matrix operator*(const Matrix& o) const
+            {
+                Matrix r;
+
+                for(int i = 0; i < 4; ++i)
+                {
+                    for(int j = 0; j < 4; ++j)
+                    {
+                        r.m[i][j] = 0.0f;
+
+                        for(int k = 0; k < 4; ++k)
+                            r.m[i][j] += m[i][k] * o.m[k][j];
+                    }
+                }
+
+                return r;
+            }
+
+            static Matrix CreateScale(float s)
+            {
+                Matrix r;
+                r.m[0][0] = r.m[1][1] = r.m[2][2] = s;
+
+                return r;
+            }
+
+            static Matrix CreateTranslation(const Vector3& v)
+            {
+                Matrix r;
+                r.m[3][0] = v.x;
+                r.m[3][1] = v.y;
+                r.m[3][2] = v.z;
+
+                return r;
+            }
+
+            // Roll about z, then pitch about x, then yaw about y, as XMMatrixRotationRollPitchYaw
+            static Matrix CreateFromYawPitchRoll(float yaw, float pitch, float roll)
+            {
+                float cy = std::cos(yaw), sy = std::sin(yaw);
+                float cp = std::cos(pitch), sp = std::sin(pitch);
+                float cr = std::cos(roll), sr = std::sin(roll);
+
+                Matrix rz, rx, ry;
+
+                rz.m[0][0] = cr;  rz.m[0][1] = sr;
+                rz.m[1][0] = -sr; rz.m[1][1] = cr;
+
+                rx.m[1][1] = cp;  rx.m[1][2] = sp;
+                rx.m[2][1] = -sp; rx.m[2][2] = cp;
+
+                ry.m[0][0] = cy;  ry.m[0][2] = -sy;
+                ry.m[2][0] = sy;  ry.m[2][2] = cy;
+
+                return rz * rx * ry;
+            }
+        };
+
+        inline Vector3 Vector3::Transform(const Vector3& v, const Matrix& t)
+        {
+            return Vector3(v.x * t.m[0][0] + v.y * t.m[1][0] + v.z * t.m[2][0] + t.m[3][0],
+                           v.x * t.m[0][1] + v.y * t.m[1][1] + v.z * t.m[2][1] + t.m[3][1],
+                           v.x * t.m[0][2] + v.y * t.m[1][2] + v.z * t.m[2][2] + t.m[3][2]);
+        }
+    }
+}
+
+#endif
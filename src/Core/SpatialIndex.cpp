@@ -0,0 +1,222 @@
+#include "SpatialIndex.hpp"
+
+#include <limits>
+#include <utility>
+#include <algorithm>
+
+using namespace DirectX::SimpleMath;
+
+const size_t SpatialIndex::NoPoint;
+const size_t SpatialIndex::LeafSize;
+
+namespace
+{
+    inline float Coordinate(const Vector3& v, int axis)
+    {
+        return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+    }
+
+    // Splits order[begin, end) at its middle on the axis it's widest along, then both halves
+    void BuildRange(const std::vector<Vector3>& positions, std::vector<uint32_t>& order, std::vector<uint8_t>& axes,
+                    size_t begin, size_t end, size_t leafSize)
+    {
+        if(end - begin <= leafSize)
+            return;
+
+        Vector3 min = positions[order[begin]], max = min;
+
+        for(size_t i = begin + 1; i < end; ++i)
+        {
+            min = Vector3::Min(min, positions[order[i]]);
+            max = Vector3::Max(max, positions[order[i]]);
+        }
+
+        Vector3 size = max - min;
+        int axis = size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2);
+
+        size_t mid = begin + (end - begin) / 2;
+
+        std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end, [&](uint32_t a, uint32_t b) {
+            return Coordinate(positions[a], axis) < Coordinate(positions[b], axis);
+        });
+
+        axes[mid] = static_cast<uint8_t>(axis);
+
+        BuildRange(positions, order, axes, begin, mid, leafSize);
+        BuildRange(positions, order, axes, mid + 1, end, leafSize);
+    }
+}
+
+// The k best so far as a max heap on (distance squared, index), so ties go to the lowest index
+struct SpatialIndex::Neighbours
+{
+    size_t K;
+    std::vector<std::pair<float, uint32_t>> Heap;
+
+    float Worst() const
+    {
+        return Heap.size() < K ? (std::numeric_limits<float>::max)() : Heap.front().first;
+    }
+
+    void Offer(float distanceSq, uint32_t id)
+    {
+        auto candidate = std::make_pair(distanceSq, id);
+
+        if(Heap.size() < K)
+        {
+            Heap.push_back(candidate);
+            std::push_heap(Heap.begin(), Heap.end());
+        }
+        else if(candidate < Heap.front())
+        {
+            std::pop_heap(Heap.begin(), Heap.end());
+            Heap.back() = candidate;
+            std::push_heap(Heap.begin(), Heap.end());
+        }
+    }
+};
+
+void SpatialIndex::Build(const std::vector<Vector3>& positions)
+{
+    const size_t num = positions.size();
+
+    std::vector<uint32_t> order(num);
+
+    for(size_t i = 0; i < num; ++i)
+        order[i] = static_cast<uint32_t>(i);
+
+    Axis.assign(num, 0);
+    BuildRange(positions, order, Axis, 0, num, LeafSize);
+
+    X.resize(num);
+    Y.resize(num);
+    Z.resize(num);
+    Ids = order;
+
+    for(size_t i = 0; i < num; ++i)
+    {
+        const auto& p = positions[order[i]];
+
+        X[i] = p.x;
+        Y[i] = p.y;
+        Z[i] = p.z;
+    }
+
+    Factor = 1.0f;
+    Offset = Vector3::Zero;
+}
+
+void SpatialIndex::Clear()
+{
+    X.clear();
+    Y.clear();
+    Z.clear();
+    Ids.clear();
+    Axis.clear();
+
+    Factor = 1.0f;
+    Offset = Vector3::Zero;
+}
+
+void SpatialIndex::Translate(const Vector3& v)
+{
+    Offset += v;
+}
+
+void SpatialIndex::Scale(float factor)
+{
+    Factor *= factor;
+    Offset *= factor;
+}
+
+size_t SpatialIndex::Nearest(const Vector3& pos) const
+{
+    if(Ids.empty())
+        return NoPoint;
+
+    Vector3 local = (pos - Offset) / Factor;
+    const float q[3] = { local.x, local.y, local.z };
+
+    Neighbours found;
+    found.K = 1;
+    found.Heap.reserve(1);
+
+    float offsets[3] = { 0.0f, 0.0f, 0.0f };
+    Search(0, Ids.size(), q, offsets, 0.0f, found);
+
+    return found.Heap.front().second;
+}
+
+void SpatialIndex::Nearest(const Vector3& pos, size_t k, std::vector<size_t>& out) const
+{
+    out.clear();
+
+    if(Ids.empty() || k == 0)
+        return;
+
+    // Distances in the built space are the real ones over Factor, which doesn't change their order
+    Vector3 local = (pos - Offset) / Factor;
+    const float q[3] = { local.x, local.y, local.z };
+
+    Neighbours found;
+    found.K = k;
+    found.Heap.reserve((std::min)(k, Ids.size()));
+
+    float offsets[3] = { 0.0f, 0.0f, 0.0f };
+    Search(0, Ids.size(), q, offsets, 0.0f, found);
+
+    std::sort_heap(found.Heap.begin(), found.Heap.end());
+
+    for(const auto& neighbour : found.Heap)
+        out.push_back(neighbour.second);
+}
+
+void SpatialIndex::Search(size_t begin, size_t end, const float q[3], float offsets[3], float boxDistanceSq, Neighbours& found) const
+{
+    auto offer = [&](size_t i) {
+        float dx = X[i] - q[0];
+        float dy = Y[i] - q[1];
+        float dz = Z[i] - q[2];
+
+        found.Offer(dx * dx + dy * dy + dz * dz, Ids[i]);
+    };
+
+    if(end - begin <= LeafSize)
+    {
+        for(size_t i = begin; i < end; ++i)
+            offer(i);
+
+        return;
+    }
+
+    size_t mid = begin + (end - begin) / 2;
+    int axis = Axis[mid];
+
+    const float split = axis == 0 ? X[mid] : (axis == 1 ? Y[mid] : Z[mid]);
+    const float d = q[axis] - split;
+
+    offer(mid);
+
+    // The side holding the query first, so the other side is usually cut off
+    size_t nearBegin = begin, nearEnd = mid, farBegin = mid + 1, farEnd = end;
+
+    if(d >= 0.0f)
+    {
+        std::swap(nearBegin, farBegin);
+        std::swap(nearEnd, farEnd);
+    }
+
+    Search(nearBegin, nearEnd, q, offsets, boxDistanceSq, found);
+
+    // The far side's box is at least as far as the near side's, with this axis' gap swapped for the split's.
+    // Points on the split may be on either side, so an equal distance still searches it for ties
+    const float previous = offsets[axis];
+    const float farDistanceSq = boxDistanceSq - previous * previous + d * d;
+
+    if(farDistanceSq <= found.Worst())
+    {
+        offsets[axis] = d;
+        Search(farBegin, farEnd, q, offsets, farDistanceSq, found);
+        offsets[axis] = previous;
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Core/SimpleMath.hpp"
+
+/*
+    k-d tree over a fixed set of points for nearest and k nearest queries,
+    answering with the points' indices in the array it was built from.
+
+    The tree is built once, in the points' own space. Translate and Scale
+    move every point at once by updating a transform the queries are mapped
+    back through, so objects moved or scaled wholesale keep their index
+    without a rebuild. Scaling every point by the same factor keeps their
+    order by distance, so the tree stays valid.
+*/
+class SpatialIndex
+{
+public:
+    static const size_t NoPoint = ~static_cast<size_t>(0);
+
+    void Build(const std::vector<DirectX::SimpleMath::Vector3>& positions);
+
+    // Any array of items with a Position, e.g. Particle or LWParticle
+    template <class T>
+    void Build(const std::vector<T>& items)
+    {
+        std::vector<DirectX::SimpleMath::Vector3> positions(items.size());
+
+        for(size_t i = 0; i < items.size(); ++i)
+            positions[i] = items[i].Position;
+
+        Build(positions);
+    }
+
+    void Clear();
+
+    // Same as adding v to every point
+    void Translate(const DirectX::SimpleMath::Vector3& v);
+
+    // Same as multiplying every point by factor, which must not be 0
+    void Scale(float factor);
+
+    // Index of the closest point, NoPoint when empty. Of equally close points the lowest index wins
+    size_t Nearest(const DirectX::SimpleMath::Vector3& pos) const;
+
+    // Indices of the k closest points (fewer when there aren't k), closest first
+    void Nearest(const DirectX::SimpleMath::Vector3& pos, size_t k, std::vector<size_t>& out) const;
+
+    size_t Size() const { return Ids.size(); }
+    bool Empty() const { return Ids.empty(); }
+
+private:
+    struct Neighbours;
+
+    // Ranges this small are scanned rather than split further
+    static const size_t LeafSize = 8;
+
+    // offsets are the query's distances outside the range's box along each axis, as far as the splits above tell
+    void Search(size_t begin, size_t end, const float q[3], float offsets[3], float boxDistanceSq, Neighbours& found) const;
+
+    // Points in tree order. A range longer than LeafSize splits at its middle point, on Axis of that point
+    std::vector<float> X, Y, Z;
+    std::vector<uint32_t> Ids;
+    std::vector<uint8_t> Axis;
+
+    // Points are at Position * Factor + Offset
+    float Factor = 1.0f;
+    DirectX::SimpleMath::Vector3 Offset;
+};
@@ -0,0 +1,203 @@
+#include "TaskScheduler.hpp"
+
+uint32_t TaskScheduler::NumThreads = 0;
+
+namespace
+{
+    // The scheduler the current thread works for and its index there, workers only
+    struct WorkerContext
+    {
+        const TaskScheduler* Scheduler = nullptr;
+        uint32_t Index = 0;
+    };
+
+    thread_local WorkerContext CurrentWorker;
+
+    // Failed searches before an idle thread sleeps, keeps back to back parallel loops from paying for a wake up
+    const int SpinsBeforeSleep = 64;
+}
+
+TaskScheduler::TaskScheduler(uint32_t numThreads)
+{
+    if(numThreads == 0)
+        numThreads = NumThreads > 0 ? NumThreads : std::thread::hardware_concurrency();
+
+    numThreads = numThreads == 0 ? 8 : numThreads;
+
+    for(uint32_t i = 0; i < numThreads; ++i)
+        Queues.emplace_back(new WorkStealingQueue<Task>());
+
+    for(uint32_t i = 1; i < numThreads; ++i)
+        Workers.emplace_back(&TaskScheduler::Work, this, i);
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(SleepMutex);
+        Stopping = true;
+    }
+
+    WakeUp.notify_all();
+
+    for(auto& worker : Workers)
+        worker.join();
+
+    // Tasks nobody waited for still run, their owners may rely on the side effects
+    while(Task* task = FindTask(0))
+        Execute(task);
+}
+
+uint32_t TaskScheduler::GetThreadIndex() const
+{
+    return CurrentWorker.Scheduler == this ? CurrentWorker.Index : 0;
+}
+
+void TaskScheduler::Run(TaskGroup& group, std::function<void()> func)
+{
+    group.Pending.fetch_add(1, std::memory_order_relaxed);
+
+    Task* task = new Task{ std::move(func), &group };
+    uint32_t index = GetThreadIndex();
+
+    if(index > 0)
+    {
+        Queues[index]->Push(task);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(InjectedMutex);
+        Injected.push_back(task);
+        NumInjected.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Queued.fetch_add(1, std::memory_order_seq_cst);
+
+    // A sleeper either sees Queued above 0 before it waits or is waiting when this notifies
+    if(Sleeping.load(std::memory_order_seq_cst) > 0)
+    {
+        std::lock_guard<std::mutex> lock(SleepMutex);
+        WakeUp.notify_one();
+    }
+}
+
+void TaskScheduler::Wait(TaskGroup& group)
+{
+    const uint32_t index = GetThreadIndex();
+    int spins = 0;
+
+    while(!group.IsDone())
+    {
+        if(Task* task = FindTask(index))
+        {
+            Execute(task);
+            spins = 0;
+            continue;
+        }
+
+        if(++spins < SpinsBeforeSleep)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // The group's last tasks are running elsewhere, sleep until they finish or more work turns up
+        std::unique_lock<std::mutex> lock(SleepMutex);
+
+        Sleeping.fetch_add(1, std::memory_order_seq_cst);
+        WakeUp.wait(lock, [&]() { return group.IsDone() || Queued.load(std::memory_order_seq_cst) > 0; });
+        Sleeping.fetch_sub(1, std::memory_order_relaxed);
+
+        spins = 0;
+    }
+}
+
+void TaskScheduler::Work(uint32_t index)
+{
+    CurrentWorker.Scheduler = this;
+    CurrentWorker.Index = index;
+
+    int spins = 0;
+
+    while(true)
+    {
+        if(Task* task = FindTask(index))
+        {
+            Execute(task);
+            spins = 0;
+            continue;
+        }
+
+        if(++spins < SpinsBeforeSleep)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(SleepMutex);
+
+        Sleeping.fetch_add(1, std::memory_order_seq_cst);
+        WakeUp.wait(lock, [&]() { return Stopping || Queued.load(std::memory_order_seq_cst) > 0; });
+        Sleeping.fetch_sub(1, std::memory_order_relaxed);
+
+        if(Stopping)
+            return;
+
+        spins = 0;
+    }
+}
+
+TaskScheduler::Task* TaskScheduler::FindTask(uint32_t index)
+{
+    Task* task = nullptr;
+
+    // Own deque first, newest first for locality
+    if(index > 0)
+        task = Queues[index]->Pop();
+
+    if(!task && Queued.load(std::memory_order_relaxed) > 0)
+    {
+        if(NumInjected.load(std::memory_order_relaxed) > 0)
+        {
+            std::lock_guard<std::mutex> lock(InjectedMutex);
+
+            if(!Injected.empty())
+            {
+                task = Injected.front();
+                Injected.pop_front();
+                NumInjected.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        // Start at the next thread along so thieves spread over the victims
+        const uint32_t numQueues = static_cast<uint32_t>(Queues.size());
+
+        for(uint32_t i = 1; !task && i < numQueues; ++i)
+        {
+            uint32_t victim = (index + i) % numQueues;
+
+            if(victim > 0)
+                task = Queues[victim]->Steal();
+        }
+    }
+
+    if(task)
+        Queued.fetch_sub(1, std::memory_order_relaxed);
+
+    return task;
+}
+
+void TaskScheduler::Execute(Task* task)
+{
+    task->Func();
+
+    TaskGroup* group = task->Group;
+    delete task;
+
+    // Wakes a thread sleeping in Wait on this group
+    if(group->Pending.fetch_sub(1, std::memory_order_seq_cst) == 1 && Sleeping.load(std::memory_order_seq_cst) > 0)
+    {
+        std::lock_guard<std::mutex> lock(SleepMutex);
+        WakeUp.notify_all();
+    }
+}
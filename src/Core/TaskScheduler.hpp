@@ -0,0 +1,144 @@
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+#include "WorkStealingQueue.hpp"
+
+// Counts the unfinished tasks started with TaskScheduler::Run, wait on it with TaskScheduler::Wait
+struct TaskGroup
+{
+    std::atomic<uint32_t> Pending{ 0 };
+
+    bool IsDone() const { return Pending.load(std::memory_order_seq_cst) == 0; }
+};
+
+/*
+    Work stealing task scheduler. Each worker thread owns a Chase-Lev deque,
+    tasks started by a worker go on the bottom of its own deque and idle workers
+    steal from the top of the others, so the oldest (largest) pieces of a split
+    range move first. Tasks from threads outside the scheduler go through a
+    shared queue.
+
+    A thread waiting on a group runs queued tasks until the group is done, so
+    the calling thread counts as one of the scheduler's threads. One thread
+    outside the scheduler may use it at a time, it shares thread index 0.
+    Workers sleep when there is nothing to do and are joined on destruction.
+*/
+class TaskScheduler
+{
+public:
+    // 0 uses NumThreads, or one thread per hardware thread when that is 0 too
+    explicit TaskScheduler(uint32_t numThreads = 0);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Workers plus the calling thread
+    uint32_t GetNumThreads() const { return static_cast<uint32_t>(Workers.size()) + 1; }
+
+    // Index of the current thread in [0, GetNumThreads()), for per thread scratch buffers
+    uint32_t GetThreadIndex() const;
+
+    void Run(TaskGroup& group, std::function<void()> func);
+
+    // Runs queued tasks until every task in the group has finished
+    void Wait(TaskGroup& group);
+
+    // Threads used by schedulers created afterwards including the calling thread, 0 for one per hardware thread
+    static uint32_t NumThreads;
+
+private:
+    struct Task
+    {
+        std::function<void()> Func;
+        TaskGroup* Group;
+    };
+
+    void Work(uint32_t index);
+    Task* FindTask(uint32_t index);
+    void Execute(Task* task);
+
+    std::vector<std::thread> Workers;
+
+    // One deque per thread index, index 0 (threads outside the scheduler) uses Injected instead
+    std::vector<std::unique_ptr<WorkStealingQueue<Task>>> Queues;
+
+    std::mutex InjectedMutex;
+    std::deque<Task*> Injected;
+    std::atomic<uint32_t> NumInjected{ 0 };
+
+    // Tasks waiting in any queue, sleeping threads wake when this is non zero
+    std::atomic<int64_t> Queued{ 0 };
+    std::atomic<uint32_t> Sleeping{ 0 };
+
+    std::mutex SleepMutex;
+    std::condition_variable WakeUp;
+    bool Stopping = false;
+};
+
+/*
+    Splits [0, count) into ranges of about grain items and blocks until every
+    range has been processed. func is called as func(begin, end, thread), with
+    thread the index of the thread running the range, so per thread buffers can
+    be indexed by it. Ranges are split in halves on demand so idle threads steal
+    large pieces, a grain of 0 picks about 8 ranges per thread.
+*/
+template <class F>
+inline void ParallelFor(TaskScheduler& scheduler, size_t count, F func, size_t grain = 0)
+{
+    if(count == 0)
+        return;
+
+    const size_t numThreads = scheduler.GetNumThreads();
+
+    if(grain == 0)
+        grain = (std::max)(count / (numThreads * 8), static_cast<size_t>(1));
+
+    if(numThreads == 1 || count <= grain)
+    {
+        func(0, count, scheduler.GetThreadIndex());
+        return;
+    }
+
+    TaskGroup group;
+    std::function<void(size_t, size_t)> split;
+
+    split = [&](size_t begin, size_t end) {
+        while(end - begin > grain)
+        {
+            size_t mid = begin + (end - begin) / 2;
+            scheduler.Run(group, [&split, mid, end]() { split(mid, end); });
+            end = mid;
+        }
+
+        func(begin, end, scheduler.GetThreadIndex());
+    };
+
+    split(0, count);
+    scheduler.Wait(group);
+}
+
+/*
+    Splits [0, count) into numChunks fixed ranges and blocks until every chunk
+    has been processed. func is called as func(chunk, begin, end), a chunk sees
+    the same range on every call with the same count, so passes which count and
+    then write per chunk agree on where each chunk's output goes.
+*/
+template <class F>
+inline void ForEachChunk(TaskScheduler& scheduler, size_t count, size_t numChunks, F func)
+{
+    ParallelFor(scheduler, numChunks, [&](size_t begin, size_t end, uint32_t) {
+        for(size_t chunk = begin; chunk < end; ++chunk)
+            func(chunk, (count * chunk) / numChunks, (count * (chunk + 1)) / numChunks);
+    }, 1);
+}
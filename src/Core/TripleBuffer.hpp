@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+    Lock free hand over of the newest value from one producer thread to one
+    consumer thread. The producer fills the back slot and publishes it, the
+    consumer swaps the newest published slot in as its front. The third slot
+    sits between them, so neither side ever waits for the other, and values
+    the consumer didn't get to in time are overwritten by newer ones.
+*/
+template <class T>
+class TripleBuffer
+{
+public:
+    // Producer only
+    T& GetBack() { return Slots[Back]; }
+
+    // Makes the back slot the newest value and takes the middle slot as the next back
+    void Publish()
+    {
+        uint8_t previous = Middle.exchange(static_cast<uint8_t>(Back | Fresh), std::memory_order_acq_rel);
+        Back = previous & IndexMask;
+    }
+
+    // Consumer only, true when a value was published since the last call, it is the front from then on
+    bool Acquire()
+    {
+        if((Middle.load(std::memory_order_relaxed) & Fresh) == 0)
+            return false;
+
+        uint8_t previous = Middle.exchange(Front, std::memory_order_acq_rel);
+        Front = previous & IndexMask;
+
+        return true;
+    }
+
+    T& GetFront() { return Slots[Front]; }
+    const T& GetFront() const { return Slots[Front]; }
+
+    // Forgets anything published, only while neither side is using the buffer
+    void Reset()
+    {
+        Back = 0;
+        Middle.store(1, std::memory_order_relaxed);
+        Front = 2;
+    }
+
+private:
+    static const uint8_t IndexMask = 0x3;
+    static const uint8_t Fresh = 0x4;
+
+    T Slots[3];
+
+    static const size_t CacheLine = 64;
+
+    // Each side's index on its own cache line, the middle one is the only one both touch.
+    // Padded rather than alignas, which plain new doesn't honour before C++17
+    char BackPadding[CacheLine];
+    uint8_t Back = 0;
+    char MiddlePadding[CacheLine - 1];
+    std::atomic<uint8_t> Middle{ 1 };
+    char FrontPadding[CacheLine - 1];
+    uint8_t Front = 2;
+    char EndPadding[CacheLine - 1];
+};
@@ -1,10 +1,10 @@
 #pragma once
 
+#include <cmath>
 #include <string>
 #include <sstream>
 
-#include <d3d11.h>
-#include <SimpleMath.h>
+#include "Core/SimpleMath.hpp"
 
 /*
 	3D vector class
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+/*
+    Chase-Lev work stealing deque of pointers (Le et al., "Correct and
+    Efficient Work-Stealing for Weak Memory Models"). The owning thread
+    pushes and pops at the bottom, any other thread steals from the top.
+    The ring buffer doubles when full, replaced buffers are kept until the
+    queue is destroyed since a thief may still be reading one.
+*/
+template <class T>
+class WorkStealingQueue
+{
+public:
+    explicit WorkStealingQueue(int64_t capacity = 256);
+
+    // Owner only
+    void Push(T* item);
+    T* Pop();
+
+    // Any thread, nullptr when empty or another thread won the item
+    T* Steal();
+
+    bool Empty() const { return Bottom.load(std::memory_order_relaxed) <= Top.load(std::memory_order_relaxed); }
+
+private:
+    struct Buffer
+    {
+        explicit Buffer(int64_t capacity) : Capacity(capacity), Mask(capacity - 1), Items(new std::atomic<T*>[capacity]) {}
+
+        T* Get(int64_t i) const { return Items[i & Mask].load(std::memory_order_relaxed); }
+        void Put(int64_t i, T* item) { Items[i & Mask].store(item, std::memory_order_relaxed); }
+
+        int64_t Capacity, Mask;
+        std::unique_ptr<std::atomic<T*>[]> Items;
+    };
+
+    Buffer* Grow(Buffer* buffer, int64_t bottom, int64_t top);
+
+    static const size_t CacheLine = 64;
+
+    // Top and Bottom on separate cache lines, thieves hammer one and the owner the other.
+    // Padded rather than alignas, which plain new doesn't honour before C++17
+    std::atomic<int64_t> Top;
+    char TopPadding[CacheLine - sizeof(std::atomic<int64_t>)];
+    std::atomic<int64_t> Bottom;
+    char BottomPadding[CacheLine - sizeof(std::atomic<int64_t>)];
+    std::atomic<Buffer*> Current;
+    char CurrentPadding[CacheLine - sizeof(std::atomic<Buffer*>)];
+
+    std::vector<std::unique_ptr<Buffer>> Buffers;
+};
+
+template <class T>
+inline WorkStealingQueue<T>::WorkStealingQueue(int64_t capacity) : Top(0), Bottom(0)
+{
+    Buffers.emplace_back(new Buffer(capacity));
+    Current.store(Buffers.back().get(), std::memory_order_relaxed);
+}
+
+template <class T>
+inline void WorkStealingQueue<T>::Push(T* item)
+{
+    int64_t b = Bottom.load(std::memory_order_relaxed);
+    int64_t t = Top.load(std::memory_order_acquire);
+    Buffer* buffer = Current.load(std::memory_order_relaxed);
+
+    if(b - t > buffer->Capacity - 1)
+        buffer = Grow(buffer, b, t);
+
+    buffer->Put(b, item);
+
+    std::atomic_thread_fence(std::memory_order_release);
+    Bottom.store(b + 1, std::memory_order_relaxed);
+}
+
+template <class T>
+inline T* WorkStealingQueue<T>::Pop()
+{
+    int64_t b = Bottom.load(std::memory_order_relaxed) - 1;
+    Buffer* buffer = Current.load(std::memory_order_relaxed);
+
+    Bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    int64_t t = Top.load(std::memory_order_relaxed);
+
+    if(t > b)
+    {
+        // Empty
+        Bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    T* item = buffer->Get(b);
+
+    if(t == b)
+    {
+        // Last item, race the thieves for it
+        if(!Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            item = nullptr;
+
+        Bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    return item;
+}
+
+template <class T>
+inline T* WorkStealingQueue<T>::Steal()
+{
+    int64_t t = Top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = Bottom.load(std::memory_order_acquire);
+
+    if(t >= b)
+        return nullptr;
+
+    Buffer* buffer = Current.load(std::memory_order_acquire);
+    T* item = buffer->Get(t);
+
+    if(!Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+
+    return item;
+}
+
+template <class T>
+inline typename WorkStealingQueue<T>::Buffer* WorkStealingQueue<T>::Grow(Buffer* buffer, int64_t bottom, int64_t top)
+{
+    Buffers.emplace_back(new Buffer(buffer->Capacity * 2));
+    Buffer* grown = Buffers.back().get();
+
+    for(int64_t i = top; i < bottom; ++i)
+        grown->Put(i, buffer->Get(i));
+
+    Current.store(grown, std::memory_order_release);
+
+    return grown;
+}
@@ -74,6 +74,17 @@ std::vector<D3D11_INPUT_ELEMENT_DESC> CreateInputLayoutPositionColourScale()
     return layout;
 }
 
+// PackedParticle, see RenderStream
+std::vector<D3D11_INPUT_ELEMENT_DESC> CreateInputLayoutPackedParticle()
+{
+    std::vector<D3D11_INPUT_ELEMENT_DESC> layout = {
+        { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "COLOR",    0, DXGI_FORMAT_R8G8B8A8_UNORM    , 0, 8, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+    };
+
+    return layout;
+}
+
 std::vector<D3D11_INPUT_ELEMENT_DESC> CreateInputLayoutPositionNormalColour()
 {
     std::vector<D3D11_INPUT_ELEMENT_DESC> layout = {
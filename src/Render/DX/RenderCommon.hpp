@@ -58,6 +58,7 @@ std::vector<D3D11_INPUT_ELEMENT_DESC> CreateInputLayoutPosition();
 std::vector<D3D11_INPUT_ELEMENT_DESC> CreateInputLayoutPositionColour();
 std::vector<D3D11_INPUT_ELEMENT_DESC> CreateInputLayoutPositionTexture();
 std::vector<D3D11_INPUT_ELEMENT_DESC> CreateInputLayoutPositionColourScale();
+std::vector<D3D11_INPUT_ELEMENT_DESC> CreateInputLayoutPackedParticle();
 std::vector<D3D11_INPUT_ELEMENT_DESC> CreateInputLayoutPositionNormalColour();
 std::vector<D3D11_INPUT_ELEMENT_DESC> CreateInputLayoutPositionNormalTexture();
 
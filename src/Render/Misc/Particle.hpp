@@ -1,10 +1,11 @@
 #pragma once
 
-#include <d3d11.h>
-#include <SimpleMath.h>
+#include "Core/SimpleMath.hpp"
 
 #include "Core/Vec3.hpp"
 
+#include <cstdint>
+
 struct Particle
 {
     DirectX::SimpleMath::Vector3 Position;
@@ -24,6 +25,16 @@ struct LWParticle
     float Scale;
 };
 
+// What the particle shaders read for a simulated particle, 12 bytes rather than sizeof(Particle), see RenderStream
+struct PackedParticle
+{
+    // Unorm position within the stream's bounds, the fourth lane pads to the R16G16B16A16 vertex format
+    uint16_t Position[4];
+
+    // RGBA8, red in the lowest byte
+    uint32_t Colour;
+};
+
 #define define_has_member(member_name)                                         \
     template <typename T>                                                      \
     class has_member_##member_name                                             \
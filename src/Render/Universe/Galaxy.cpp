@@ -1,5 +1,4 @@
 #include "Galaxy.hpp"
-#include "Core/Maths.hpp"
 #include "Services/Log.hpp"
 #include "Services/ResourceManager.hpp"
 #include "Sim/IParticleSeeder.hpp"
@@ -7,6 +6,7 @@
 #include "Misc/ProcUtils.hpp"
 
 #include <random>
+#include <utility>
 
 using namespace DirectX::SimpleMath;
 
@@ -64,6 +64,8 @@ void Galaxy::InitialSeed(uint64_t seed)
     seeder->SetBlueDist(Colour.B() - Variation, Colour.B() + Variation);
     seeder->Seed(seed);
 
+    ParticleIndex.Build(Particles);
+
     std::uniform_real_distribution<double> distParticles(0, static_cast<double>(Particles.size()));
     std::uniform_real_distribution<float> distScale(4.0f, 18.0f);
     std::uniform_real_distribution<float> distAlpha(0.04f, 0.16f);
@@ -87,9 +89,10 @@ void Galaxy::InitialSeed(uint64_t seed)
     DustRenderer->UpdateInstances(DustClouds);
 }
 
-void Galaxy::FinishSeed(const std::vector<LWParticle>& particles)
+void Galaxy::FinishSeed(const std::vector<LWParticle>& particles, SpatialIndex&& index)
 {
     Particles = particles;
+    ParticleIndex = std::move(index);
     RegenerateBuffer();
 }
 
@@ -99,6 +102,7 @@ void Galaxy::Move(Vector3 v)
     for (auto& cloud : DustClouds) cloud.Position += v;
 
     Position += v;
+    ParticleIndex.Translate(v);
     RegenerateBuffer();
 }
 
@@ -107,6 +111,7 @@ void Galaxy::Scale(float scale)
     for (auto& particle : Particles) particle.Position /= scale;
     for (auto& cloud : DustClouds) cloud.Position /= scale;
 
+    ParticleIndex.Scale(1.0f / scale);
     RegenerateBuffer();
 }
 
@@ -169,7 +174,11 @@ void Galaxy::RenderImposter(const ICamera& cam, float scale)
 
 Vector3 Galaxy::GetClosestObject(Vector3 pos)
 {
-    return Particles.size() > 0 ? Maths::ClosestParticle(pos, Particles, &CurrentClosestObjectID).Position : Vector3::Zero;
+    if (ParticleIndex.Empty())
+        return Vector3::Zero;
+
+    CurrentClosestObjectID = ParticleIndex.Nearest(pos);
+    return Particles[CurrentClosestObjectID].Position;
 }
 
 void Galaxy::RegenerateBuffer()
@@ -8,6 +8,7 @@
 #include <CommonStates.h>
 
 #include "Core/Common.hpp"
+#include "Core/SpatialIndex.hpp"
 
 #include "Render/Cameras/Camera.hpp"
 #include "Render/Misc/Particle.hpp"
@@ -29,7 +30,8 @@ public:
     static void LoadCache(ID3D11Device* device, ID3D11DeviceContext* context);
 
     void InitialSeed(uint64_t seed);
-    void FinishSeed(const std::vector<LWParticle>& particles);
+    // index must have been built over particles, it's built with them off the render thread
+    void FinishSeed(const std::vector<LWParticle>& particles, SpatialIndex&& index);
 
     void Move(DirectX::SimpleMath::Vector3 v);
     void Scale(float scale);
@@ -88,6 +90,9 @@ private:
 
     std::vector<LWParticle> Particles;
     std::vector<BillboardInstance> DustClouds;
+
+    // Over Particles, follows Move and Scale
+    SpatialIndex ParticleIndex;
     std::unique_ptr<CBillboard> DustRenderer;
     std::unique_ptr<DirectX::CommonStates> CommonStates;
 
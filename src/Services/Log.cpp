@@ -1,8 +1,7 @@
 #include "Log.hpp"
 #include <iostream>
 
-#include <d3d11.h>
-#include <SimpleMath.h>
+#include "Core/SimpleMath.hpp"
 
 void FLog::Log(int num, ELogType logLevel)
 {
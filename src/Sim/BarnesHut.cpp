@@ -4,107 +4,374 @@
 #include "Core/Event.hpp"
 
 #include <thread>
+#include <chrono>
+#include <sstream>
+#include <algorithm>
 
-BarnesHut::BarnesHut(ID3D11DeviceContext* context)
-    : Context(context),
-      Pool(std::bind(&BarnesHut::Exec, this, std::placeholders::_1))
+namespace
 {
-    LOGM("Barnes-Hut")
+    typedef std::chrono::high_resolution_clock Clock;
 
-    const float size = 4000.0f;
+    double Milliseconds(Clock::time_point start, Clock::time_point end)
+    {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+}
 
-    Bounds = {
-        { -size, -size, -size },
-        { +size, +size, +size }
-    };
+std::atomic<float> BarnesHut::RebuildThreshold(0.25f);
+
+BarnesHut::BarnesHut(ID3D11DeviceContext* context)
+    : Context(context), Steps(Scheduler)
+{
+    std::string kernelName;
+    Kernel = Kernels::SelectGravityKernel(&kernelName);
+
+    LOGM("Barnes-Hut (" + kernelName + ")")
 
-    Tree = std::make_unique<Octree>(Bounds);
-    
+#ifndef NBODY_HEADLESS
     if(context)
     {
         DebugCube = std::make_unique<Cube>(context);
         DebugSphere = DirectX::GeometricPrimitive::CreateSphere(context);
     }
+#endif
 
     EventStream::Register(EEvent::BHThetaChanged, [&](const EventData& data) {
         Octree::Theta = EventValue<FloatEventData>(data);
     });
+
+    EventStream::Register(EEvent::BHCriterionChanged, [&](const EventData& data) {
+        LinearOctree::Criterion = static_cast<EOpeningCriterion>(EventValue<IntEventData>(data));
+    });
+
+    EventStream::Register(EEvent::BHQuadrupolesChanged, [&](const EventData& data) {
+        LinearOctree::UseQuadrupoles = EventValue<BoolEventData>(data);
+    });
+
+    EventStream::Register(EEvent::BHRebuildThresholdChanged, [&](const EventData& data) {
+        RebuildThreshold = EventValue<FloatEventData>(data);
+    });
 }
 
 BarnesHut::~BarnesHut()
 {
     EventStream::UnregisterAll(EEvent::BHThetaChanged);
+    EventStream::UnregisterAll(EEvent::BHCriterionChanged);
+    EventStream::UnregisterAll(EEvent::BHQuadrupolesChanged);
+    EventStream::UnregisterAll(EEvent::BHRebuildThresholdChanged);
 }
 
 void BarnesHut::Init(std::vector<Particle>& particles)
 {
     Particles = &particles;
+    Store.Load(particles);
+
+    // Same as BruteForceSIMD, keeps the kernel's float mass sums in range
+    MassScale = 1.0;
+
+    for(double mass : Store.Mass)
+        MassScale = (std::max)(MassScale, mass);
+
+    Scratch.resize(Scheduler.GetNumThreads());
+    ThreadBusy.assign(Scheduler.GetNumThreads(), 0.0);
+    ForceWall = 0.0;
+    Steps.Reset();
+    TreeBuilt = false;
 }
 
 void BarnesHut::Update(float dt)
 {
-    Tree = std::make_unique<Octree>(Bounds);
+    Steps.Begin(Store, dt);
+
+    while(Steps.NextSubstep(Store))
+    {
+        UpdateTree();
+
+        Steps.FindActive(Store);
+        PartitionZones();
 
-    Particle* particle = Particles->data();
+        auto start = Clock::now();
 
-    for(int i = 0; i < Particles->size(); ++i)
+        ParallelFor(Scheduler, Zones.size() - 1, [this](size_t begin, size_t end, uint32_t thread) {
+            for(size_t zone = begin; zone < end; ++zone)
+            {
+                auto zoneStart = Clock::now();
+                Exec(Zones[zone], Zones[zone + 1], thread);
+                ThreadBusy[thread] += Milliseconds(zoneStart, Clock::now());
+            }
+        }, 1);
+
+        ForceWall += Milliseconds(start, Clock::now());
+
+        Tree.AddEscapedForces(Store, Scheduler, [this](size_t i) { return Steps.IsActive(Store, i); });
+
+        Steps.Kick(Store);
+    }
+
+    ParallelFor(Scheduler, Store.Size(), [this](size_t begin, size_t end, uint32_t) {
+        Store.ProjectPositions(*Particles, begin, end);
+    }, ParticleStore::StreamGrain);
+
+    if(++Frames % ReportInterval == 0)
+        Report();
+}
+
+void BarnesHut::SyncParticles()
+{
+    Store.Project(*Particles, 0, Store.Size());
+}
+
+#ifndef NBODY_HEADLESS
+void BarnesHut::RenderDebug(DirectX::SimpleMath::Matrix view, DirectX::SimpleMath::Matrix proj)
+{
+    Tree.RenderDebug(DebugCube.get(), DebugSphere.get(), view, proj);
+}
+#endif
+
+void BarnesHut::UpdateTree()
+{
+    // Positions only change a little per substep, so most particles are still in their leaf.
+    // Moved particles lose their Morton order and leaves drift away from LeafSize, so the
+    // tree is rebuilt once enough of them have changed leaf
+    bool rebuild = !TreeBuilt;
+
+    if(!rebuild)
     {
-        Tree->Add(particle);
-        particle++;
+        uint32_t moved = Tree.Refit();
+
+        if(moved == LinearOctree::NullIndex)
+        {
+            rebuild = true;
+        }
+        else
+        {
+            MovedSinceBuild += moved;
+            rebuild = MovedSinceBuild > RebuildThreshold * NumInside;
+        }
     }
 
-    Tree->CalculateMass();
-    particle = Particles->data();
+    if(rebuild)
+    {
+        // The cube is refitted to the particles on every build, so it stays tight as they
+        // spread or contract. Sorting by Morton key puts particles in tree order, so leaves
+        // are contiguous and particles which walk the same branches are processed together
+        Bounds = Morton::FitBounds(Store, Scheduler);
+        NumInside = Sorter.Sort(Store, Bounds, Scheduler);
+        Tree.BuildSorted(Bounds, Store, Sorter.GetKeys(), NumInside, LeafSize);
 
-    const size_t numThreads = Pool.GetNumWorkers();
-    const size_t loopsPerThread = Particles->size() / numThreads;
-    const size_t remainder = Particles->size() % numThreads;
+        Tree.GetLeaves(TreeLeaves);
 
-    int32_t thread;
+        TreeBuilt = true;
+        MovedSinceBuild = 0;
+        ++Rebuilds;
 
-    for(thread = 0; thread < numThreads; ++thread)
+        if(Tree.GetNumEscaped() != NumEscaped)
+        {
+            NumEscaped = Tree.GetNumEscaped();
+            LOGM("Barnes-Hut build: " + std::to_string(NumEscaped) + " particles escaped the tree")
+        }
+    }
+    else
     {
-        Pool.Dispatch(thread, { static_cast<size_t>(thread), loopsPerThread });
+        ++Refits;
     }
-    
-    if(remainder > 0)
+
+    // Refits move particles between leaves but not the leaves, so they keep the build's Morton order
+    const auto& nodes = Tree.GetNodes();
+    Leaves.clear();
+
+    for(uint32_t leaf : TreeLeaves)
     {
-        for(int32_t i = thread; i < thread + remainder; ++i)
+        if(nodes[leaf].NumParticles > 0)
+            Leaves.push_back(leaf);
+    }
+}
+
+void BarnesHut::PartitionZones()
+{
+    // Cost of a leaf is the last interaction count of each of its active particles,
+    // particles without one yet count as a single interaction
+    LeafCosts.resize(Leaves.size());
+
+    ParallelFor(Scheduler, Leaves.size(), [this](size_t begin, size_t end, uint32_t) {
+        for(size_t l = begin; l < end; ++l)
         {
-            Particle* p = &(*Particles)[i];
-            p->Forces = Tree->CalculateForce(p);
+            uint64_t cost = 0;
+
+            for(uint32_t p = Tree.GetNodes()[Leaves[l]].FirstParticle; p != LinearOctree::NullIndex; p = Tree.GetNextParticle(p))
+            {
+                if(Steps.IsActive(Store, p))
+                    cost += (std::max)(Store.Cost[p], 1u);
+            }
+
+            LeafCosts[l] = cost;
         }
+    });
+
+    // Leaves are in Morton order, so each zone is a compact region of space
+    PartitionCosts(LeafCosts, Scheduler.GetNumThreads(), Zones);
+}
+
+void BarnesHut::PartitionCosts(const std::vector<uint64_t>& costs, size_t numZones, std::vector<size_t>& zones)
+{
+    uint64_t total = 0;
+
+    for(uint64_t cost : costs)
+        total += cost;
+
+    uint64_t sum = 0;
+
+    zones.assign(1, 0);
+
+    for(size_t l = 0; l < costs.size() && zones.size() < numZones; ++l)
+    {
+        sum += costs[l];
+
+        if(sum * numZones >= total * zones.size())
+            zones.push_back(l + 1);
     }
 
-    Pool.Join();
+    zones.resize(numZones + 1, costs.size());
+}
 
-    particle = Particles->data();
+void BarnesHut::Report()
+{
+    std::ostringstream ss;
+    ss << "Barnes-Hut tree: " << Rebuilds << " rebuilds, " << Refits << " refits";
 
-    for(int i = 0; i < Particles->size(); ++i)
+    LOGM(ss.str())
+
+    // Idle time is the part of the force passes each thread spent waiting for the others
+    double maxBusy = 0.0, totalBusy = 0.0;
+
+    ss.str("");
+    ss.precision(1);
+    ss << std::fixed << "Barnes-Hut threads busy/idle ms over " << ReportInterval << " frames:";
+
+    for(size_t t = 0; t < ThreadBusy.size(); ++t)
     {
-        auto a = particle->Forces / particle->Mass;
-        particle->Velocity += a * dt;
+        ss << " " << t << ": " << ThreadBusy[t] << "/" << (std::max)(ForceWall - ThreadBusy[t], 0.0);
 
-        auto vel = (particle->Velocity * dt) / Phys::StarSystemScale;
+        maxBusy = (std::max)(maxBusy, ThreadBusy[t]);
+        totalBusy += ThreadBusy[t];
+    }
 
-        particle->Position += DirectX::SimpleMath::Vector3(static_cast<float>(vel.x),
-                                                           static_cast<float>(vel.y),
-                                                           static_cast<float>(vel.z));
-                                                           
-        particle++;
+    if(totalBusy > 0.0)
+    {
+        ss.precision(2);
+        ss << ", imbalance " << maxBusy * ThreadBusy.size() / totalBusy;
     }
+
+    LOGM(ss.str())
+
+    std::fill(ThreadBusy.begin(), ThreadBusy.end(), 0.0);
+    ForceWall = 0.0;
 }
 
-void BarnesHut::RenderDebug(DirectX::SimpleMath::Matrix view, DirectX::SimpleMath::Matrix proj)
+void BarnesHut::Exec(size_t begin, size_t end, uint32_t thread)
 {
-    Tree->RenderDebug(DebugCube.get(), DebugSphere.get(), view, proj);
+    for(size_t l = begin; l < end; ++l)
+        ExecLeaf(Leaves[l], Scratch[thread]);
 }
 
-void BarnesHut::Exec(const ParticleInfo& info)
+void BarnesHut::ExecLeaf(uint32_t leaf, Interactions& list)
 {
-    for (size_t i = info.Index * info.Loops; i < (info.Index + 1) * info.Loops; ++i)
+    const auto& nodes = Tree.GetNodes();
+    const auto& target = nodes[leaf];
+
+    // Only the particles whose timestep ends on this substep need a force
+    list.Targets.clear();
+    list.TargetX.clear();
+    list.TargetY.clear();
+    list.TargetZ.clear();
+
+    for(uint32_t p = target.FirstParticle; p != LinearOctree::NullIndex; p = Tree.GetNextParticle(p))
+    {
+        if(!Steps.IsActive(Store, p))
+            continue;
+
+        list.Targets.push_back(p);
+        list.TargetX.push_back(Store.PosX[p]);
+        list.TargetY.push_back(Store.PosY[p]);
+        list.TargetZ.push_back(Store.PosZ[p]);
+    }
+
+    if(list.Targets.empty())
+        return;
+
+    Tree.GetInteractions(leaf, list.Cells, list.Leaves);
+
+    list.X.clear();
+    list.Y.clear();
+    list.Z.clear();
+    list.Mass.clear();
+
+    for(uint32_t cell : list.Cells)
+    {
+        const auto& node = nodes[cell];
+
+        list.X.push_back(node.CentreOfMass.x);
+        list.Y.push_back(node.CentreOfMass.y);
+        list.Z.push_back(node.CentreOfMass.z);
+        list.Mass.push_back(static_cast<float>(node.TotalMass / MassScale));
+    }
+
+    for(uint32_t source : list.Leaves)
     {
-        Particle* p = &(*Particles)[i];
-        p->Forces = Tree->CalculateForce(p);
+        const auto& node = nodes[source];
+
+        for(uint32_t q = node.FirstParticle; q != LinearOctree::NullIndex; q = Tree.GetNextParticle(q))
+        {
+            list.X.push_back(Store.PosX[q]);
+            list.Y.push_back(Store.PosY[q]);
+            list.Z.push_back(Store.PosZ[q]);
+            list.Mass.push_back(static_cast<float>(Store.Mass[q] / MassScale));
+        }
+    }
+
+    Kernels::GravitySources sources = {
+        list.X.data(),
+        list.Y.data(),
+        list.Z.data(),
+        list.Mass.data(),
+        list.X.size(),
+        static_cast<float>(Phys::S)
+    };
+
+    Kernels::GravityTargets targets = {
+        list.TargetX.data(),
+        list.TargetY.data(),
+        list.TargetZ.data(),
+        list.Targets.size()
+    };
+
+    list.ForceX.resize(list.Targets.size());
+    list.ForceY.resize(list.Targets.size());
+    list.ForceZ.resize(list.Targets.size());
+
+    Kernel(sources, targets, list.ForceX.data(), list.ForceY.data(), list.ForceZ.data());
+
+    // Quadrupole terms are a second pass over the cells
+    const bool quadrupoles = Tree.HasQuadrupoles();
+    const uint32_t cost = static_cast<uint32_t>(list.X.size() + (quadrupoles ? list.Cells.size() : 0));
+
+    for(size_t i = 0; i < list.Targets.size(); ++i)
+    {
+        uint32_t p = list.Targets[i];
+        double scale = -Phys::G * Store.Mass[p] * MassScale;
+
+        Store.Cost[p] = cost;
+
+        Vec3d force(list.ForceX[i] * scale, list.ForceY[i] * scale, list.ForceZ[i] * scale);
+
+        if(quadrupoles)
+        {
+            for(uint32_t cell : list.Cells)
+                force += Tree.CalculateQuadrupoleForce(cell, p);
+        }
+
+        Store.ForceX[p] = force.x;
+        Store.ForceY[p] = force.y;
+        Store.ForceZ[p] = force.z;
     }
 }
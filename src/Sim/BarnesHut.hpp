@@ -1,12 +1,33 @@
 #pragma once
 
-#include <GeometricPrimitive.h>
-
-#include "Octree.hpp"
+#include "Morton.hpp"
+#include "LinearOctree.hpp"
 #include "INBodySim.hpp"
+#include "Core/TaskScheduler.hpp"
+#include "Kernels/Gravity.hpp"
+#include "BlockTimestep.hpp"
+
+#ifndef NBODY_HEADLESS
+#include <GeometricPrimitive.h>
 #include "Render/Model/Cube.hpp"
-#include "Core/ThreadPool.hpp"
+#endif
 
+/*
+    Leaves hold up to LeafSize particles and the tree is walked once per
+    leaf. The far nodes and near particles found by the walk are gathered
+    into one source list and summed onto the whole leaf with the SIMD kernel.
+    Particles are advanced with block timesteps, so each substep only
+    evaluates the leaves holding active particles.
+
+    The leaves are split into one cost zone per thread, contiguous in Morton
+    order with about equal interactions by each particle's count from its
+    last evaluation, so the dense core doesn't land on a single thread.
+
+    Between substeps the tree is refitted rather than rebuilt, see UpdateTree.
+    Each build fits the root cube to the particles, the few which escape far
+    from the rest (see Morton::FitBounds) stay out of the tree and are summed
+    directly.
+*/
 class BarnesHut : public INBodySim
 {
     public:
@@ -15,26 +36,79 @@ class BarnesHut : public INBodySim
 
         void Init(std::vector<Particle>& particles) final;
         void Update(float dt) final;
+        void SyncParticles() final;
+        TaskScheduler* GetScheduler() final { return &Scheduler; }
+#ifndef NBODY_HEADLESS
         void RenderDebug(DirectX::SimpleMath::Matrix view, DirectX::SimpleMath::Matrix proj);
+#endif
+
+        // Fraction of the particles which may change leaf through refits before the tree is rebuilt
+        static std::atomic<float> RebuildThreshold;
+
+        size_t GetRebuilds() const { return Rebuilds; }
+        size_t GetRefits() const { return Refits; }
+
+        // Splits costs into numZones contiguous runs, zones[z] to zones[z + 1] being run z. A run closes
+        // once the running sum reaches its share of the total, so no run exceeds its share by more than one cost
+        static void PartitionCosts(const std::vector<uint64_t>& costs, size_t numZones, std::vector<size_t>& zones);
 
     private:
         BoundingCube Bounds;
 
-        std::unique_ptr<Octree> Tree;
+        LinearOctree Tree;
+        MortonSorter Sorter;
+        ParticleStore Store;
         std::vector<Particle>* Particles;
 
         ID3D11DeviceContext* Context;
 
-        struct ParticleInfo
+        TaskScheduler Scheduler;
+        BlockTimestep Steps;
+
+        static const uint32_t LeafSize = 32;
+        static const int ReportInterval = 100;
+
+        // Per thread buffers for the interaction lists of one leaf
+        struct Interactions
         {
-            size_t Index;
-            size_t Loops;
+            std::vector<uint32_t> Cells, Leaves, Targets;
+            std::vector<float> X, Y, Z, Mass;
+            std::vector<float> TargetX, TargetY, TargetZ;
+            std::vector<double> ForceX, ForceY, ForceZ;
         };
 
-        CThreadPool<ParticleInfo> Pool;
-        
+        Kernels::GravityKernel Kernel;
+        std::vector<Interactions> Scratch;
+        // Every leaf of the last build in Morton order, and those of them holding particles
+        std::vector<uint32_t> TreeLeaves;
+        std::vector<uint32_t> Leaves;
+
+        // Cost zones, Zones[z] to Zones[z + 1] are the leaves of zone z, one zone per thread
+        std::vector<uint64_t> LeafCosts;
+        std::vector<size_t> Zones;
+
+        // Per thread time in force passes since the last report and the passes' total wall time, in ms
+        std::vector<double> ThreadBusy;
+        double ForceWall = 0.0;
+        size_t NumInside = 0;
+
+        // Escaped particles of the last build, logged when it changes
+        uint32_t NumEscaped = 0;
+        double MassScale = 1.0;
+
+        bool TreeBuilt = false;
+        size_t MovedSinceBuild = 0;
+        size_t Rebuilds = 0, Refits = 0;
+        int Frames = 0;
+
+#ifndef NBODY_HEADLESS
         std::unique_ptr<Cube> DebugCube;
         std::unique_ptr<DirectX::GeometricPrimitive> DebugSphere;
+#endif
 
-        void Exec(const ParticleInfo& info);
+        void UpdateTree();
+        void PartitionZones();
+        void Report();
+        void Exec(size_t begin, size_t end, uint32_t thread);
+        void ExecLeaf(uint32_t leaf, Interactions& list);
 };
\ No newline at end of file
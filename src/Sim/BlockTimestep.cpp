@@ -0,0 +1,203 @@
+#include "BlockTimestep.hpp"
+#include "Physics.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+double BlockTimestep::Accuracy = 0.025;
+
+void BlockTimestep::Reset()
+{
+    Started = false;
+    Substep = 0;
+    LevelCounts.fill(0);
+}
+
+void BlockTimestep::Begin(ParticleStore& store, double dt)
+{
+    // Everything is in sync between steps, so a new dt only needs the opening half kicks redone
+    if(Started && dt != Dt)
+    {
+        const double change = (dt - Dt) / 2;
+
+        ParallelFor(Scheduler, store.Size(), [&](size_t begin, size_t end, uint32_t) {
+            for(size_t i = begin; i < end; ++i)
+            {
+                double h = change / (1 << store.Level[i]) / store.Mass[i];
+
+                store.VelX[i] += store.ForceX[i] * h;
+                store.VelY[i] += store.ForceY[i] * h;
+                store.VelZ[i] += store.ForceZ[i] * h;
+            }
+        }, ParticleStore::StreamGrain);
+    }
+
+    Dt = dt;
+    Substep = 0;
+    ForceEvaluations = 0;
+}
+
+bool BlockTimestep::NextSubstep(ParticleStore& store)
+{
+    // The first substep of the first step only opens every particle's step
+    if(!Started)
+        return true;
+
+    if(Substep >= NumSubsteps)
+        return false;
+
+    int finest = 0;
+
+    for(int level = 0; level <= MaxLevel; ++level)
+    {
+        if(LevelCounts[level] > 0)
+            finest = level;
+    }
+
+    uint32_t stride = Stride(finest);
+    uint32_t next = (Substep / stride + 1) * stride;
+
+    Drift(store, (next - Substep) * StepLength(MaxLevel));
+    Substep = next;
+
+    return true;
+}
+
+const std::vector<uint32_t>& BlockTimestep::FindActive(const ParticleStore& store)
+{
+    // Counts per chunk then writes each chunk's particles from its offset, keeps the store order
+    const size_t numChunks = (std::min)(static_cast<size_t>(Scheduler.GetNumThreads()) * 4,
+                                        (store.Size() + ParticleStore::StreamGrain - 1) / ParticleStore::StreamGrain);
+
+    ChunkActive.assign(numChunks + 1, 0);
+
+    ForEachChunk(Scheduler, store.Size(), numChunks, [&](size_t chunk, size_t begin, size_t end) {
+        size_t count = 0;
+
+        for(size_t i = begin; i < end; ++i)
+            count += IsActive(store, i) ? 1 : 0;
+
+        ChunkActive[chunk + 1] = count;
+    });
+
+    for(size_t chunk = 0; chunk < numChunks; ++chunk)
+        ChunkActive[chunk + 1] += ChunkActive[chunk];
+
+    Active.resize(ChunkActive[numChunks]);
+
+    ForEachChunk(Scheduler, store.Size(), numChunks, [&](size_t chunk, size_t begin, size_t end) {
+        uint32_t* out = Active.data() + ChunkActive[chunk];
+
+        for(size_t i = begin; i < end; ++i)
+        {
+            if(IsActive(store, i))
+                *out++ = static_cast<uint32_t>(i);
+        }
+    });
+
+    ForceEvaluations += Active.size();
+
+    return Active;
+}
+
+void BlockTimestep::Kick(ParticleStore& store)
+{
+    ThreadLevels.resize(Scheduler.GetNumThreads());
+
+    for(auto& levels : ThreadLevels)
+    {
+        levels.Opened.fill(0);
+        levels.Closed.fill(0);
+    }
+
+    ParallelFor(Scheduler, Active.size(), [&](size_t begin, size_t end, uint32_t thread) {
+        LevelChanges& levels = ThreadLevels[thread];
+
+        for(size_t a = begin; a < end; ++a)
+        {
+            const uint32_t i = Active[a];
+            const int level = store.Level[i];
+
+            double ax = store.ForceX[i] / store.Mass[i];
+            double ay = store.ForceY[i] / store.Mass[i];
+            double az = store.ForceZ[i] / store.Mass[i];
+
+            // Closing half of the step which ends here
+            if(Started)
+            {
+                double h = StepLength(level) / 2;
+
+                store.VelX[i] += ax * h;
+                store.VelY[i] += ay * h;
+                store.VelZ[i] += az * h;
+
+                ++levels.Closed[level];
+            }
+
+            // A coarser level has to start on one of its own step boundaries
+            int next = ChooseLevel(store, i);
+
+            while(Substep % Stride(next) != 0)
+                ++next;
+
+            double h = StepLength(next) / 2;
+
+            store.VelX[i] += ax * h;
+            store.VelY[i] += ay * h;
+            store.VelZ[i] += az * h;
+
+            store.Level[i] = static_cast<uint8_t>(next);
+            ++levels.Opened[next];
+        }
+    }, ParticleStore::StreamGrain / 4);
+
+    for(const auto& levels : ThreadLevels)
+    {
+        for(int level = 0; level <= MaxLevel; ++level)
+        {
+            LevelCounts[level] += levels.Opened[level];
+            LevelCounts[level] -= levels.Closed[level];
+        }
+    }
+
+    Started = true;
+}
+
+int BlockTimestep::ChooseLevel(const ParticleStore& store, size_t i) const
+{
+    // Positions are in units of StarSystemScale, so is the softening length
+    const double softening = std::sqrt(Phys::S) * Phys::StarSystemScale;
+
+    double fx = store.ForceX[i], fy = store.ForceY[i], fz = store.ForceZ[i];
+    double accel = std::sqrt(fx * fx + fy * fy + fz * fz) / store.Mass[i];
+
+    if(accel <= 0.0 || Dt <= 0.0)
+        return 0;
+
+    double step = Accuracy * std::sqrt(softening / accel);
+    int level = static_cast<int>(std::ceil(std::log2(Dt / step)));
+
+    return (std::max)(0, (std::min)(level, MaxLevel));
+}
+
+void BlockTimestep::Drift(ParticleStore& store, double time)
+{
+    // Positions are in units of StarSystemScale
+    const double scale = time / Phys::StarSystemScale;
+
+    ParallelFor(Scheduler, store.Size(), [&](size_t begin, size_t end, uint32_t) {
+        float* posX = store.PosX.data();
+        float* posY = store.PosY.data();
+        float* posZ = store.PosZ.data();
+        const double* velX = store.VelX.data();
+        const double* velY = store.VelY.data();
+        const double* velZ = store.VelZ.data();
+
+        for(size_t i = begin; i < end; ++i)
+        {
+            posX[i] += static_cast<float>(velX[i] * scale);
+            posY[i] += static_cast<float>(velY[i] * scale);
+            posZ[i] += static_cast<float>(velZ[i] * scale);
+        }
+    }, ParticleStore::StreamGrain);
+}
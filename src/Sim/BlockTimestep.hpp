@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+#include "ParticleStore.hpp"
+#include "Core/TaskScheduler.hpp"
+
+/*
+    Kick-drift-kick leapfrog with a power of two timestep per particle.
+    A step of dt is split into 2^MaxLevel substeps, a particle on level L
+    takes steps of dt / 2^L so it only needs a new force on the substeps
+    where its step ends. Every particle is in sync again at the end of dt.
+
+    Each step is driven by the simulation as
+        Begin(store, dt);
+        while(NextSubstep(store))
+        {
+            // forces for every particle in FindActive(store)
+            Kick(store);
+        }
+    The store may be reordered before FindActive, levels move with the particles.
+    Drifts, kicks and the active scan are split over the simulation's scheduler.
+*/
+class BlockTimestep
+{
+    public:
+        // Finest level, particles can step up to 2^MaxLevel times per dt
+        static const int MaxLevel = 6;
+
+        // Timestep factor in dt_i = Accuracy * sqrt(SofteningLength / |a_i|)
+        static double Accuracy;
+
+        explicit BlockTimestep(TaskScheduler& scheduler) : Scheduler(scheduler) {}
+
+        // Forgets the levels and open steps, for a newly loaded store
+        void Reset();
+
+        void Begin(ParticleStore& store, double dt);
+
+        // Drifts every particle up to the next substep with active particles, false once dt is done
+        bool NextSubstep(ParticleStore& store);
+
+        const std::vector<uint32_t>& FindActive(const ParticleStore& store);
+
+        // Closes the active particles' steps with their new forces, picks their next level and opens it
+        void Kick(ParticleStore& store);
+
+        bool IsActive(const ParticleStore& store, size_t i) const
+        {
+            return !Started || Substep % Stride(store.Level[i]) == 0;
+        }
+
+        // Force evaluations over the last step, against NumParticles * substeps for a global dt
+        size_t GetForceEvaluations() const { return ForceEvaluations; }
+
+    private:
+        static const uint32_t NumSubsteps = 1 << MaxLevel;
+
+        static uint32_t Stride(int level) { return NumSubsteps >> level; }
+
+        double StepLength(int level) const { return Dt / (1 << level); }
+        int ChooseLevel(const ParticleStore& store, size_t i) const;
+        void Drift(ParticleStore& store, double time);
+
+        TaskScheduler& Scheduler;
+
+        bool Started = false;
+        double Dt = 0.0;
+        uint32_t Substep = 0;
+        size_t ForceEvaluations = 0;
+
+        std::array<size_t, MaxLevel + 1> LevelCounts = {};
+        std::vector<uint32_t> Active;
+
+        // Scratch for the parallel passes, active particles per chunk and level changes per thread
+        std::vector<size_t> ChunkActive;
+
+        struct LevelChanges
+        {
+            std::array<size_t, MaxLevel + 1> Opened, Closed;
+        };
+
+        std::vector<LevelChanges> ThreadLevels;
+};
@@ -2,73 +2,225 @@
 #include "Physics.hpp"
 #include "Core/Vec3.hpp"
 #include "Services/Log.hpp"
-#include "Render/DX/Shader.hpp"
 
 #include <stdlib.h>
 #include <thread>
 #include <array>
+#include <cmath>
+#include <string>
+#include <algorithm>
 
 using namespace DirectX::SimpleMath;
 
-BruteForceCPU::BruteForceCPU(ID3D11DeviceContext* context)
-    : Context(context),
-      Pool(std::bind(&BruteForceCPU::Exec, this, std::placeholders::_1))
+template <class Law>
+BruteForceCPUSim<Law>::BruteForceCPUSim(ID3D11DeviceContext* context)
+    : Context(context), Steps(Scheduler)
 {
-    LOGM("Brute Force CPU")
+    LOGM("Brute Force CPU (" + std::string(Law::GetName()) + ", " + Phys::GetPrecisionName<Real>() + ")")
 }
 
-void BruteForceCPU::Init(std::vector<Particle>& particles)
+template <class Law>
+void BruteForceCPUSim<Law>::Init(std::vector<Particle>& particles)
 {
     Particles = &particles;
+    Store.Load(particles);
+    Steps.Reset();
+
+    MassScale = 1.0;
+
+    for(double mass : Store.Mass)
+        MassScale = (std::max)(MassScale, mass);
+
+    ScaledMass.resize(Store.Size());
+
+    for(size_t i = 0; i < Store.Size(); ++i)
+        ScaledMass[i] = static_cast<Real>(Store.Mass[i] / MassScale);
+
+    const uint32_t numTiles = static_cast<uint32_t>((Store.Size() + TileSize - 1) / TileSize);
+
+    // Row major so consecutive pairs in a chunk keep tile A in cache
+    TilePairs.clear();
+
+    for(uint32_t a = 0; a < numTiles; ++a)
+        for(uint32_t b = a; b < numTiles; ++b)
+            TilePairs.push_back({ a, b });
+
+    Accumulators.resize(Scheduler.GetNumThreads());
+
+    for(auto& acc : Accumulators)
+    {
+        acc.X.assign(Store.Size(), Real(0));
+        acc.Y.assign(Store.Size(), Real(0));
+        acc.Z.assign(Store.Size(), Real(0));
+    }
 }
 
-void BruteForceCPU::Exec(const ParticleInfo& info)
+template <class Law>
+void BruteForceCPUSim<Law>::ExecTile(const TilePair& tile, ForceAccumulator& acc)
 {
-    for(size_t i = info.Index * info.Loops; i < (info.Index + 1) * info.Loops; ++i)
+    const size_t num = Store.Size();
+
+    const size_t beginA = static_cast<size_t>(tile.A) * TileSize;
+    const size_t endA = (std::min)(beginA + TileSize, num);
+    const size_t beginB = static_cast<size_t>(tile.B) * TileSize;
+    const size_t endB = (std::min)(beginB + TileSize, num);
+
+    for(size_t i = beginA; i < endA; ++i)
     {
-        for(size_t j = 0; j < Particles->size(); ++j)
+        const Real xi = Store.PosX[i];
+        const Real yi = Store.PosY[i];
+        const Real zi = Store.PosZ[i];
+        const Real mi = ScaledMass[i];
+
+        Real fx = 0, fy = 0, fz = 0;
+
+        // Diagonal tiles only take the upper triangle so each pair is seen once
+        for(size_t j = (tile.A == tile.B ? i + 1 : beginB); j < endB; ++j)
         {
-            if(i == j) continue;
-            
-            auto& a = (*Particles)[j];
-            auto& b = (*Particles)[i];
+            Real dx = xi - Store.PosX[j];
+            Real dy = yi - Store.PosY[j];
+            Real dz = zi - Store.PosZ[j];
+
+            Real d2 = dx * dx + dy * dy + dz * dz;
+            if(d2 <= Real(0)) continue;
+
+            // Each side's sum takes the other's mass, its own is applied in Reduce
+            Real k = Law::Kernel(d2);
+            Real kj = ScaledMass[j] * k;
+            Real ki = mi * k;
+
+            fx += kj * dx;
+            fy += kj * dy;
+            fz += kj * dz;
+
+            acc.X[j] -= ki * dx;
+            acc.Y[j] -= ki * dy;
+            acc.Z[j] -= ki * dz;
+        }
+
+        acc.X[i] += fx;
+        acc.Y[i] += fy;
+        acc.Z[i] += fz;
+    }
+}
+
+template <class Law>
+void BruteForceCPUSim<Law>::Exec(size_t begin, size_t end, uint32_t thread)
+{
+    ForceAccumulator& acc = Accumulators[thread];
+
+    for(size_t t = begin; t < end; ++t)
+        ExecTile(TilePairs[t], acc);
+}
+
+template <class Law>
+void BruteForceCPUSim<Law>::Reduce(size_t begin, size_t end)
+{
+    for(size_t i = begin; i < end; ++i)
+    {
+        Vec3d force;
 
-            auto diff = (b.Position - a.Position);
-            diff.Normalize();
+        for(auto& acc : Accumulators)
+        {
+            force += Vec3d(acc.X[i], acc.Y[i], acc.Z[i]);
 
-            double f = Phys::Gravity(a, b);
-            b.Forces += Vec3d(f * diff.x, f * diff.y, f * diff.z);
+            acc.X[i] = Real(0);
+            acc.Y[i] = Real(0);
+            acc.Z[i] = Real(0);
         }
+
+        const double scale = -Phys::G * Store.Mass[i] * MassScale;
+
+        Store.ForceX[i] = force.x * scale;
+        Store.ForceY[i] = force.y * scale;
+        Store.ForceZ[i] = force.z * scale;
     }
 }
 
-void BruteForceCPU::Update(float dt)
+template <class Law>
+void BruteForceCPUSim<Law>::ExecActive(const std::vector<uint32_t>& active, size_t begin, size_t end)
 {
-    const size_t numThreads = Pool.GetNumWorkers();
-    const size_t loopsPerThread = Particles->size() / numThreads;
-    const size_t remainder = Particles->size() % numThreads;
+    const size_t num = Store.Size();
+
+    for(size_t a = begin; a < end; ++a)
+    {
+        const uint32_t i = active[a];
 
-    uint32_t thread;
+        const Real xi = Store.PosX[i];
+        const Real yi = Store.PosY[i];
+        const Real zi = Store.PosZ[i];
+
+        Real fx = 0, fy = 0, fz = 0;
+
+        for(size_t j = 0; j < num; ++j)
+        {
+            Real dx = xi - Store.PosX[j];
+            Real dy = yi - Store.PosY[j];
+            Real dz = zi - Store.PosZ[j];
+
+            Real d2 = dx * dx + dy * dy + dz * dz;
+            if(d2 <= Real(0)) continue;
+
+            Real k = ScaledMass[j] * Law::Kernel(d2);
+
+            fx += k * dx;
+            fy += k * dy;
+            fz += k * dz;
+        }
 
-    for (thread = 0; thread < numThreads; ++thread)
-        Pool.Dispatch(thread, { thread, loopsPerThread });
+        const double scale = -Phys::G * Store.Mass[i] * MassScale;
 
-    if(remainder > 0)
-        Exec({ thread, remainder });
+        Store.ForceX[i] = fx * scale;
+        Store.ForceY[i] = fy * scale;
+        Store.ForceZ[i] = fz * scale;
+    }
+}
 
-    Pool.Join();
+template <class Law>
+void BruteForceCPUSim<Law>::Update(float dt)
+{
+    Steps.Begin(Store, dt);
 
-    for(int i = 0; i < Particles->size(); ++i)
+    while(Steps.NextSubstep(Store))
     {
-        auto a = (*Particles)[i].Forces / (*Particles)[i].Mass;
-        (*Particles)[i].Velocity += a * dt;
+        const auto& active = Steps.FindActive(Store);
 
-        auto vel = ((*Particles)[i].Velocity * dt) / Phys::StarSystemScale;
+        // Pairs are only worth sharing when both sides need the force
+        if(active.size() == Store.Size())
+        {
+            ParallelFor(Scheduler, TilePairs.size(), [this](size_t begin, size_t end, uint32_t thread) {
+                Exec(begin, end, thread);
+            });
+
+            // Clears the accumulators for the next step on the way
+            ParallelFor(Scheduler, Store.Size(), [this](size_t begin, size_t end, uint32_t) {
+                Reduce(begin, end);
+            });
+        }
+        else
+        {
+            ParallelFor(Scheduler, active.size(), [this, &active](size_t begin, size_t end, uint32_t) {
+                ExecActive(active, begin, end);
+            });
+        }
 
-        (*Particles)[i].Position += Vector3(static_cast<float>(vel.x),
-                                            static_cast<float>(vel.y),
-                                            static_cast<float>(vel.z));
-        
-        (*Particles)[i].Forces = Vec3d();
+        Steps.Kick(Store);
     }
-}
\ No newline at end of file
+
+    ParallelFor(Scheduler, Store.Size(), [this](size_t begin, size_t end, uint32_t) {
+        Store.ProjectPositions(*Particles, begin, end);
+    }, ParticleStore::StreamGrain);
+}
+
+template <class Law>
+void BruteForceCPUSim<Law>::SyncParticles()
+{
+    Store.Project(*Particles, 0, Store.Size());
+}
+
+template class BruteForceCPUSim<Phys::Plummer<double>>;
+template class BruteForceCPUSim<Phys::Plummer<float>>;
+template class BruteForceCPUSim<Phys::Spline<double>>;
+template class BruteForceCPUSim<Phys::Spline<float>>;
+template class BruteForceCPUSim<Phys::Unsoftened<double>>;
+template class BruteForceCPUSim<Phys::Unsoftened<float>>;
@@ -1,30 +1,67 @@
 #pragma once
 
 #include "INBodySim.hpp"
-#include "Core/ThreadPool.hpp"
-#include "Render/DX/ConstantBuffer.hpp"
+#include "ParticleStore.hpp"
+#include "Core/TaskScheduler.hpp"
+#include "BlockTimestep.hpp"
+#include "GravityPolicy.hpp"
 
-#include <wrl/client.h>
+/*
+    All-pairs gravity over tiles of TileSize particles. Each tile pair is
+    visited once and every interaction is applied to both bodies, so the
+    per-thread accumulators are summed into the store after the pass.
+    Substeps with only some particles active sum onto those directly.
 
-class BruteForceCPU : public INBodySim
+    Law is one of the force laws in GravityPolicy.hpp, its kernel is inlined
+    into the pair loops and its Real sets the precision of the sums. Masses are
+    divided by the largest one so float sums stay in range, G and the target's
+    own mass are applied once per particle after the sum.
+*/
+template <class Law>
+class BruteForceCPUSim : public INBodySim
 {
     public:
-        BruteForceCPU(ID3D11DeviceContext* context);
+        using Real = typename Law::Real;
+
+        BruteForceCPUSim(ID3D11DeviceContext* context);
 
         void Init(std::vector<Particle>& particles) final;
         void Update(float dt) final;
+        void SyncParticles() final;
+        TaskScheduler* GetScheduler() final { return &Scheduler; }
 
     private:
         ID3D11DeviceContext* Context = nullptr;
 
-        struct ParticleInfo
+        std::vector<Particle>* Particles;
+        ParticleStore Store;
+        TaskScheduler Scheduler;
+        BlockTimestep Steps;
+
+        // 256 particles of position and mass plus their force sums fit comfortably in L1
+        static const uint32_t TileSize = 256;
+
+        struct TilePair
         {
-            size_t Index;
-            size_t Loops;
+            uint32_t A, B;
         };
 
-        std::vector<Particle>* Particles;
-        CThreadPool<ParticleInfo> Pool;
+        struct ForceAccumulator
+        {
+            std::vector<Real> X, Y, Z;
+        };
+
+        std::vector<TilePair> TilePairs;
+        std::vector<ForceAccumulator> Accumulators;
+
+        std::vector<Real> ScaledMass;
+        double MassScale = 1.0;
+
+        void Exec(size_t begin, size_t end, uint32_t thread);
+        void ExecTile(const TilePair& tile, ForceAccumulator& acc);
+        void Reduce(size_t begin, size_t end);
+        void ExecActive(const std::vector<uint32_t>& active, size_t begin, size_t end);
+};
 
-        void Exec(const ParticleInfo& info);
-};
\ No newline at end of file
+// Instantiated in BruteForceCPU.cpp for every law in float and double
+using BruteForceCPU = BruteForceCPUSim<Phys::Plummer<double>>;
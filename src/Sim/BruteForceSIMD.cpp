@@ -0,0 +1,79 @@
+#include "BruteForceSIMD.hpp"
+#include "Physics.hpp"
+#include "Services/Log.hpp"
+
+#include <algorithm>
+
+BruteForceSIMD::BruteForceSIMD(ID3D11DeviceContext* context)
+    : Context(context)
+{
+    std::string name;
+    Kernel = Kernels::SelectGravityKernel(&name);
+
+    LOGM("Brute Force SIMD (" + name + ")")
+}
+
+void BruteForceSIMD::Init(std::vector<Particle>& particles)
+{
+    Particles = &particles;
+    Store.Load(particles);
+
+    // Masses go up to 1e30 which would overflow the float sums, so scale them to at most 1
+    MassScale = 1.0;
+
+    for(double mass : Store.Mass)
+        MassScale = (std::max)(MassScale, mass);
+
+    ScaledMass.resize(Store.Size());
+
+    for(size_t i = 0; i < Store.Size(); ++i)
+        ScaledMass[i] = static_cast<float>(Store.Mass[i] / MassScale);
+}
+
+void BruteForceSIMD::Exec(size_t begin, size_t end)
+{
+    Kernels::GravitySources sources = {
+        Store.PosX.data(),
+        Store.PosY.data(),
+        Store.PosZ.data(),
+        ScaledMass.data(),
+        Store.Size(),
+        static_cast<float>(Phys::S)
+    };
+
+    Kernels::GravityTargets targets = {
+        Store.PosX.data() + begin,
+        Store.PosY.data() + begin,
+        Store.PosZ.data() + begin,
+        end - begin
+    };
+
+    Kernel(sources, targets, Store.ForceX.data() + begin, Store.ForceY.data() + begin, Store.ForceZ.data() + begin);
+
+    for(size_t i = begin; i < end; ++i)
+    {
+        double scale = -Phys::G * Store.Mass[i] * MassScale;
+
+        Store.ForceX[i] *= scale;
+        Store.ForceY[i] *= scale;
+        Store.ForceZ[i] *= scale;
+    }
+}
+
+void BruteForceSIMD::Update(float dt)
+{
+    ParallelFor(Scheduler, Store.Size(), [this](size_t begin, size_t end, uint32_t) {
+        Exec(begin, end);
+    });
+
+    // Every force was written above, so the step and the write back share one pass
+    ParallelFor(Scheduler, Store.Size(), [this, dt](size_t begin, size_t end, uint32_t) {
+        Store.Integrate(dt, begin, end);
+        Store.ProjectPositions(*Particles, begin, end);
+    }, ParticleStore::StreamGrain);
+}
+
+void BruteForceSIMD::SyncParticles()
+{
+    Store.Project(*Particles, 0, Store.Size());
+}
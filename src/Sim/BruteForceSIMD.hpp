@@ -0,0 +1,34 @@
+#pragma once
+
+#include "INBodySim.hpp"
+#include "ParticleStore.hpp"
+#include "Kernels/Gravity.hpp"
+#include "Core/TaskScheduler.hpp"
+
+/*
+    Same all-pairs gravity as BruteForceCPU, evaluated 8 or 16 source
+    particles at a time with the widest kernel the CPU supports.
+*/
+class BruteForceSIMD : public INBodySim
+{
+    public:
+        BruteForceSIMD(ID3D11DeviceContext* context);
+
+        void Init(std::vector<Particle>& particles) final;
+        void Update(float dt) final;
+        void SyncParticles() final;
+        TaskScheduler* GetScheduler() final { return &Scheduler; }
+
+    private:
+        ID3D11DeviceContext* Context = nullptr;
+
+        std::vector<Particle>* Particles;
+        ParticleStore Store;
+        TaskScheduler Scheduler;
+
+        Kernels::GravityKernel Kernel;
+        std::vector<float> ScaledMass;
+        double MassScale = 1.0;
+
+        void Exec(size_t begin, size_t end);
+};
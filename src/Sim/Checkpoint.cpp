@@ -0,0 +1,197 @@
+#include "Checkpoint.hpp"
+#include "ParticleFile.hpp"
+#include "Services/Log.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    std::string DataPath(const std::string& name)
+    {
+        return std::string(ParticleFile::Directory) + "/" + name;
+    }
+
+    std::string ManifestName(const std::string& name)
+    {
+        return name + ".ckpt";
+    }
+
+    // Replaces to with from, rename won't overwrite on every platform
+    bool Replace(const std::string& from, const std::string& to)
+    {
+        std::remove(to.c_str());
+        return std::rename(from.c_str(), to.c_str()) == 0;
+    }
+}
+
+Checkpointer::Checkpointer(const std::string& name, size_t numParticles)
+    : Name(name),
+      Buffer(numParticles),
+      Manifest(ReadManifest(name))
+{
+    // Carry on after the newest slot of a resumed run rather than overwrite it
+    if(!Manifest.empty() && Manifest.front().File == ManifestName(Name) + ".0.nbody")
+        Slot = 1;
+
+    Thread = std::thread(&Checkpointer::Run, this);
+}
+
+Checkpointer::~Checkpointer()
+{
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        Stopping = true;
+    }
+
+    Changed.notify_all();
+    Thread.join();
+}
+
+bool Checkpointer::Take(const std::vector<Particle>& particles, int64_t step)
+{
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+
+        if(Pending)
+        {
+            LOGW("Skipped the checkpoint at step " + std::to_string(step) + ", the last one is still being written")
+            return false;
+        }
+    }
+
+    // The writer only touches Buffer while Pending is set, the size matches so this never allocates
+    Buffer.assign(particles.begin(), particles.end());
+
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        PendingStep = step;
+        Pending = true;
+    }
+
+    Changed.notify_all();
+
+    return true;
+}
+
+bool Checkpointer::Flush()
+{
+    std::unique_lock<std::mutex> lock(Mutex);
+    Changed.wait(lock, [this]() { return !Pending; });
+
+    return !Failed;
+}
+
+void Checkpointer::Run()
+{
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(Mutex);
+            Changed.wait(lock, [this]() { return Pending || Stopping; });
+
+            if(!Pending)
+                return;
+        }
+
+        bool ok = Write();
+
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            Failed |= !ok;
+            Pending = false;
+        }
+
+        Changed.notify_all();
+    }
+}
+
+bool Checkpointer::Write()
+{
+    const std::string file = ManifestName(Name) + "." + std::to_string(Slot) + ".nbody";
+
+    // Off the manifest before it is overwritten, so a crash mid write never leaves it listed
+    for(auto it = Manifest.begin(); it != Manifest.end();)
+        it = it->File == file ? Manifest.erase(it) : it + 1;
+
+    if(!WriteManifest() || !ParticleFile::Save(file, Buffer, WriteScheduler))
+    {
+        LOGE("Failed to write checkpoint " + file)
+        return false;
+    }
+
+    Manifest.insert(Manifest.begin(), Entry { file, PendingStep });
+
+    if(!WriteManifest())
+    {
+        LOGE("Failed to write checkpoint manifest for " + Name)
+        return false;
+    }
+
+    LOGM("Checkpointed step " + std::to_string(PendingStep) + " to " + DataPath(file))
+
+    Slot ^= 1;
+
+    return true;
+}
+
+bool Checkpointer::WriteManifest() const
+{
+    const std::string path = DataPath(ManifestName(Name));
+
+    {
+        std::ofstream out(path + ".tmp", std::ios::trunc);
+
+        for(const auto& entry : Manifest)
+            out << entry.File << " " << entry.Step << "\n";
+
+        if(!out)
+            return false;
+    }
+
+    return Replace(path + ".tmp", path);
+}
+
+std::vector<Checkpointer::Entry> Checkpointer::ReadManifest(const std::string& name)
+{
+    const std::string path = DataPath(ManifestName(name));
+
+    std::ifstream in(path);
+
+    // A run killed between removing the manifest and renaming the new one over it
+    if(!in.is_open())
+        in.open(path + ".tmp");
+
+    std::vector<Entry> entries;
+    std::string line;
+
+    while(std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        Entry entry;
+
+        if(fields >> entry.File >> entry.Step)
+            entries.push_back(entry);
+    }
+
+    return entries;
+}
+
+bool Checkpointer::Resume(const std::string& name, std::vector<Particle>& particles, int64_t& step)
+{
+    for(const auto& entry : ReadManifest(name))
+    {
+        if(ParticleFile::Load(entry.File, particles, false))
+        {
+            step = entry.Step;
+            LOGM("Resuming from " + DataPath(entry.File) + " at step " + std::to_string(step))
+            return true;
+        }
+
+        LOGW("Checkpoint " + DataPath(entry.File) + " can't be read, trying an older one")
+    }
+
+    LOGE("No checkpoint to resume " + name + " from")
+    return false;
+}
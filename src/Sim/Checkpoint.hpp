@@ -0,0 +1,76 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
+
+#include "Core/TaskScheduler.hpp"
+#include "Render/Misc/Particle.hpp"
+
+/*
+    Periodic snapshots of a long run so it can be resumed after a crash or
+    kill. Take copies the particles into a buffer allocated up front and
+    returns, a background thread writes it as a particle file on its own,
+    without spreading over the cores the simulation is using, so the
+    simulation only pays for the copy. A checkpoint asked for while the last
+    one is still being written is skipped rather than waited for.
+
+    Checkpoints alternate between two files next to a small manifest listing
+    the complete ones newest first. The slot about to be overwritten is taken
+    off the manifest first, so whatever point a run dies at the manifest only
+    names complete files.
+
+    data/<name>.ckpt             manifest, "<file> <step>" a line
+    data/<name>.ckpt.<0|1>.nbody checkpoints
+*/
+class Checkpointer
+{
+public:
+    Checkpointer(const std::string& name, size_t numParticles);
+    ~Checkpointer();
+
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    // Queues a checkpoint of particles after step steps, false if the last one is still being written
+    bool Take(const std::vector<Particle>& particles, int64_t step);
+
+    // Blocks until the queued checkpoint is written, false if any write failed
+    bool Flush();
+
+    // Loads the newest checkpoint which reads back, without moving it to the centre of mass
+    static bool Resume(const std::string& name, std::vector<Particle>& particles, int64_t& step);
+
+private:
+    struct Entry
+    {
+        std::string File;
+        int64_t Step;
+    };
+
+    void Run();
+    bool Write();
+    bool WriteManifest() const;
+
+    static std::vector<Entry> ReadManifest(const std::string& name);
+
+    std::string Name;
+    std::vector<Particle> Buffer;
+    std::vector<Entry> Manifest;
+
+    int64_t PendingStep = 0;
+    int Slot = 0;
+
+    // A single thread scheduler runs everything on the writer thread
+    TaskScheduler WriteScheduler{ 1 };
+
+    std::thread Thread;
+    std::mutex Mutex;
+    std::condition_variable Changed;
+    bool Pending = false;
+    bool Stopping = false;
+    bool Failed = false;
+};
@@ -0,0 +1,569 @@
+#include "FastMultipole.hpp"
+#include "Services/Log.hpp"
+#include "Sim/Physics.hpp"
+#include "Core/Event.hpp"
+
+#include <cmath>
+#include <chrono>
+#include <sstream>
+#include <algorithm>
+
+std::atomic<int> FastMultipole::Order(4);
+std::atomic<bool> FastMultipole::MixedPrecision(false);
+
+namespace
+{
+    // Two nodes interact through their expansions when (r_a + r_b) < OpeningAngle * distance
+    const double OpeningAngle = 0.8;
+
+    // Target leaves sum a well separated source directly when they have fewer than
+    // DirectCost * coefficients particle pairs, an M2L costs about that many interactions
+    const size_t DirectCost = 4;
+
+    // Nodes closer than this to each other are summed directly, their expansions of the softened
+    // potential would stop its series too early (see MultipoleExpansion::GetSeriesError)
+    const double MaxSeriesError = 1e-6;
+
+    typedef std::chrono::high_resolution_clock Clock;
+
+    double Milliseconds(Clock::time_point start, Clock::time_point end)
+    {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    inline double Length(const Vec3d& v)
+    {
+        return std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+    }
+}
+
+void FastMultipole::InteractionList::Build(const std::vector<NodePair>& pairs, size_t numNodes)
+{
+    Offsets.assign(numNodes + 1, 0);
+    Sources.resize(pairs.size());
+
+    for(const auto& pair : pairs)
+        ++Offsets[pair.Target + 1];
+
+    for(size_t i = 0; i < numNodes; ++i)
+        Offsets[i + 1] += Offsets[i];
+
+    // Offsets[t] is used as the write cursor and ends up at the start of t + 1, shift it back after
+    for(const auto& pair : pairs)
+        Sources[Offsets[pair.Target]++] = pair.Source;
+
+    for(size_t i = numNodes; i > 0; --i)
+        Offsets[i] = Offsets[i - 1];
+
+    Offsets[0] = 0;
+}
+
+FastMultipole::FastMultipole(ID3D11DeviceContext* context)
+    : Expansion(Order),
+      Context(context)
+{
+    // Same law as the direct sums, Phys::Gravity and the kernels
+    Expansion.SetSoftening(Phys::S);
+
+    std::string kernelName;
+    Kernel = Kernels::SelectGravityKernel(&kernelName);
+
+    LOGM("Fast Multipole (order " + std::to_string(Order) + ", " + (MixedPrecision ? "mixed " + kernelName : "double") + " P2P)")
+
+#ifndef NBODY_HEADLESS
+    if(context)
+    {
+        DebugCube = std::make_unique<Cube>(context);
+        DebugSphere = DirectX::GeometricPrimitive::CreateSphere(context);
+    }
+#endif
+
+    EventStream::Register(EEvent::FMMOrderChanged, [&](const EventData& data) {
+        Order = EventValue<IntEventData>(data);
+    });
+
+    EventStream::Register(EEvent::FMMMixedPrecisionChanged, [&](const EventData& data) {
+        MixedPrecision = EventValue<BoolEventData>(data);
+    });
+}
+
+FastMultipole::~FastMultipole()
+{
+    EventStream::UnregisterAll(EEvent::FMMOrderChanged);
+    EventStream::UnregisterAll(EEvent::FMMMixedPrecisionChanged);
+}
+
+void FastMultipole::Init(std::vector<Particle>& particles)
+{
+    Particles = &particles;
+    Store.Load(particles);
+
+    // Same as BruteForceSIMD, keeps the kernel's float mass sums in range
+    MassScale = 1.0;
+
+    for(double mass : Store.Mass)
+        MassScale = (std::max)(MassScale, mass);
+
+    Scratch.resize(Scheduler.GetNumThreads());
+
+    Timings = TotalTimings = PhaseTimings();
+    Steps = 0;
+}
+
+void FastMultipole::Update(float dt)
+{
+    Expansion.SetOrder(Order);
+
+    // Fitted every step, the tree is rebuilt every step anyway
+    Bounds = Morton::FitBounds(Store, Scheduler);
+    NumInside = Sorter.Sort(Store, Bounds, Scheduler);
+    Tree.BuildSorted(Bounds, Store, Sorter.GetKeys(), NumInside, LeafSize);
+
+    if(Tree.GetNumEscaped() != NumEscaped)
+    {
+        NumEscaped = Tree.GetNumEscaped();
+        LOGM("Fast Multipole build: " + std::to_string(NumEscaped) + " particles escaped the tree")
+    }
+
+    const auto& nodes = Tree.GetNodes();
+    Leaves.clear();
+
+    for(uint32_t i = 0; i < nodes.size(); ++i)
+    {
+        if(nodes[i].IsLeaf() && nodes[i].NumParticles > 0)
+            Leaves.push_back(i);
+    }
+
+    auto start = Clock::now();
+    UpwardPass();
+
+    // The interaction lists depend on the radii from the upward pass, they are counted as part of M2L
+    auto upward = Clock::now();
+    BuildInteractions();
+    TranslatePass();
+
+    auto translate = Clock::now();
+    DownwardPass();
+
+    auto downward = Clock::now();
+    DirectPass();
+
+    auto direct = Clock::now();
+
+    Timings.Upward = Milliseconds(start, upward);
+    Timings.M2L = Milliseconds(upward, translate);
+    Timings.Downward = Milliseconds(translate, downward);
+    Timings.P2P = Milliseconds(downward, direct);
+
+    TotalTimings.Upward += Timings.Upward;
+    TotalTimings.M2L += Timings.M2L;
+    TotalTimings.Downward += Timings.Downward;
+    TotalTimings.P2P += Timings.P2P;
+
+    if(++Steps % ReportInterval == 0)
+        Report();
+
+    // Every force was written above, so the step and the write back share one pass
+    ParallelFor(Scheduler, Store.Size(), [this, dt](size_t begin, size_t end, uint32_t) {
+        Store.Integrate(dt, begin, end);
+        Store.ProjectPositions(*Particles, begin, end);
+    }, ParticleStore::StreamGrain);
+}
+
+void FastMultipole::SyncParticles()
+{
+    Store.Project(*Particles, 0, Store.Size());
+}
+
+#ifndef NBODY_HEADLESS
+void FastMultipole::RenderDebug(DirectX::SimpleMath::Matrix view, DirectX::SimpleMath::Matrix proj)
+{
+    Tree.RenderDebug(DebugCube.get(), DebugSphere.get(), view, proj);
+}
+#endif
+
+bool FastMultipole::IsWellSeparated(uint32_t a, uint32_t b) const
+{
+    double radii = Cells[a].Radius + Cells[b].Radius;
+    Vec3d offset = Cells[a].Centre - Cells[b].Centre;
+    double distanceSq = offset.x * offset.x + offset.y * offset.y + offset.z * offset.z;
+
+    if(radii * radii >= OpeningAngle * OpeningAngle * distanceSq)
+        return false;
+
+    // Closest any two of their particles can be
+    double gap = std::sqrt(distanceSq) - radii;
+
+    return Expansion.GetSeriesError(gap * gap) < MaxSeriesError;
+}
+
+void FastMultipole::BuildInteractions()
+{
+    const auto& nodes = Tree.GetNodes();
+
+    M2LPairs.clear();
+    P2PPairs.clear();
+
+    const size_t directLimit = DirectCost * Expansion.GetNumCoefficients();
+
+    PairStack.clear();
+    PairStack.push_back({ 0, 0 });
+
+    while(!PairStack.empty())
+    {
+        NodePair pair = PairStack.back();
+        PairStack.pop_back();
+
+        const auto& target = nodes[pair.Target];
+        const auto& source = nodes[pair.Source];
+
+        if(target.NumParticles == 0 || source.NumParticles == 0)
+            continue;
+
+        // A node against itself, every pair of its children interacts
+        if(pair.Target == pair.Source)
+        {
+            if(target.IsLeaf())
+            {
+                P2PPairs.push_back(pair);
+                continue;
+            }
+
+            for(uint32_t a = 0; a < 8; ++a)
+                for(uint32_t b = 0; b < 8; ++b)
+                    PairStack.push_back({ target.FirstChild + a, target.FirstChild + b });
+        }
+        else if(IsWellSeparated(pair.Target, pair.Source))
+        {
+            if(target.IsLeaf() && target.NumParticles * source.NumParticles <= directLimit)
+                P2PPairs.push_back(pair);
+            else
+                M2LPairs.push_back(pair);
+        }
+        else if(target.IsLeaf() && source.IsLeaf())
+        {
+            P2PPairs.push_back(pair);
+        }
+        // Split the bigger of the two nodes
+        else if(source.IsLeaf() || (!target.IsLeaf() && target.HalfSize >= source.HalfSize))
+        {
+            for(uint32_t c = 0; c < 8; ++c)
+                PairStack.push_back({ target.FirstChild + c, pair.Source });
+        }
+        else
+        {
+            for(uint32_t c = 0; c < 8; ++c)
+                PairStack.push_back({ pair.Target, source.FirstChild + c });
+        }
+    }
+
+    M2LList.Build(M2LPairs, nodes.size());
+    P2PList.Build(P2PPairs, nodes.size());
+}
+
+void FastMultipole::UpwardPass()
+{
+    const auto& nodes = Tree.GetNodes();
+    const size_t numCoefficients = Expansion.GetNumCoefficients();
+
+    Cells.resize(nodes.size());
+    Multipoles.assign(nodes.size() * numCoefficients, 0.0);
+
+    // Expanding about the centre of mass rather than the cube centre gives much
+    // tighter radii for the opening test, and the dipole terms vanish
+    for(size_t i = 0; i < nodes.size(); ++i)
+    {
+        const auto& com = nodes[i].CentreOfMass;
+
+        Cells[i].Centre = Vec3d(com.x, com.y, com.z);
+        Cells[i].Radius = 0.0;
+    }
+
+    // P2M
+    ParallelFor(Scheduler, Leaves.size(), [&](size_t begin, size_t end, uint32_t) {
+        for(size_t l = begin; l < end; ++l)
+        {
+            const auto& leaf = nodes[Leaves[l]];
+            Cell& cell = Cells[Leaves[l]];
+
+            for(uint32_t p = leaf.FirstParticle; p < leaf.FirstParticle + leaf.NumParticles; ++p)
+            {
+                Vec3d offset = Vec3d(Store.PosX[p], Store.PosY[p], Store.PosZ[p]) - cell.Centre;
+                cell.Radius = (std::max)(cell.Radius, Length(offset));
+            }
+
+            Expansion.P2M(cell.Centre, Store, leaf.FirstParticle, leaf.FirstParticle + leaf.NumParticles,
+                          &Multipoles[Leaves[l] * numCoefficients]);
+        }
+    });
+
+    // M2M, children are always after their parent so walking backwards is bottom up
+    for(size_t i = nodes.size(); i-- > 0;)
+    {
+        const auto& node = nodes[i];
+
+        if(node.IsLeaf() || node.NumParticles == 0)
+            continue;
+
+        for(uint32_t c = node.FirstChild; c < node.FirstChild + 8; ++c)
+        {
+            if(nodes[c].NumParticles == 0)
+                continue;
+
+            Vec3d offset = Cells[c].Centre - Cells[i].Centre;
+
+            Cells[i].Radius = (std::max)(Cells[i].Radius, Length(offset) + Cells[c].Radius);
+            Expansion.M2M(&Multipoles[c * numCoefficients], offset, &Multipoles[i * numCoefficients]);
+        }
+    }
+}
+
+void FastMultipole::TranslatePass()
+{
+    const auto& nodes = Tree.GetNodes();
+    const size_t numCoefficients = Expansion.GetNumCoefficients();
+
+    Locals.assign(nodes.size() * numCoefficients, 0.0);
+
+    // Every target only writes its own locals, so targets are split between the workers
+    ParallelFor(Scheduler, nodes.size(), [&](size_t begin, size_t end, uint32_t) {
+        for(size_t t = begin; t < end; ++t)
+        {
+            for(uint32_t s = M2LList.Offsets[t]; s < M2LList.Offsets[t + 1]; ++s)
+            {
+                uint32_t source = M2LList.Sources[s];
+
+                Expansion.M2L(&Multipoles[source * numCoefficients], Cells[t].Centre - Cells[source].Centre, &Locals[t * numCoefficients]);
+            }
+        }
+    });
+}
+
+void FastMultipole::DownwardPass()
+{
+    const auto& nodes = Tree.GetNodes();
+    const size_t numCoefficients = Expansion.GetNumCoefficients();
+
+    // L2L, parents come before their children so this is top down
+    for(size_t i = 0; i < nodes.size(); ++i)
+    {
+        const auto& node = nodes[i];
+
+        if(node.IsLeaf() || node.NumParticles == 0)
+            continue;
+
+        for(uint32_t c = node.FirstChild; c < node.FirstChild + 8; ++c)
+        {
+            if(nodes[c].NumParticles > 0)
+                Expansion.L2L(&Locals[i * numCoefficients], Cells[c].Centre - Cells[i].Centre, &Locals[c * numCoefficients]);
+        }
+    }
+
+    // L2P, F = G m grad(sum m_j / r_j)
+    ParallelFor(Scheduler, Leaves.size(), [&](size_t begin, size_t end, uint32_t) {
+        for(size_t l = begin; l < end; ++l)
+        {
+            const auto& leaf = nodes[Leaves[l]];
+            const Vec3d& centre = Cells[Leaves[l]].Centre;
+            const double* local = &Locals[Leaves[l] * numCoefficients];
+
+            for(uint32_t p = leaf.FirstParticle; p < leaf.FirstParticle + leaf.NumParticles; ++p)
+            {
+                Vec3d offset(Store.PosX[p] - centre.x, Store.PosY[p] - centre.y, Store.PosZ[p] - centre.z);
+                Vec3d gradient = Expansion.L2P(local, offset);
+
+                double scale = Phys::G * Store.Mass[p];
+
+                Store.ForceX[p] = gradient.x * scale;
+                Store.ForceY[p] = gradient.y * scale;
+                Store.ForceZ[p] = gradient.z * scale;
+            }
+        }
+    });
+}
+
+void FastMultipole::DirectPass()
+{
+    ParallelFor(Scheduler, Leaves.size(), [&](size_t begin, size_t end, uint32_t thread) {
+        for(size_t l = begin; l < end; ++l)
+        {
+            if(MixedPrecision)
+                DirectLeafMixed(Leaves[l], Scratch[thread]);
+            else
+                DirectLeaf(Leaves[l]);
+        }
+    });
+
+    // Particles which escaped the bounds aren't in the tree, they fall back to a Barnes-Hut walk for its force on them
+    Tree.AddEscapedForces(Store, Scheduler, [](size_t) { return true; });
+}
+
+void FastMultipole::DirectLeaf(uint32_t t)
+{
+    const auto& nodes = Tree.GetNodes();
+    const auto& leaf = nodes[t];
+
+    // Sources may be any node, their particles are a contiguous range of the sorted store
+    for(uint32_t p = leaf.FirstParticle; p < leaf.FirstParticle + leaf.NumParticles; ++p)
+    {
+        const double x = Store.PosX[p];
+        const double y = Store.PosY[p];
+        const double z = Store.PosZ[p];
+        const double mass = Store.Mass[p];
+
+        Vec3d force;
+
+        for(uint32_t s = P2PList.Offsets[t]; s < P2PList.Offsets[t + 1]; ++s)
+        {
+            const auto& source = nodes[P2PList.Sources[s]];
+
+            for(uint32_t q = source.FirstParticle; q < source.FirstParticle + source.NumParticles; ++q)
+            {
+                double dx = x - Store.PosX[q];
+                double dy = y - Store.PosY[q];
+                double dz = z - Store.PosZ[q];
+
+                double d2 = dx * dx + dy * dy + dz * dz;
+                if(q == p || d2 <= 0.0) continue;
+
+                double f = Phys::Gravity(mass, Store.Mass[q], d2) / std::sqrt(d2);
+                force += Vec3d(f * dx, f * dy, f * dz);
+            }
+        }
+
+        Store.ForceX[p] += force.x;
+        Store.ForceY[p] += force.y;
+        Store.ForceZ[p] += force.z;
+    }
+}
+
+void FastMultipole::DirectLeafMixed(uint32_t t, DirectScratch& scratch)
+{
+    const auto& nodes = Tree.GetNodes();
+    const auto& leaf = nodes[t];
+
+    // Offsets from the leaf's centre are small next to the positions themselves, so less of the float is lost
+    const Vec3d& origin = Cells[t].Centre;
+
+    scratch.TargetX.clear();
+    scratch.TargetY.clear();
+    scratch.TargetZ.clear();
+
+    for(uint32_t p = leaf.FirstParticle; p < leaf.FirstParticle + leaf.NumParticles; ++p)
+    {
+        scratch.TargetX.push_back(static_cast<float>(Store.PosX[p] - origin.x));
+        scratch.TargetY.push_back(static_cast<float>(Store.PosY[p] - origin.y));
+        scratch.TargetZ.push_back(static_cast<float>(Store.PosZ[p] - origin.z));
+    }
+
+    scratch.X.clear();
+    scratch.Y.clear();
+    scratch.Z.clear();
+    scratch.Mass.clear();
+
+    for(uint32_t s = P2PList.Offsets[t]; s < P2PList.Offsets[t + 1]; ++s)
+    {
+        const auto& source = nodes[P2PList.Sources[s]];
+
+        for(uint32_t q = source.FirstParticle; q < source.FirstParticle + source.NumParticles; ++q)
+        {
+            scratch.X.push_back(static_cast<float>(Store.PosX[q] - origin.x));
+            scratch.Y.push_back(static_cast<float>(Store.PosY[q] - origin.y));
+            scratch.Z.push_back(static_cast<float>(Store.PosZ[q] - origin.z));
+            scratch.Mass.push_back(static_cast<float>(Store.Mass[q] / MassScale));
+        }
+    }
+
+    // A target is also a source when its own leaf is in the list, the kernel skips it by distance
+    Kernels::GravitySources sources = {
+        scratch.X.data(),
+        scratch.Y.data(),
+        scratch.Z.data(),
+        scratch.Mass.data(),
+        scratch.X.size(),
+        static_cast<float>(Phys::S)
+    };
+
+    Kernels::GravityTargets targets = {
+        scratch.TargetX.data(),
+        scratch.TargetY.data(),
+        scratch.TargetZ.data(),
+        scratch.TargetX.size()
+    };
+
+    scratch.ForceX.resize(targets.Count);
+    scratch.ForceY.resize(targets.Count);
+    scratch.ForceZ.resize(targets.Count);
+
+    Kernel(sources, targets, scratch.ForceX.data(), scratch.ForceY.data(), scratch.ForceZ.data());
+
+    for(uint32_t i = 0; i < leaf.NumParticles; ++i)
+    {
+        const uint32_t p = leaf.FirstParticle + i;
+        const double scale = -Phys::G * Store.Mass[p] * MassScale;
+
+        Store.ForceX[p] += scratch.ForceX[i] * scale;
+        Store.ForceY[p] += scratch.ForceY[i] * scale;
+        Store.ForceZ[p] += scratch.ForceZ[i] * scale;
+    }
+}
+
+double FastMultipole::MeasureError() const
+{
+    const size_t numSamples = (std::min)(Store.Size(), static_cast<size_t>(64));
+
+    if(numSamples == 0)
+        return 0.0;
+
+    const size_t stride = Store.Size() / numSamples;
+
+    double errorSq = 0.0, magnitudeSq = 0.0;
+
+    for(size_t s = 0; s < numSamples; ++s)
+    {
+        size_t i = s * stride;
+        Vec3d exact;
+
+        for(size_t j = 0; j < Store.Size(); ++j)
+        {
+            double dx = static_cast<double>(Store.PosX[i]) - Store.PosX[j];
+            double dy = static_cast<double>(Store.PosY[i]) - Store.PosY[j];
+            double dz = static_cast<double>(Store.PosZ[i]) - Store.PosZ[j];
+
+            double d2 = dx * dx + dy * dy + dz * dz;
+            if(i == j || d2 <= 0.0) continue;
+
+            double f = Phys::Gravity(Store.Mass[i], Store.Mass[j], d2) / std::sqrt(d2);
+            exact += Vec3d(f * dx, f * dy, f * dz);
+        }
+
+        double ex = Store.ForceX[i] - exact.x;
+        double ey = Store.ForceY[i] - exact.y;
+        double ez = Store.ForceZ[i] - exact.z;
+
+        errorSq += ex * ex + ey * ey + ez * ez;
+        magnitudeSq += exact.x * exact.x + exact.y * exact.y + exact.z * exact.z;
+    }
+
+    return magnitudeSq > 0.0 ? std::sqrt(errorSq / magnitudeSq) : 0.0;
+}
+
+void FastMultipole::Report()
+{
+    const double steps = static_cast<double>(ReportInterval);
+
+    std::ostringstream ss;
+    ss.precision(2);
+    ss << std::fixed;
+    ss << "FMM order " << Expansion.GetOrder()
+       << ": upward " << TotalTimings.Upward / steps << "ms"
+       << ", M2L " << TotalTimings.M2L / steps << "ms"
+       << ", downward " << TotalTimings.Downward / steps << "ms"
+       << ", P2P " << TotalTimings.P2P / steps << "ms";
+
+    ss << std::scientific << ", error " << MeasureError();
+
+    LOGM(ss.str())
+
+    TotalTimings = PhaseTimings();
+}
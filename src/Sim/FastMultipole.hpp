@@ -0,0 +1,147 @@
+#pragma once
+
+#include "Morton.hpp"
+#include "Multipole.hpp"
+#include "LinearOctree.hpp"
+#include "INBodySim.hpp"
+#include "Core/TaskScheduler.hpp"
+#include "Kernels/Gravity.hpp"
+
+#ifndef NBODY_HEADLESS
+#include <GeometricPrimitive.h>
+#include "Render/Model/Cube.hpp"
+#endif
+
+/*
+    Fast multipole method over the same Morton sorted LinearOctree as
+    Barnes-Hut, with leaves of up to LeafSize particles. A dual tree walk
+    pairs every node with the nodes it sees either through a multipole to
+    local (M2L) translation or, between leaves, directly (P2P). Expansions
+    are of the softened potential the direct sums use, so nodes only interact
+    through them well outside the softening length, closer ones go to P2P.
+
+    P2P sums in double by default. With MixedPrecision each target leaf's
+    targets and sources are copied as float offsets from the leaf's centre
+    and summed with the SIMD gravity kernel, which accumulates in float per
+    block and in double across blocks.
+
+    The root cube is fitted to the particles every step, the few which escape
+    far from the rest (see Morton::FitBounds) are summed directly.
+*/
+class FastMultipole : public INBodySim
+{
+    public:
+        // Expansion order, between 1 and MultipoleExpansion::MaxOrder
+        // Settings are set from the UI thread while a simulation thread may be reading them
+        static std::atomic<int> Order;
+
+        // P2P in float relative to each target leaf, see above
+        static std::atomic<bool> MixedPrecision;
+
+        struct PhaseTimings
+        {
+            double Upward = 0.0;
+            double M2L = 0.0;
+            double Downward = 0.0;
+            double P2P = 0.0;
+        };
+
+        FastMultipole(ID3D11DeviceContext* context);
+        ~FastMultipole();
+
+        void Init(std::vector<Particle>& particles) final;
+        void Update(float dt) final;
+        void SyncParticles() final;
+        TaskScheduler* GetScheduler() final { return &Scheduler; }
+#ifndef NBODY_HEADLESS
+        void RenderDebug(DirectX::SimpleMath::Matrix view, DirectX::SimpleMath::Matrix proj);
+#endif
+
+        // Phase times of the last step in milliseconds
+        const PhaseTimings& GetTimings() const { return Timings; }
+
+        // RMS error of the forces relative to brute force, over a sample of the particles
+        double MeasureError() const;
+
+    private:
+        static const uint32_t LeafSize = 64;
+        static const int ReportInterval = 100;
+
+        struct NodePair
+        {
+            uint32_t Target;
+            uint32_t Source;
+        };
+
+        // Expansion centre and radius of a node, every particle under it lies within the radius
+        struct Cell
+        {
+            Vec3d Centre;
+            double Radius;
+        };
+
+        // Source nodes of every target node, stored as one array with per node offsets
+        struct InteractionList
+        {
+            std::vector<uint32_t> Offsets;
+            std::vector<uint32_t> Sources;
+
+            void Build(const std::vector<NodePair>& pairs, size_t numNodes);
+        };
+
+        BoundingCube Bounds;
+
+        LinearOctree Tree;
+        MortonSorter Sorter;
+        ParticleStore Store;
+        std::vector<Particle>* Particles;
+        size_t NumInside = 0;
+
+        // Escaped particles of the last build, logged when it changes
+        uint32_t NumEscaped = 0;
+
+        MultipoleExpansion Expansion;
+        std::vector<Cell> Cells;
+        std::vector<double> Multipoles;
+        std::vector<double> Locals;
+        std::vector<uint32_t> Leaves;
+
+        std::vector<NodePair> PairStack, M2LPairs, P2PPairs;
+        InteractionList M2LList, P2PList;
+
+        // Per thread buffers for the mixed precision P2P of one leaf
+        struct DirectScratch
+        {
+            std::vector<float> X, Y, Z, Mass;
+            std::vector<float> TargetX, TargetY, TargetZ;
+            std::vector<double> ForceX, ForceY, ForceZ;
+        };
+
+        Kernels::GravityKernel Kernel;
+        std::vector<DirectScratch> Scratch;
+        double MassScale = 1.0;
+
+        PhaseTimings Timings, TotalTimings;
+        int Steps = 0;
+
+        ID3D11DeviceContext* Context;
+
+        TaskScheduler Scheduler;
+
+#ifndef NBODY_HEADLESS
+        std::unique_ptr<Cube> DebugCube;
+        std::unique_ptr<DirectX::GeometricPrimitive> DebugSphere;
+#endif
+
+        void BuildInteractions();
+        bool IsWellSeparated(uint32_t a, uint32_t b) const;
+
+        void UpwardPass();
+        void TranslatePass();
+        void DownwardPass();
+        void DirectPass();
+        void DirectLeaf(uint32_t t);
+        void DirectLeafMixed(uint32_t t, DirectScratch& scratch);
+        void Report();
+
+};
@@ -0,0 +1,123 @@
+#include "ForceAccuracy.hpp"
+#include "Physics.hpp"
+#include "Core/TaskScheduler.hpp"
+
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+
+namespace ForceAccuracy
+{
+    std::vector<uint32_t> SampleParticles(size_t numParticles, size_t numSamples)
+    {
+        numSamples = (std::min)(numSamples, numParticles);
+
+        std::vector<uint32_t> samples(numSamples);
+
+        for(size_t s = 0; s < numSamples; ++s)
+            samples[s] = static_cast<uint32_t>((s * numParticles) / numSamples);
+
+        return samples;
+    }
+
+    std::vector<Vec3d> ReferenceForces(const std::vector<Particle>& particles, const std::vector<uint32_t>& samples)
+    {
+        std::vector<Vec3d> forces(samples.size());
+
+        TaskScheduler scheduler;
+
+        ParallelFor(scheduler, samples.size(), [&](size_t begin, size_t end, uint32_t) {
+            for(size_t s = begin; s < end; ++s)
+            {
+                const Particle& a = particles[samples[s]];
+                long double fx = 0.0L, fy = 0.0L, fz = 0.0L;
+
+                for(size_t j = 0; j < particles.size(); ++j)
+                {
+                    const Particle& b = particles[j];
+
+                    long double dx = static_cast<long double>(a.Position.x) - b.Position.x;
+                    long double dy = static_cast<long double>(a.Position.y) - b.Position.y;
+                    long double dz = static_cast<long double>(a.Position.z) - b.Position.z;
+
+                    long double d2 = dx * dx + dy * dy + dz * dz;
+                    if(d2 <= 0.0L) continue;
+
+                    // Phys::Gravity along the separation, as the simulations apply it
+                    long double f = -(static_cast<long double>(Phys::G) * a.Mass * b.Mass) / (d2 + Phys::S) / std::sqrt(d2);
+
+                    fx += f * dx;
+                    fy += f * dy;
+                    fz += f * dz;
+                }
+
+                forces[s] = Vec3d(static_cast<double>(fx), static_cast<double>(fy), static_cast<double>(fz));
+            }
+        });
+
+        return forces;
+    }
+
+    Result Compare(const std::vector<Particle>& particles, const std::vector<uint32_t>& samples,
+                   const std::vector<Vec3d>& reference)
+    {
+        Result result;
+
+        std::vector<double> errors;
+        errors.reserve(samples.size());
+
+        double errorSq = 0.0;
+
+        for(size_t s = 0; s < samples.size(); ++s)
+        {
+            const Vec3d& force = particles[samples[s]].Forces;
+            const Vec3d& exact = reference[s];
+
+            double magnitude = std::sqrt(exact.x * exact.x + exact.y * exact.y + exact.z * exact.z);
+            if(magnitude <= 0.0) continue;
+
+            double ex = force.x - exact.x, ey = force.y - exact.y, ez = force.z - exact.z;
+            double error = std::sqrt(ex * ex + ey * ey + ez * ez) / magnitude;
+
+            errors.push_back(error);
+            errorSq += error * error;
+        }
+
+        if(!errors.empty())
+        {
+            std::sort(errors.begin(), errors.end());
+
+            size_t p99 = static_cast<size_t>(std::ceil(0.99 * errors.size())) - 1;
+
+            result.RMS = std::sqrt(errorSq / errors.size());
+            result.P99 = errors[p99];
+            result.Max = errors.back();
+        }
+
+        return result;
+    }
+
+    Result Measure(INBodySim& sim, std::vector<Particle>& particles, const std::vector<uint32_t>& samples,
+                   const std::vector<Vec3d>& reference, float dt, int steps)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        sim.Init(particles);
+        sim.Update(0.0f);
+        sim.SyncParticles();
+
+        Result result = Compare(particles, samples, reference);
+
+        if(steps > 0)
+        {
+            auto start = Clock::now();
+
+            for(int i = 0; i < steps; ++i)
+                sim.Update(dt);
+
+            result.StepMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / steps;
+        }
+
+        return result;
+    }
+}
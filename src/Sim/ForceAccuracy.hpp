@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "INBodySim.hpp"
+#include "Core/Vec3.hpp"
+
+/*
+    Measures the forces of a simulation against an all pairs reference summed
+    in long double, over an evenly spaced sample of the particles. Errors are
+    relative to the reference force on each particle.
+*/
+namespace ForceAccuracy
+{
+    struct Result
+    {
+        double RMS = 0.0;
+        double P99 = 0.0;
+        double Max = 0.0;
+
+        // Mean wall time of an Update in milliseconds
+        double StepMs = 0.0;
+    };
+
+    // numSamples particle indices spread evenly over the array, every index when there are fewer particles
+    std::vector<uint32_t> SampleParticles(size_t numParticles, size_t numSamples);
+
+    // Softened force on each sampled particle from every other particle
+    std::vector<Vec3d> ReferenceForces(const std::vector<Particle>& particles, const std::vector<uint32_t>& samples);
+
+    // Error statistics of the sampled particles' Forces against reference, StepMs is left 0
+    Result Compare(const std::vector<Particle>& particles, const std::vector<uint32_t>& samples,
+                   const std::vector<Vec3d>& reference);
+
+    /*
+        Evaluates the forces of sim on particles without moving them (an Update of 0)
+        and compares them with reference, then times steps Updates of dt.
+        particles are left stepped forward.
+    */
+    Result Measure(INBodySim& sim, std::vector<Particle>& particles, const std::vector<uint32_t>& samples,
+                   const std::vector<Vec3d>& reference, float dt, int steps);
+}
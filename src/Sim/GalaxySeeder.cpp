@@ -3,10 +3,10 @@
 #include "Services/Log.hpp"
 
 #include <type_traits>
-#include <DirectXColors.h>
 
 using DirectX::SimpleMath::Vector3;
 using DirectX::SimpleMath::Color;
+using DirectX::SimpleMath::Matrix;
 
 template <class T>
 GalaxySeeder<T>::GalaxySeeder(std::vector<T>& particles, float scale)
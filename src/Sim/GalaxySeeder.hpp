@@ -2,9 +2,10 @@
 
 #include "IParticleSeeder.hpp"
 
-#include <SimpleMath.h>
 #include <random>
 
+#include "Core/SimpleMath.hpp"
+
 template <class T>
 class GalaxySeeder : public IParticleSeeder
 {
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cmath>
+
+#include "Physics.hpp"
+
+/*
+    Compile time force laws for the templated engines. The force on a from b
+    is -G * mA * mB * Kernel(d2) * (a - b), with d2 their squared distance in
+    store units, so an engine can take G and its own mass out of the sum and
+    the inner loop is only the kernel. Real is the precision of the kernel and
+    of the engine's sums, d2 is never 0 when the kernel is called.
+*/
+namespace Phys
+{
+    // Softening length of the spline, 2.8 times the Plummer length sqrt(S) gives
+    // the same potential depth at zero distance (Springel, GADGET-2)
+    const double SplineLength = 2.8 * 3.16227766016837933;
+
+    // The softening of Gravity, (d2 + S) in place of d2 in the inverse square
+    template <class T>
+    struct Plummer
+    {
+        using Real = T;
+
+        static const char* GetName() { return "Plummer"; }
+
+        static Real Kernel(Real d2)
+        {
+            return Real(1) / ((d2 + Real(S)) * std::sqrt(d2));
+        }
+    };
+
+    // Cubic spline density (Monaghan and Lattanzio), exactly Newtonian beyond SplineLength
+    template <class T>
+    struct Spline
+    {
+        using Real = T;
+
+        static const char* GetName() { return "Spline"; }
+
+        static Real Kernel(Real d2)
+        {
+            const Real h = Real(SplineLength);
+            const Real r = std::sqrt(d2);
+
+            if(r >= h)
+                return Real(1) / (d2 * r);
+
+            const Real u = r / h;
+            const Real h3 = Real(1) / (h * h * h);
+
+            if(u < Real(0.5))
+                return h3 * (Real(10.666666666667) + u * u * (Real(32.0) * u - Real(38.4)));
+
+            return h3 * (Real(21.333333333333) - Real(48.0) * u + Real(38.4) * u * u
+                         - Real(10.666666666667) * u * u * u - Real(0.066666666667) / (u * u * u));
+        }
+    };
+
+    // Plain inverse square, only for comparisons, close pairs blow up
+    template <class T>
+    struct Unsoftened
+    {
+        using Real = T;
+
+        static const char* GetName() { return "Unsoftened"; }
+
+        static Real Kernel(Real d2)
+        {
+            return Real(1) / (d2 * std::sqrt(d2));
+        }
+    };
+
+    template <class Real>
+    inline const char* GetPrecisionName();
+
+    template <>
+    inline const char* GetPrecisionName<float>() { return "float"; }
+
+    template <>
+    inline const char* GetPrecisionName<double>() { return "double"; }
+}
@@ -2,7 +2,13 @@
 
 #include "BarnesHut.hpp"
 #include "BruteForceCPU.hpp"
+#include "BruteForceSIMD.hpp"
+#include "FastMultipole.hpp"
+#include "Services/Log.hpp"
+
+#ifndef NBODY_HEADLESS
 #include "BruteForceGPU.hpp"
+#endif
 
 std::unique_ptr<INBodySim> CreateNBodySim(ID3D11DeviceContext* context, ENBodySim type)
 {
@@ -15,12 +21,24 @@ std::unique_ptr<INBodySim> CreateNBodySim(ID3D11DeviceContext* context, ENBodySi
             break;
 
         case ENBodySim::BruteForceGPU:
+#ifndef NBODY_HEADLESS
             sim = std::make_unique<BruteForceGPU>(context);
+#else
+            LOGE("Brute Force GPU needs a D3D11 device, it is not available in headless builds")
+#endif
             break;
 
         case ENBodySim::BarnesHut:
             sim = std::make_unique<BarnesHut>(context);
             break;
+
+        case ENBodySim::BruteForceSIMD:
+            sim = std::make_unique<BruteForceSIMD>(context);
+            break;
+
+        case ENBodySim::FastMultipole:
+            sim = std::make_unique<FastMultipole>(context);
+            break;
     }
 
     return std::move(sim);
@@ -33,6 +51,8 @@ std::string NBodySimGetName(ENBodySim type)
         case ENBodySim::BruteForceCPU:  return "Brute Force CPU"; break;
         case ENBodySim::BruteForceGPU:  return "Brute Force GPU"; break;
         case ENBodySim::BarnesHut:      return "Barnes-Hut"; break;
+        case ENBodySim::BruteForceSIMD: return "Brute Force SIMD"; break;
+        case ENBodySim::FastMultipole:  return "Fast Multipole"; break;
     }
 
     return "Unknown";
@@ -3,16 +3,24 @@
 #include <vector>
 #include <memory>
 #include <string>
-#include <d3d11.h>
-#include <SimpleMath.h>
 
+#include "Core/SimpleMath.hpp"
 #include "Render/Misc/Particle.hpp"
 
+class TaskScheduler;
+
+#ifdef NBODY_HEADLESS
+// Headless builds have no device, simulations are always created with nullptr
+struct ID3D11DeviceContext;
+#endif
+
 enum class ENBodySim
 {
     BruteForceCPU,
     BruteForceGPU,
     BarnesHut,
+    BruteForceSIMD,
+    FastMultipole,
     NumSims
 };
 
@@ -21,8 +29,17 @@ class INBodySim
     public:
         virtual void Init(std::vector<Particle>& particles) = 0;
         virtual void Update(float dt) = 0;
+
+        // Simulations which keep their own copy of the particle state only write positions
+        // back every step, this writes back the rest (velocity, forces)
+        virtual void SyncParticles() {}
         virtual void RenderDebug(DirectX::SimpleMath::Matrix view, DirectX::SimpleMath::Matrix proj) {}
+
+        // Pool the simulation steps on, nullptr for none. Idle between Updates, the thread
+        // calling Update may use it then rather than start threads of its own
+        virtual TaskScheduler* GetScheduler() { return nullptr; }
 };
 
+// Returns nullptr for simulations which aren't available in this build
 std::unique_ptr<INBodySim> CreateNBodySim(ID3D11DeviceContext* context, ENBodySim type);
 std::string NBodySimGetName(ENBodySim type);
\ No newline at end of file
@@ -4,10 +4,7 @@
 
 #include <memory>
 #include <vector>
-
-#include "RandomSeeder.hpp"
-#include "GalaxySeeder.hpp"
-#include "StarSystemSeeder.hpp"
+#include <cstdint>
 
 enum class EParticleSeeder
 {
@@ -19,6 +16,8 @@ enum class EParticleSeeder
 class IParticleSeeder
 {
     public:
+        virtual ~IParticleSeeder() {}
+
         virtual void Seed(uint64_t seed = 0) = 0;
 
         virtual void SetRedDist(float low, float hi) {}
@@ -26,6 +25,11 @@ class IParticleSeeder
         virtual void SetBlueDist(float low, float hi) {}
 };
 
+// The seeders derive from IParticleSeeder, so they can only be included once it is declared
+#include "RandomSeeder.hpp"
+#include "GalaxySeeder.hpp"
+#include "StarSystemSeeder.hpp"
+
 template <class T = Particle>
 std::unique_ptr<IParticleSeeder> CreateParticleSeeder(std::vector<T>& particles, EParticleSeeder type, float scale = 1.0f)
 {
@@ -0,0 +1,67 @@
+#include "Gravity.hpp"
+#include "Core/CpuInfo.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+void Kernels::GravityScalar(const GravitySources& sources, const GravityTargets& targets, double* outX, double* outY, double* outZ)
+{
+    for(size_t i = 0; i < targets.Count; ++i)
+    {
+        const float x = targets.X[i], y = targets.Y[i], z = targets.Z[i];
+        double sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+
+        for(size_t block = 0; block < sources.Count; block += GravityBlockSize)
+        {
+            const size_t blockEnd = (std::min)(block + GravityBlockSize, sources.Count);
+            float ax = 0.0f, ay = 0.0f, az = 0.0f;
+
+            for(size_t j = block; j < blockEnd; ++j)
+            {
+                float dx = x - sources.X[j];
+                float dy = y - sources.Y[j];
+                float dz = z - sources.Z[j];
+                float d2 = dx * dx + dy * dy + dz * dz;
+
+                if(d2 <= 0.0f)
+                    continue;
+
+                float s = sources.Mass[j] / (std::sqrt(d2) * (d2 + sources.Softening));
+
+                ax += s * dx;
+                ay += s * dy;
+                az += s * dz;
+            }
+
+            sumX += ax;
+            sumY += ay;
+            sumZ += az;
+        }
+
+        outX[i] = sumX;
+        outY[i] = sumY;
+        outZ[i] = sumZ;
+    }
+}
+
+Kernels::GravityKernel Kernels::SelectGravityKernel(std::string* name)
+{
+    GravityKernel kernel = GravityScalar;
+    std::string kernelName = "Scalar";
+
+    if(CpuInfo::HasAVX512())
+    {
+        kernel = GravityAVX512;
+        kernelName = "AVX-512";
+    }
+    else if(CpuInfo::HasAVX2())
+    {
+        kernel = GravityAVX2;
+        kernelName = "AVX2";
+    }
+
+    if(name)
+        *name = kernelName;
+
+    return kernel;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/*
+    Softened gravity kernels summing a list of sources onto a list of targets,
+    vectorised over the sources. Brute force passes the same particles as both.
+    Masses are passed pre-divided by a common scale so the float sums can't
+    overflow, the caller multiplies the result by -G * m_i * scale.
+*/
+namespace Kernels
+{
+    struct GravitySources
+    {
+        const float* X;
+        const float* Y;
+        const float* Z;
+        const float* Mass;
+        size_t Count;
+        float Softening;
+    };
+
+    struct GravityTargets
+    {
+        const float* X;
+        const float* Y;
+        const float* Z;
+        size_t Count;
+    };
+
+    // Sum of m_j * (p_i - p_j) / (|p_i - p_j| * (|p_i - p_j|^2 + S)) into out[i] for every target,
+    // sources at the same position as the target (including itself) are skipped
+    typedef void (*GravityKernel)(const GravitySources& sources, const GravityTargets& targets, double* outX, double* outY, double* outZ);
+
+    void GravityScalar(const GravitySources& sources, const GravityTargets& targets, double* outX, double* outY, double* outZ);
+    void GravityAVX2(const GravitySources& sources, const GravityTargets& targets, double* outX, double* outY, double* outZ);
+    void GravityAVX512(const GravitySources& sources, const GravityTargets& targets, double* outX, double* outY, double* outZ);
+
+    // Widest kernel the CPU supports
+    GravityKernel SelectGravityKernel(std::string* name = nullptr);
+
+    // Sources are summed in float within a block, then added to a double total
+    const size_t GravityBlockSize = 512;
+}
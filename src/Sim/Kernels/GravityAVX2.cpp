@@ -0,0 +1,101 @@
+#include "Gravity.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+namespace
+{
+    inline float HorizontalSum(__m256 v)
+    {
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+
+        return _mm_cvtss_f32(sum);
+    }
+}
+
+void Kernels::GravityAVX2(const GravitySources& sources, const GravityTargets& targets, double* outX, double* outY, double* outZ)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 threeHalves = _mm256_set1_ps(1.5f);
+    const __m256 softening = _mm256_set1_ps(sources.Softening);
+
+    for(size_t i = 0; i < targets.Count; ++i)
+    {
+        const __m256 x = _mm256_set1_ps(targets.X[i]);
+        const __m256 y = _mm256_set1_ps(targets.Y[i]);
+        const __m256 z = _mm256_set1_ps(targets.Z[i]);
+
+        double sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+
+        for(size_t block = 0; block < sources.Count; block += GravityBlockSize)
+        {
+            const size_t blockEnd = (std::min)(block + GravityBlockSize, sources.Count);
+            const size_t vectorEnd = block + ((blockEnd - block) & ~size_t(7));
+
+            __m256 ax = zero, ay = zero, az = zero;
+
+            for(size_t j = block; j < vectorEnd; j += 8)
+            {
+                __m256 dx = _mm256_sub_ps(x, _mm256_loadu_ps(sources.X + j));
+                __m256 dy = _mm256_sub_ps(y, _mm256_loadu_ps(sources.Y + j));
+                __m256 dz = _mm256_sub_ps(z, _mm256_loadu_ps(sources.Z + j));
+
+                __m256 d2 = _mm256_fmadd_ps(dz, dz, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dx, dx)));
+
+                // 1 / sqrt(d2), refined with one Newton-Raphson step
+                __m256 inv = _mm256_rsqrt_ps(d2);
+                inv = _mm256_mul_ps(inv, _mm256_fnmadd_ps(_mm256_mul_ps(half, d2), _mm256_mul_ps(inv, inv), threeHalves));
+
+                __m256 s = _mm256_div_ps(_mm256_mul_ps(_mm256_loadu_ps(sources.Mass + j), inv), _mm256_add_ps(d2, softening));
+                s = _mm256_and_ps(s, _mm256_cmp_ps(d2, zero, _CMP_GT_OQ));
+
+                ax = _mm256_fmadd_ps(s, dx, ax);
+                ay = _mm256_fmadd_ps(s, dy, ay);
+                az = _mm256_fmadd_ps(s, dz, az);
+            }
+
+            float tailX = 0.0f, tailY = 0.0f, tailZ = 0.0f;
+
+            for(size_t j = vectorEnd; j < blockEnd; ++j)
+            {
+                float dx = targets.X[i] - sources.X[j];
+                float dy = targets.Y[i] - sources.Y[j];
+                float dz = targets.Z[i] - sources.Z[j];
+                float d2 = dx * dx + dy * dy + dz * dz;
+
+                if(d2 <= 0.0f)
+                    continue;
+
+                float s = sources.Mass[j] / (std::sqrt(d2) * (d2 + sources.Softening));
+
+                tailX += s * dx;
+                tailY += s * dy;
+                tailZ += s * dz;
+            }
+
+            sumX += HorizontalSum(ax) + tailX;
+            sumY += HorizontalSum(ay) + tailY;
+            sumZ += HorizontalSum(az) + tailZ;
+        }
+
+        outX[i] = sumX;
+        outY[i] = sumY;
+        outZ[i] = sumZ;
+    }
+}
+
+#else
+
+void Kernels::GravityAVX2(const GravitySources& sources, const GravityTargets& targets, double* outX, double* outY, double* outZ)
+{
+    GravityScalar(sources, targets, outX, outY, outZ);
+}
+
+#endif
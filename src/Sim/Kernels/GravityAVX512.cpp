@@ -0,0 +1,75 @@
+#include "Gravity.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+void Kernels::GravityAVX512(const GravitySources& sources, const GravityTargets& targets, double* outX, double* outY, double* outZ)
+{
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 threeHalves = _mm512_set1_ps(1.5f);
+    const __m512 softening = _mm512_set1_ps(sources.Softening);
+
+    for(size_t i = 0; i < targets.Count; ++i)
+    {
+        const __m512 x = _mm512_set1_ps(targets.X[i]);
+        const __m512 y = _mm512_set1_ps(targets.Y[i]);
+        const __m512 z = _mm512_set1_ps(targets.Z[i]);
+
+        double sumX = 0.0, sumY = 0.0, sumZ = 0.0;
+
+        for(size_t block = 0; block < sources.Count; block += GravityBlockSize)
+        {
+            const size_t blockEnd = (std::min)(block + GravityBlockSize, sources.Count);
+
+            __m512 ax = zero, ay = zero, az = zero;
+
+            // The tail is handled with a masked load rather than a scalar loop
+            for(size_t j = block; j < blockEnd; j += 16)
+            {
+                const size_t remaining = blockEnd - j;
+                const __mmask16 load = remaining >= 16 ? static_cast<__mmask16>(0xFFFF) : static_cast<__mmask16>((1U << remaining) - 1);
+
+                __m512 dx = _mm512_sub_ps(x, _mm512_maskz_loadu_ps(load, sources.X + j));
+                __m512 dy = _mm512_sub_ps(y, _mm512_maskz_loadu_ps(load, sources.Y + j));
+                __m512 dz = _mm512_sub_ps(z, _mm512_maskz_loadu_ps(load, sources.Z + j));
+
+                __m512 d2 = _mm512_fmadd_ps(dz, dz, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dx, dx)));
+
+                // 1 / sqrt(d2), refined with one Newton-Raphson step
+                __m512 inv = _mm512_rsqrt14_ps(d2);
+                inv = _mm512_mul_ps(inv, _mm512_fnmadd_ps(_mm512_mul_ps(half, d2), _mm512_mul_ps(inv, inv), threeHalves));
+
+                // Masked out lanes have zero mass, coincident particles are skipped by the compare
+                const __mmask16 valid = _mm512_mask_cmp_ps_mask(load, d2, zero, _CMP_GT_OQ);
+
+                __m512 s = _mm512_maskz_div_ps(valid, _mm512_mul_ps(_mm512_maskz_loadu_ps(load, sources.Mass + j), inv), _mm512_add_ps(d2, softening));
+
+                ax = _mm512_fmadd_ps(s, dx, ax);
+                ay = _mm512_fmadd_ps(s, dy, ay);
+                az = _mm512_fmadd_ps(s, dz, az);
+            }
+
+            sumX += _mm512_reduce_add_ps(ax);
+            sumY += _mm512_reduce_add_ps(ay);
+            sumZ += _mm512_reduce_add_ps(az);
+        }
+
+        outX[i] = sumX;
+        outY[i] = sumY;
+        outZ[i] = sumZ;
+    }
+}
+
+#else
+
+void Kernels::GravityAVX512(const GravitySources& sources, const GravityTargets& targets, double* outX, double* outY, double* outZ)
+{
+    GravityScalar(sources, targets, outX, outY, outZ);
+}
+
+#endif
@@ -0,0 +1,587 @@
+#include "LinearOctree.hpp"
+#include "Sim/Physics.hpp"
+#include "Sim/Morton.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+const uint32_t LinearOctree::NullIndex;
+
+std::atomic<EOpeningCriterion> LinearOctree::Criterion(EOpeningCriterion::Classic);
+std::atomic<bool> LinearOctree::UseQuadrupoles(false);
+
+namespace
+{
+    inline Vec3d Attract(const DirectX::SimpleMath::Vector3& p, double mass, const DirectX::SimpleMath::Vector3& pos, double otherMass)
+    {
+        auto diff = p - pos;
+        auto f = Phys::Gravity(mass, otherMass, diff.LengthSquared());
+        diff.Normalize();
+
+        return Vec3d(f * diff.x, f * diff.y, f * diff.z);
+    }
+
+    // Force from the quadrupole part of the potential, -G q^T Q q / (2 |q|^5)
+    inline Vec3d AttractQuadrupole(const DirectX::SimpleMath::Vector3& p, double mass, const DirectX::SimpleMath::Vector3& pos, const LinearOctree::Quadrupole& q)
+    {
+        const double x = p.x - pos.x;
+        const double y = p.y - pos.y;
+        const double z = p.z - pos.z;
+
+        const double r2 = x * x + y * y + z * z;
+        const double invR2 = 1.0 / r2;
+        const double invR5 = invR2 * invR2 / std::sqrt(r2);
+
+        const double qx = q.XX * x + q.XY * y + q.XZ * z;
+        const double qy = q.XY * x + q.YY * y + q.YZ * z;
+        const double qz = q.XZ * x + q.YZ * y + q.ZZ * z;
+
+        const double radial = 2.5 * (x * qx + y * qy + z * qz) * invR2;
+        const double scale = Phys::G * mass * invR5;
+
+        return Vec3d(scale * (qx - radial * x), scale * (qy - radial * y), scale * (qz - radial * z));
+    }
+}
+
+void LinearOctree::Build(const BoundingCube& bounds, const ParticleStore& store)
+{
+    Reset(bounds, store);
+
+    for(uint32_t i = 0; i < NumParticles; ++i)
+    {
+        if(Bounds.Contains(store.GetPosition(i)))
+            Add(i);
+    }
+
+    CalculateMass();
+}
+
+void LinearOctree::BuildSorted(const BoundingCube& bounds, const ParticleStore& store, const std::vector<uint64_t>& keys, size_t numSorted, uint32_t leafSize)
+{
+    Reset(bounds, store);
+    NumInside = static_cast<uint32_t>(numSorted);
+
+    BuildStack.clear();
+    BuildStack.push_back({ 0, 0, static_cast<uint32_t>(numSorted) });
+
+    // Every node owns a contiguous range of the sorted particles, the range is split
+    // between the children by the next 3 bits of the keys
+    while(!BuildStack.empty())
+    {
+        BuildRange range = BuildStack.back();
+        BuildStack.pop_back();
+
+        uint32_t count = range.End - range.Begin;
+        Nodes[range.Node].NumParticles = count;
+
+        if(count == 0)
+            continue;
+
+        Nodes[range.Node].FirstParticle = range.Begin;
+
+        if(count <= leafSize || Nodes[range.Node].Depth >= Morton::BitsPerAxis)
+        {
+            for(uint32_t i = range.Begin; i + 1 < range.End; ++i)
+                NextParticle[i] = i + 1;
+
+            continue;
+        }
+
+        Split(range.Node);
+
+        int depth = static_cast<int>(Nodes[range.Node].Depth);
+        uint32_t firstChild = Nodes[range.Node].FirstChild;
+        uint32_t begin = range.Begin;
+
+        for(uint32_t c = 0; c < 8; ++c)
+        {
+            auto end = std::partition_point(keys.begin() + begin, keys.begin() + range.End, [depth, c](uint64_t key) {
+                return Morton::Octant(key, depth) <= c;
+            });
+
+            uint32_t endIndex = static_cast<uint32_t>(end - keys.begin());
+            BuildStack.push_back({ firstChild + c, begin, endIndex });
+            begin = endIndex;
+        }
+    }
+
+    CalculateMass();
+}
+
+uint32_t LinearOctree::Refit()
+{
+    if(Nodes.empty())
+        return NullIndex;
+
+    Moved.clear();
+
+    // Unlink the particles which are no longer inside their leaf's cell
+    for(auto& node : Nodes)
+    {
+        if(!node.IsLeaf())
+            continue;
+
+        uint32_t* link = &node.FirstParticle;
+
+        while(*link != NullIndex)
+        {
+            uint32_t p = *link;
+
+            if(Contains(node, p))
+            {
+                link = &NextParticle[p];
+            }
+            else
+            {
+                *link = NextParticle[p];
+                --node.NumParticles;
+                Moved.push_back(p);
+            }
+        }
+    }
+
+    for(uint32_t p : Moved)
+    {
+        if(!Contains(Nodes[0], p))
+            return NullIndex;
+
+        uint32_t index = 0;
+
+        while(!Nodes[index].IsLeaf())
+            index = Nodes[index].FirstChild + GetOctant(Nodes[index], p);
+
+        Node& leaf = Nodes[index];
+        NextParticle[p] = leaf.FirstParticle;
+        leaf.FirstParticle = p;
+        ++leaf.NumParticles;
+    }
+
+    // Children are always after their parent, so walking backwards sums the counts bottom up
+    for(size_t i = Nodes.size(); i-- > 0;)
+    {
+        Node& node = Nodes[i];
+
+        if(node.IsLeaf())
+            continue;
+
+        node.NumParticles = 0;
+
+        for(uint32_t c = node.FirstChild; c < node.FirstChild + 8; ++c)
+            node.NumParticles += Nodes[c].NumParticles;
+    }
+
+    CalculateMass();
+
+    return static_cast<uint32_t>(Moved.size());
+}
+
+void LinearOctree::Reset(const BoundingCube& bounds, const ParticleStore& store)
+{
+    Bounds = bounds;
+    Store = &store;
+    NumParticles = static_cast<uint32_t>(store.Size());
+    NumInside = NumParticles;
+
+    // Both arrays keep their capacity, so after the first frame a rebuild doesn't allocate
+    Nodes.clear();
+    NextParticle.assign(NumParticles, NullIndex);
+
+    float halfSize = (bounds.BottomRight.x - bounds.TopLeft.x) / 2;
+    CreateNode(bounds.TopLeft + Vec3<>(halfSize, halfSize, halfSize), halfSize, 0);
+}
+
+uint32_t LinearOctree::CreateNode(Vec3<> centre, float halfSize, uint32_t depth)
+{
+    Node node;
+    node.Centre = centre;
+    node.HalfSize = halfSize;
+    node.TotalMass = 0.0;
+    node.OpenDistanceSq = 0.0f;
+    node.FirstChild = NullIndex;
+    node.FirstParticle = NullIndex;
+    node.NumParticles = 0;
+    node.Depth = depth;
+
+    Nodes.push_back(node);
+
+    return static_cast<uint32_t>(Nodes.size() - 1);
+}
+
+uint32_t LinearOctree::GetOctant(const Node& node, uint32_t particle) const
+{
+    return (Store->PosX[particle] >= node.Centre.x ? 1 : 0) |
+           (Store->PosY[particle] >= node.Centre.y ? 2 : 0) |
+           (Store->PosZ[particle] >= node.Centre.z ? 4 : 0);
+}
+
+bool LinearOctree::Contains(const Node& node, uint32_t particle) const
+{
+    // Same sides as GetOctant, a particle on a face belongs to the cell above it
+    return Store->PosX[particle] >= node.Centre.x - node.HalfSize && Store->PosX[particle] < node.Centre.x + node.HalfSize &&
+           Store->PosY[particle] >= node.Centre.y - node.HalfSize && Store->PosY[particle] < node.Centre.y + node.HalfSize &&
+           Store->PosZ[particle] >= node.Centre.z - node.HalfSize && Store->PosZ[particle] < node.Centre.z + node.HalfSize;
+}
+
+void LinearOctree::Split(uint32_t index)
+{
+    // Copy what we need as creating the children may reallocate the node array
+    Vec3<> centre = Nodes[index].Centre;
+    float half = Nodes[index].HalfSize / 2;
+    uint32_t depth = Nodes[index].Depth + 1;
+
+    uint32_t first = static_cast<uint32_t>(Nodes.size());
+
+    // Same child order as Octree::Split, x varies fastest then y then z
+    for(uint32_t i = 0; i < 8; ++i)
+    {
+        Vec3<> offset((i & 1) ? half : -half,
+                      (i & 2) ? half : -half,
+                      (i & 4) ? half : -half);
+
+        CreateNode(centre + offset, half, depth);
+    }
+
+    Nodes[index].FirstChild = first;
+}
+
+void LinearOctree::Add(uint32_t particle)
+{
+    uint32_t index = 0;
+
+    while(true)
+    {
+        Node& node = Nodes[index];
+
+        // Node has already split, descend into the correct child
+        if(!node.IsLeaf())
+        {
+            ++node.NumParticles;
+            index = node.FirstChild + GetOctant(node, particle);
+        }
+        // Empty leaf, or too deep to split any further so keep a list
+        else if(node.NumParticles == 0 || node.Depth >= MaxDepth)
+        {
+            NextParticle[particle] = node.FirstParticle;
+            node.FirstParticle = particle;
+            ++node.NumParticles;
+
+            return;
+        }
+        // Particle occupied, split this node and move the previous particle down
+        else
+        {
+            uint32_t existing = node.FirstParticle;
+
+            Split(index);
+
+            Node& parent = Nodes[index];
+            parent.FirstParticle = NullIndex;
+
+            Node& child = Nodes[parent.FirstChild + GetOctant(parent, existing)];
+            child.FirstParticle = existing;
+            child.NumParticles = 1;
+        }
+    }
+}
+
+void LinearOctree::CalculateMass()
+{
+    // Read once, the UI may toggle it mid step and the walks need the quadrupoles this pass made
+    Quadrupolar = UseQuadrupoles;
+
+    if(Quadrupolar)
+        Quadrupoles.resize(Nodes.size());
+
+    // Children are always created after their parent, so walking backwards is a bottom up pass
+    for(size_t i = Nodes.size(); i-- > 0;)
+    {
+        Node& node = Nodes[i];
+
+        double totalMass = 0.0;
+        Vec3d centre;
+
+        if(node.IsLeaf())
+        {
+            for(uint32_t p = node.FirstParticle; p != NullIndex; p = NextParticle[p])
+            {
+                double mass = Store->Mass[p];
+
+                totalMass += mass;
+                centre += Vec3d(Store->PosX[p], Store->PosY[p], Store->PosZ[p]) * mass;
+            }
+        }
+        else
+        {
+            for(uint32_t c = node.FirstChild; c < node.FirstChild + 8; ++c)
+            {
+                const Node& child = Nodes[c];
+
+                totalMass += child.TotalMass;
+                centre += Vec3d(child.CentreOfMass.x, child.CentreOfMass.y, child.CentreOfMass.z) * child.TotalMass;
+            }
+        }
+
+        node.TotalMass = totalMass;
+
+        if(totalMass > 0.0)
+            node.CentreOfMass = (centre / totalMass).AsVector3();
+
+        if(Quadrupolar)
+            CalculateQuadrupole(static_cast<uint32_t>(i));
+
+        float open = OpenDistance(node);
+        node.OpenDistanceSq = open * open;
+    }
+}
+
+void LinearOctree::CalculateQuadrupole(uint32_t index)
+{
+    const Node& node = Nodes[index];
+    const auto& com = node.CentreOfMass;
+
+    Quadrupole q = {};
+
+    // Adds the quadrupole of a point mass at offset (x, y, z) from the centre of mass
+    auto addPoint = [&q](double mass, double x, double y, double z) {
+        double r2 = x * x + y * y + z * z;
+
+        q.XX += mass * (3.0 * x * x - r2);
+        q.YY += mass * (3.0 * y * y - r2);
+        q.ZZ += mass * (3.0 * z * z - r2);
+        q.XY += mass * 3.0 * x * y;
+        q.XZ += mass * 3.0 * x * z;
+        q.YZ += mass * 3.0 * y * z;
+    };
+
+    if(node.IsLeaf())
+    {
+        for(uint32_t p = node.FirstParticle; p != NullIndex; p = NextParticle[p])
+        {
+            addPoint(Store->Mass[p], Store->PosX[p] - com.x, Store->PosY[p] - com.y, Store->PosZ[p] - com.z);
+        }
+    }
+    else
+    {
+        // Parallel axis theorem, each child's tensor plus its mass at its own centre
+        for(uint32_t c = node.FirstChild; c < node.FirstChild + 8; ++c)
+        {
+            const Node& child = Nodes[c];
+
+            if(child.TotalMass <= 0.0)
+                continue;
+
+            const Quadrupole& cq = Quadrupoles[c];
+
+            q.XX += cq.XX;
+            q.YY += cq.YY;
+            q.ZZ += cq.ZZ;
+            q.XY += cq.XY;
+            q.XZ += cq.XZ;
+            q.YZ += cq.YZ;
+
+            addPoint(child.TotalMass, child.CentreOfMass.x - com.x, child.CentreOfMass.y - com.y, child.CentreOfMass.z - com.z);
+        }
+    }
+
+    Quadrupoles[index] = q;
+}
+
+float LinearOctree::OpenDistance(const Node& node) const
+{
+    const float theta = static_cast<float>(Octree::Theta);
+    const float size = node.HalfSize * 2;
+
+    float dx = std::abs(node.CentreOfMass.x - node.Centre.x);
+    float dy = std::abs(node.CentreOfMass.y - node.Centre.y);
+    float dz = std::abs(node.CentreOfMass.z - node.Centre.z);
+
+    float bx = dx + node.HalfSize;
+    float by = dy + node.HalfSize;
+    float bz = dz + node.HalfSize;
+    float bmax = std::sqrt(bx * bx + by * by + bz * bz);
+
+    // Closer than this a particle could be inside the node or within the softening length of its particles
+    float nearest = bmax + static_cast<float>(std::sqrt(Phys::S));
+
+    switch(Criterion)
+    {
+        case EOpeningCriterion::Barnes:
+            return (std::max)(size / theta + std::sqrt(dx * dx + dy * dy + dz * dz), nearest);
+
+        case EOpeningCriterion::Bmax:
+            return (std::max)(bmax / theta, nearest);
+
+        default:
+            return (std::max)(size / theta, nearest);
+    }
+}
+
+Vec3d LinearOctree::CalculateForce(uint32_t particle, uint32_t* interactions) const
+{
+    Vec3d force;
+
+    if(Nodes.empty())
+        return force;
+
+    const auto p = Store->GetPosition(particle);
+    const double mass = Store->Mass[particle];
+
+    uint32_t stack[8 * (MaxDepth + 1)];
+    int top = 0;
+    uint32_t count = 0;
+
+    stack[top++] = 0;
+
+    while(top > 0)
+    {
+        uint32_t index = stack[--top];
+        const Node& node = Nodes[index];
+
+        if(node.NumParticles == 0)
+            continue;
+
+        bool isFar = node.NumParticles > 1 && (p - node.CentreOfMass).LengthSquared() > node.OpenDistanceSq;
+
+        if(isFar)
+        {
+            force += Attract(p, mass, node.CentreOfMass, node.TotalMass);
+
+            if(Quadrupolar)
+                force += AttractQuadrupole(p, mass, node.CentreOfMass, Quadrupoles[index]);
+
+            ++count;
+        }
+        else if(node.IsLeaf())
+        {
+            for(uint32_t q = node.FirstParticle; q != NullIndex; q = NextParticle[q])
+            {
+                if(q != particle)
+                {
+                    force += Attract(p, mass, Store->GetPosition(q), Store->Mass[q]);
+                    ++count;
+                }
+            }
+        }
+        else
+        {
+            // Push in reverse so children are visited in the same order as Octree
+            for(uint32_t c = 8; c-- > 0;)
+                stack[top++] = node.FirstChild + c;
+        }
+    }
+
+    if(interactions)
+        *interactions += count;
+
+    return force;
+}
+
+Vec3d LinearOctree::CalculateDirectForce(uint32_t particle, uint32_t begin, uint32_t end) const
+{
+    Vec3d force;
+
+    const auto p = Store->GetPosition(particle);
+    const double mass = Store->Mass[particle];
+
+    for(uint32_t q = begin; q < end; ++q)
+    {
+        if(q != particle)
+            force += Attract(p, mass, Store->GetPosition(q), Store->Mass[q]);
+    }
+
+    return force;
+}
+
+void LinearOctree::GetLeaves(std::vector<uint32_t>& leaves) const
+{
+    leaves.clear();
+
+    if(Nodes.empty())
+        return;
+
+    uint32_t stack[8 * (MaxDepth + 1)];
+    int top = 0;
+
+    stack[top++] = 0;
+
+    while(top > 0)
+    {
+        uint32_t index = stack[--top];
+        const Node& node = Nodes[index];
+
+        if(node.IsLeaf())
+        {
+            leaves.push_back(index);
+            continue;
+        }
+
+        // Pushed in reverse so octant 0 is visited first
+        for(uint32_t c = 8; c-- > 0;)
+            stack[top++] = node.FirstChild + c;
+    }
+}
+
+void LinearOctree::GetInteractions(uint32_t leaf, std::vector<uint32_t>& cells, std::vector<uint32_t>& leaves) const
+{
+    cells.clear();
+    leaves.clear();
+
+    const Node& bucket = Nodes[leaf];
+    const auto& centre = bucket.CentreOfMass;
+
+    float radius = 0.0f;
+
+    for(uint32_t p = bucket.FirstParticle; p != NullIndex; p = NextParticle[p])
+        radius = (std::max)(radius, (Store->GetPosition(p) - centre).Length());
+
+    uint32_t stack[8 * (MaxDepth + 1)];
+    int top = 0;
+
+    stack[top++] = 0;
+
+    while(top > 0)
+    {
+        uint32_t index = stack[--top];
+        const Node& node = Nodes[index];
+
+        if(node.NumParticles == 0)
+            continue;
+
+        // Far for every particle in the bucket when even the closest point of its sphere is far
+        float distance = (centre - node.CentreOfMass).Length() - radius;
+        bool isFar = index != leaf && node.NumParticles > 1 && distance > 0.0f && distance * distance > node.OpenDistanceSq;
+
+        if(isFar)
+        {
+            cells.push_back(index);
+        }
+        else if(node.IsLeaf())
+        {
+            leaves.push_back(index);
+        }
+        else
+        {
+            for(uint32_t c = 8; c-- > 0;)
+                stack[top++] = node.FirstChild + c;
+        }
+    }
+}
+
+Vec3d LinearOctree::CalculateQuadrupoleForce(uint32_t node, uint32_t particle) const
+{
+    return AttractQuadrupole(Store->GetPosition(particle), Store->Mass[particle], Nodes[node].CentreOfMass, Quadrupoles[node]);
+}
+
+#ifndef NBODY_HEADLESS
+void LinearOctree::RenderDebug(Cube* cube, DirectX::GeometricPrimitive* sphere, DirectX::SimpleMath::Matrix view, DirectX::SimpleMath::Matrix proj)
+{
+    for(const auto& node : Nodes)
+    {
+        if(node.IsLeaf() && node.NumParticles > 0)
+        {
+            auto pos = DirectX::SimpleMath::Vector3(node.Centre.x, node.Centre.y, node.Centre.z);
+            cube->Render(pos, node.HalfSize * 2, view * proj);
+        }
+    }
+}
+#endif
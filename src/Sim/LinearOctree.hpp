@@ -0,0 +1,184 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+
+#include "Octree.hpp"
+#include "Core/Vec3.hpp"
+#include "ParticleStore.hpp"
+#include "Core/TaskScheduler.hpp"
+
+#ifndef NBODY_HEADLESS
+#include <GeometricPrimitive.h>
+#include "Render/Model/Cube.hpp"
+#endif
+
+/*
+    When a node is far enough from a particle to use its multipole, with
+    r the distance from the particle to the centre of mass, d the node size
+    and delta the offset of the centre of mass from the node centre.
+    Theta (Octree::Theta) is the size to distance ratio, larger is looser.
+    Whatever the criterion a node is never far within bmax + sqrt(S) of its
+    centre of mass, where a particle could be inside it or within the
+    softening length of its particles and the multipole no longer holds.
+
+    Errors are relative to each particle's force, so they're largest where
+    the pulls on a particle nearly cancel. The star system's bodies all lie
+    on one line and need a Theta around 0.1 to get within a few percent.
+*/
+enum class EOpeningCriterion
+{
+    Classic,    // r > d / Theta
+    Barnes,     // r > d / Theta + delta
+    Bmax        // r > bmax / Theta, bmax the furthest corner from the centre of mass
+};
+
+/*
+    Octree stored as one flat node array which is reused between builds.
+    The eight children of a node are stored contiguously and referenced by
+    the 32-bit index of the first child.
+*/
+class LinearOctree
+{
+    public:
+        static const uint32_t NullIndex = 0xFFFFFFFF;
+        static const int MaxDepth = 32;
+
+        // Set from the UI thread while a simulation thread may be reading them
+        static std::atomic<EOpeningCriterion> Criterion;
+        static std::atomic<bool> UseQuadrupoles;
+
+        // Traceless quadrupole sum m (3 x x^T - |x|^2 I) about the centre of mass
+        struct Quadrupole
+        {
+            double XX, YY, ZZ, XY, XZ, YZ;
+        };
+
+        struct Node
+        {
+            Vec3<> Centre;
+            float HalfSize;
+
+            DirectX::SimpleMath::Vector3 CentreOfMass;
+            double TotalMass;
+
+            // Squared distance from the centre of mass past which the node is far, set by the opening criterion
+            float OpenDistanceSq;
+
+            uint32_t FirstChild;
+            uint32_t FirstParticle;
+            uint32_t NumParticles;
+            uint32_t Depth;
+
+            bool IsLeaf() const { return FirstChild == NullIndex; }
+        };
+
+        void Build(const BoundingCube& bounds, const ParticleStore& store);
+
+        // Builds from a store already sorted by Morton key (see MortonSorter), keys past numSorted are ignored.
+        // Nodes with up to leafSize particles are not split. Every node's particles, not only a leaf's,
+        // are then the range [FirstParticle, FirstParticle + NumParticles) of the store
+        void BuildSorted(const BoundingCube& bounds, const ParticleStore& store, const std::vector<uint64_t>& keys, size_t numSorted, uint32_t leafSize = 1);
+
+        // Keeps the nodes of the last build, moves the particles which left their leaf into the leaf
+        // now containing them and recalculates the masses. The store must not have been reordered.
+        // Returns the number of particles moved, or NullIndex if one left the bounds and a build is needed.
+        // Leaves then hold their particles as a list (see GetNextParticle), no longer as a range
+        uint32_t Refit();
+
+        // Counts the nodes and particles interacted with into interactions when given
+        Vec3d CalculateForce(uint32_t particle, uint32_t* interactions = nullptr) const;
+
+        // Summed force of store entries [begin, end) on a particle, for the particles built outside the tree
+        Vec3d CalculateDirectForce(uint32_t particle, uint32_t begin, uint32_t end) const;
+
+        // Store entries past the sorted range BuildSorted was given, left out of the tree
+        uint32_t GetNumEscaped() const { return NumParticles - NumInside; }
+
+        // Adds the escaped particles to the forces already in store, which must be the store the tree
+        // was built over. They are summed directly onto each particle i for which active(i) holds,
+        // and an escaped particle gets the tree's force on it
+        template <class Active>
+        void AddEscapedForces(ParticleStore& store, TaskScheduler& scheduler, Active active) const;
+
+        // Every leaf, empty ones too, in Morton order. The node array isn't in that order, a node's
+        // children are created together when the build reaches it
+        void GetLeaves(std::vector<uint32_t>& leaves) const;
+
+        // One walk for every particle in a leaf, the opening test uses the nearest point of the
+        // leaf's bounding sphere. Far nodes go into cells, nodes to sum directly into leaves
+        void GetInteractions(uint32_t leaf, std::vector<uint32_t>& cells, std::vector<uint32_t>& leaves) const;
+
+        // Whether the last build or refit calculated quadrupoles, UseQuadrupoles as it was then
+        bool HasQuadrupoles() const { return Quadrupolar; }
+
+        // Quadrupole part of a far node's force on a particle, only valid with HasQuadrupoles
+        Vec3d CalculateQuadrupoleForce(uint32_t node, uint32_t particle) const;
+#ifndef NBODY_HEADLESS
+        void RenderDebug(Cube* cube, DirectX::GeometricPrimitive* sphere, DirectX::SimpleMath::Matrix view, DirectX::SimpleMath::Matrix proj);
+#endif
+
+        size_t GetNumNodes() const { return Nodes.size(); }
+        uint32_t GetNextParticle(uint32_t particle) const { return NextParticle[particle]; }
+        const std::vector<Node>& GetNodes() const { return Nodes; }
+
+    private:
+        struct BuildRange
+        {
+            uint32_t Node;
+            uint32_t Begin;
+            uint32_t End;
+        };
+
+        void Reset(const BoundingCube& bounds, const ParticleStore& store);
+        uint32_t CreateNode(Vec3<> centre, float halfSize, uint32_t depth);
+        uint32_t GetOctant(const Node& node, uint32_t particle) const;
+        void Split(uint32_t node);
+        void Add(uint32_t particle);
+        bool Contains(const Node& node, uint32_t particle) const;
+        void CalculateMass();
+        void CalculateQuadrupole(uint32_t index);
+        float OpenDistance(const Node& node) const;
+
+        BoundingCube Bounds;
+        const ParticleStore* Store = nullptr;
+        uint32_t NumParticles = 0;
+        uint32_t NumInside = 0;
+        bool Quadrupolar = false;
+
+        std::vector<Node> Nodes;
+        std::vector<Quadrupole> Quadrupoles;
+        std::vector<uint32_t> NextParticle;
+        std::vector<BuildRange> BuildStack;
+        std::vector<uint32_t> Moved;
+};
+
+template <class Active>
+void LinearOctree::AddEscapedForces(ParticleStore& store, TaskScheduler& scheduler, Active active) const
+{
+    if(NumInside == NumParticles)
+        return;
+
+    // Escaped particles are few (see Morton::MaxEscaped) and far out, so they're summed directly
+    // rather than stretching the tree. They see the tree as its far nodes
+    ParallelFor(scheduler, NumParticles, [&](size_t begin, size_t end, uint32_t) {
+        for(size_t i = begin; i < end; ++i)
+        {
+            if(!active(i))
+                continue;
+
+            const uint32_t p = static_cast<uint32_t>(i);
+            Vec3d force = CalculateDirectForce(p, NumInside, NumParticles);
+
+            if(p < NumInside)
+                force += Vec3d(store.ForceX[i], store.ForceY[i], store.ForceZ[i]);
+            else
+                force += CalculateForce(p);
+
+            store.ForceX[i] = force.x;
+            store.ForceY[i] = force.y;
+            store.ForceZ[i] = force.z;
+        }
+    });
+}
@@ -0,0 +1,297 @@
+#include "Morton.hpp"
+
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <algorithm>
+
+namespace
+{
+    // Spreads the lower 21 bits of v out so there are two zero bits between each one
+    inline uint64_t ExpandBits(uint64_t v)
+    {
+        v &= 0x1fffff;
+        v = (v | v << 32) & 0x1f00000000ffff;
+        v = (v | v << 16) & 0x1f0000ff0000ff;
+        v = (v | v << 8)  & 0x100f00f00f00f00f;
+        v = (v | v << 4)  & 0x10c30c30c30c30c3;
+        v = (v | v << 2)  & 0x1249249249249249;
+
+        return v;
+    }
+
+    // Fraction of the fitted size added on each side, so particles drifting out of
+    // the edge cells don't force a rebuild on the next refit
+    const float Margin = 1.0f / 32.0f;
+
+    struct Moments
+    {
+        double Count = 0.0;
+        double Sum[3] = { 0.0, 0.0, 0.0 };
+        double SumSq = 0.0;
+    };
+
+    struct AxisBounds
+    {
+        float Min[3] = {  std::numeric_limits<float>::max(),  std::numeric_limits<float>::max(),  std::numeric_limits<float>::max() };
+        float Max[3] = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+    };
+
+    inline bool IsFinite(const ParticleStore& store, size_t i)
+    {
+        return std::isfinite(store.PosX[i]) && std::isfinite(store.PosY[i]) && std::isfinite(store.PosZ[i]);
+    }
+}
+
+uint64_t Morton::Encode(uint32_t x, uint32_t y, uint32_t z)
+{
+    return ExpandBits(x) | (ExpandBits(y) << 1) | (ExpandBits(z) << 2);
+}
+
+uint64_t Morton::Key(const DirectX::SimpleMath::Vector3& position, const BoundingCube& bounds)
+{
+    const float size = bounds.BottomRight.x - bounds.TopLeft.x;
+    const uint32_t maxCell = (1U << BitsPerAxis) - 1;
+    const float cells = static_cast<float>(1U << BitsPerAxis);
+
+    float x = (position.x - bounds.TopLeft.x) / size;
+    float y = (position.y - bounds.TopLeft.y) / size;
+    float z = (position.z - bounds.TopLeft.z) / size;
+
+    // Same test as BoundingCube::Contains
+    if(x < 0.0f || y < 0.0f || z < 0.0f || x >= 1.0f || y >= 1.0f || z >= 1.0f)
+        return InvalidKey;
+
+    return Encode((std::min)(static_cast<uint32_t>(x * cells), maxCell),
+                  (std::min)(static_cast<uint32_t>(y * cells), maxCell),
+                  (std::min)(static_cast<uint32_t>(z * cells), maxCell));
+}
+
+BoundingCube Morton::FitBounds(const ParticleStore& store, TaskScheduler& scheduler)
+{
+    const size_t num = store.Size();
+    const size_t numChunks = (std::max)(static_cast<size_t>(scheduler.GetNumThreads()) * 4, static_cast<size_t>(1));
+
+    std::vector<Moments> chunkMoments(numChunks);
+
+    ForEachChunk(scheduler, num, numChunks, [&](size_t chunk, size_t begin, size_t end) {
+        Moments m;
+
+        for(size_t i = begin; i < end; ++i)
+        {
+            if(!IsFinite(store, i))
+                continue;
+
+            const double x = store.PosX[i], y = store.PosY[i], z = store.PosZ[i];
+
+            m.Count += 1.0;
+            m.Sum[0] += x;
+            m.Sum[1] += y;
+            m.Sum[2] += z;
+            m.SumSq += x * x + y * y + z * z;
+        }
+
+        chunkMoments[chunk] = m;
+    });
+
+    Moments total;
+
+    for(const auto& m : chunkMoments)
+    {
+        total.Count += m.Count;
+        total.SumSq += m.SumSq;
+
+        for(int axis = 0; axis < 3; ++axis)
+            total.Sum[axis] += m.Sum[axis];
+    }
+
+    if(total.Count == 0.0)
+        return { { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } };
+
+    double centroid[3], centroidSq = 0.0;
+
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        centroid[axis] = total.Sum[axis] / total.Count;
+        centroidSq += centroid[axis] * centroid[axis];
+    }
+
+    // By Markov's inequality on the squared radius no more than 1 / EscapeRadius^2 of the particles are further out
+    const double meanSq = (std::max)(total.SumSq / total.Count - centroidSq, 0.0);
+    const double escapeSq = EscapeRadius * EscapeRadius * meanSq;
+
+    std::vector<AxisBounds> chunkBounds(numChunks);
+    std::vector<std::vector<std::pair<double, uint32_t>>> chunkOutside(numChunks);
+
+    ForEachChunk(scheduler, num, numChunks, [&](size_t chunk, size_t begin, size_t end) {
+        AxisBounds bounds;
+        auto& outside = chunkOutside[chunk];
+
+        for(size_t i = begin; i < end; ++i)
+        {
+            if(!IsFinite(store, i))
+                continue;
+
+            const float p[3] = { store.PosX[i], store.PosY[i], store.PosZ[i] };
+            double distSq = 0.0;
+
+            for(int axis = 0; axis < 3; ++axis)
+                distSq += (p[axis] - centroid[axis]) * (p[axis] - centroid[axis]);
+
+            if(distSq > escapeSq)
+            {
+                outside.emplace_back(distSq, static_cast<uint32_t>(i));
+                continue;
+            }
+
+            for(int axis = 0; axis < 3; ++axis)
+            {
+                bounds.Min[axis] = (std::min)(bounds.Min[axis], p[axis]);
+                bounds.Max[axis] = (std::max)(bounds.Max[axis], p[axis]);
+            }
+        }
+
+        chunkBounds[chunk] = bounds;
+    });
+
+    AxisBounds bounds;
+    std::vector<std::pair<double, uint32_t>> outside;
+
+    for(size_t chunk = 0; chunk < numChunks; ++chunk)
+    {
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            bounds.Min[axis] = (std::min)(bounds.Min[axis], chunkBounds[chunk].Min[axis]);
+            bounds.Max[axis] = (std::max)(bounds.Max[axis], chunkBounds[chunk].Max[axis]);
+        }
+
+        outside.insert(outside.end(), chunkOutside[chunk].begin(), chunkOutside[chunk].end());
+    }
+
+    // Escaped particles are summed directly onto every particle, so only the furthest MaxEscaped
+    // are left out and the rest are taken back inside
+    if(outside.size() > MaxEscaped)
+    {
+        std::nth_element(outside.begin(), outside.begin() + MaxEscaped, outside.end(), [](const std::pair<double, uint32_t>& a, const std::pair<double, uint32_t>& b) {
+            return a.first > b.first;
+        });
+
+        for(size_t o = MaxEscaped; o < outside.size(); ++o)
+        {
+            const uint32_t i = outside[o].second;
+            const float p[3] = { store.PosX[i], store.PosY[i], store.PosZ[i] };
+
+            for(int axis = 0; axis < 3; ++axis)
+            {
+                bounds.Min[axis] = (std::min)(bounds.Min[axis], p[axis]);
+                bounds.Max[axis] = (std::max)(bounds.Max[axis], p[axis]);
+            }
+        }
+    }
+
+    // A cube around the box, so cells stay cubes, at least 1 across for coincident particles
+    float size = 1.0f;
+    float centre[3];
+
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        size = (std::max)(size, bounds.Max[axis] - bounds.Min[axis]);
+        centre[axis] = 0.5f * (bounds.Min[axis] + bounds.Max[axis]);
+    }
+
+    const float half = 0.5f * size * (1.0f + 2.0f * Margin);
+
+    return {
+        { centre[0] - half, centre[1] - half, centre[2] - half },
+        { centre[0] + half, centre[1] + half, centre[2] + half }
+    };
+}
+
+size_t MortonSorter::Sort(ParticleStore& store, const BoundingCube& bounds, TaskScheduler& scheduler)
+{
+    const size_t num = store.Size();
+
+    Keys.resize(num);
+    TempKeys.resize(num);
+    Indices.resize(num);
+    TempIndices.resize(num);
+    TempStore.Resize(num);
+
+    ParallelFor(scheduler, num, [&](size_t begin, size_t end, uint32_t) {
+        for(size_t i = begin; i < end; ++i)
+        {
+            Keys[i] = Morton::Key(store.GetPosition(i), bounds);
+            Indices[i] = static_cast<uint32_t>(i);
+        }
+    });
+
+    RadixSort(scheduler);
+
+    ParallelFor(scheduler, num, [&](size_t begin, size_t end, uint32_t) {
+        TempStore.Gather(store, Indices, begin, end);
+    });
+
+    store.Swap(TempStore);
+
+    return std::lower_bound(Keys.begin(), Keys.end(), Morton::InvalidKey) - Keys.begin();
+}
+
+void MortonSorter::RadixSort(TaskScheduler& scheduler)
+{
+    const size_t num = Keys.size();
+    const size_t numChunks = scheduler.GetNumThreads();
+
+    Histograms.resize(numChunks);
+
+    // Least significant digit first, 8 passes of 8 bits
+    for(int shift = 0; shift < 64; shift += 8)
+    {
+        ForEachChunk(scheduler, num, numChunks, [&](size_t chunk, size_t begin, size_t end) {
+            auto& histogram = Histograms[chunk];
+            histogram.fill(0);
+
+            for(size_t i = begin; i < end; ++i)
+                ++histogram[(Keys[i] >> shift) & 0xFF];
+        });
+
+        // Turn the counts into the position each chunk starts writing each digit to,
+        // chunks are in array order so the sort stays stable
+        size_t offset = 0;
+        bool allSameDigit = false;
+
+        for(size_t digit = 0; digit < 256 && !allSameDigit; ++digit)
+        {
+            size_t total = 0;
+
+            for(size_t chunk = 0; chunk < numChunks; ++chunk)
+                total += Histograms[chunk][digit];
+
+            allSameDigit = total == num;
+
+            for(size_t chunk = 0; chunk < numChunks; ++chunk)
+            {
+                size_t count = Histograms[chunk][digit];
+                Histograms[chunk][digit] = offset;
+                offset += count;
+            }
+        }
+
+        // Nothing would move, common for the upper bits of clustered data
+        if(allSameDigit)
+            continue;
+
+        ForEachChunk(scheduler, num, numChunks, [&](size_t chunk, size_t begin, size_t end) {
+            auto& offsets = Histograms[chunk];
+
+            for(size_t i = begin; i < end; ++i)
+            {
+                size_t dst = offsets[(Keys[i] >> shift) & 0xFF]++;
+                TempKeys[dst] = Keys[i];
+                TempIndices[dst] = Indices[i];
+            }
+        });
+
+        Keys.swap(TempKeys);
+        Indices.swap(TempIndices);
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+#include "Octree.hpp"
+#include "Core/TaskScheduler.hpp"
+#include "ParticleStore.hpp"
+
+namespace Morton
+{
+    // 21 bits per axis gives a 63 bit key, the top bit is left free for keys outside the bounds
+    const int BitsPerAxis = 21;
+    const uint64_t InvalidKey = ~0ULL;
+
+    uint64_t Encode(uint32_t x, uint32_t y, uint32_t z);
+    uint64_t Key(const DirectX::SimpleMath::Vector3& position, const BoundingCube& bounds);
+
+    // Particles further than this many RMS radii from the centroid escape the bounds, at most 1/256 of them
+    const double EscapeRadius = 16.0;
+
+    // Of those only the furthest this many escape, the others are kept inside
+    const size_t MaxEscaped = 64;
+
+    // Smallest cube, plus a margin, around the particles which haven't escaped. Two parallel
+    // reductions, one for the centroid and RMS radius, one for the min/max of the rest
+    BoundingCube FitBounds(const ParticleStore& store, TaskScheduler& scheduler);
+
+    // Octant (0-7) of the key at the given depth, matching LinearOctree's child order
+    inline uint32_t Octant(uint64_t key, int depth)
+    {
+        return static_cast<uint32_t>(key >> (3 * (BitsPerAxis - 1 - depth))) & 7;
+    }
+}
+
+/*
+    Computes Morton keys for every particle, radix sorts them and reorders
+    the store so particles that are close in space are close in memory.
+    All buffers are kept between calls.
+*/
+class MortonSorter
+{
+    public:
+        // Returns the number of particles inside the bounds, which are moved to the front of the store
+        size_t Sort(ParticleStore& store, const BoundingCube& bounds, TaskScheduler& scheduler);
+
+        const std::vector<uint64_t>& GetKeys() const { return Keys; }
+
+    private:
+        void RadixSort(TaskScheduler& scheduler);
+
+        std::vector<uint64_t> Keys, TempKeys;
+        std::vector<uint32_t> Indices, TempIndices;
+        ParticleStore TempStore;
+        std::vector<std::array<size_t, 256>> Histograms;
+};
@@ -0,0 +1,314 @@
+#include "Multipole.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+const int MultipoleExpansion::SeriesTerms;
+
+namespace
+{
+    // (S / r^2)^t below which series term t is dropped, its derivatives are never more than a few
+    // hundred times larger relative to those of 1/r up to MaxOrder
+    const double NegligibleTerm = 1e-12;
+
+    double Binomial(int n, int k)
+    {
+        double result = 1.0;
+
+        for(int i = 1; i <= k; ++i)
+            result = result * (n - k + i) / i;
+
+        return result;
+    }
+}
+
+void MultipoleExpansion::TermList::Add(uint16_t a, uint16_t b, uint16_t out, double coefficient)
+{
+    Terms.push_back({ a, b, out, coefficient });
+}
+
+void MultipoleExpansion::TermList::Sort(size_t numOutputs)
+{
+    std::stable_sort(Terms.begin(), Terms.end(), [](const Term& x, const Term& y) {
+        return x.Out < y.Out;
+    });
+
+    Begin.assign(numOutputs + 1, 0);
+
+    for(const auto& term : Terms)
+        ++Begin[term.Out + 1];
+
+    for(size_t i = 0; i < numOutputs; ++i)
+        Begin[i + 1] += Begin[i];
+}
+
+void MultipoleExpansion::TermList::Apply(const double* a, const double* b, double* out) const
+{
+    const size_t numOutputs = Begin.size() - 1;
+
+    for(size_t o = 0; o < numOutputs; ++o)
+    {
+        double sum = 0.0;
+
+        for(uint32_t t = Begin[o]; t < Begin[o + 1]; ++t)
+            sum += Terms[t].Coefficient * a[Terms[t].A] * b[Terms[t].B];
+
+        out[o] += sum;
+    }
+}
+
+MultipoleExpansion::MultipoleExpansion(int order)
+{
+    SetOrder(order);
+}
+
+void MultipoleExpansion::SetOrder(int order)
+{
+    order = (std::max)(0, (std::min)(order, MaxOrder));
+
+    if(order == Order && !Exponents.empty())
+        return;
+
+    Order = order;
+    Exponents.clear();
+
+    for(int n = 0; n <= Order; ++n)
+    {
+        for(int i = n; i >= 0; --i)
+        {
+            for(int j = n - i; j >= 0; --j)
+            {
+                int k = n - i - j;
+
+                IndexTable[i][j][k] = static_cast<int>(Exponents.size());
+                Exponents.push_back({ static_cast<uint8_t>(i), static_cast<uint8_t>(j), static_cast<uint8_t>(k) });
+            }
+        }
+    }
+
+    M2MTerms.Terms.clear();
+    M2LTerms.Terms.clear();
+    L2LTerms.Terms.clear();
+    GradientTerms.Terms.clear();
+    Recurrences.clear();
+
+    const int num = static_cast<int>(Exponents.size());
+
+    for(const auto& e : Exponents)
+    {
+        const int n = e[0] + e[1] + e[2];
+
+        Recurrence r;
+
+        for(int t = 0; t < SeriesTerms; ++t)
+        {
+            r.First[t] = n > 0 ? -(2.0 * n + 2.0 * t - 1.0) / n : 0.0;
+            r.Second[t] = n > 0 ? -(n + 2.0 * t - 1.0) / n : 0.0;
+        }
+
+        for(int i = 0; i < 3; ++i)
+        {
+            int k[3] = { e[0], e[1], e[2] };
+
+            k[i] -= 1;
+            r.Lower[i] = k[i] >= 0 ? Index(k[0], k[1], k[2]) : -1;
+
+            k[i] -= 1;
+            r.Lower2[i] = k[i] >= 0 ? Index(k[0], k[1], k[2]) : -1;
+        }
+
+        Recurrences.push_back(r);
+    }
+
+    for(int a = 0; a < num; ++a)
+    {
+        const auto& ea = Exponents[a];
+        const int degreeA = ea[0] + ea[1] + ea[2];
+
+        for(int b = 0; b < num; ++b)
+        {
+            const auto& eb = Exponents[b];
+            const int degreeB = eb[0] + eb[1] + eb[2];
+
+            // M2L: L_n += (-1)^|k| (k+n choose k) M_k a_(k+n), with a = k, b = n
+            if(degreeA + degreeB <= Order)
+            {
+                double binom = Binomial(ea[0] + eb[0], ea[0]) *
+                               Binomial(ea[1] + eb[1], ea[1]) *
+                               Binomial(ea[2] + eb[2], ea[2]);
+
+                M2LTerms.Add(static_cast<uint16_t>(a),
+                             static_cast<uint16_t>(Index(ea[0] + eb[0], ea[1] + eb[1], ea[2] + eb[2])),
+                             static_cast<uint16_t>(b),
+                             (degreeA % 2 ? -1.0 : 1.0) * binom);
+            }
+
+            // Shifts pair every exponent with the exponents it dominates, a >= b
+            if(eb[0] > ea[0] || eb[1] > ea[1] || eb[2] > ea[2])
+                continue;
+
+            double binom = Binomial(ea[0], eb[0]) * Binomial(ea[1], eb[1]) * Binomial(ea[2], eb[2]);
+            uint16_t diff = static_cast<uint16_t>(Index(ea[0] - eb[0], ea[1] - eb[1], ea[2] - eb[2]));
+
+            // M2M: M_k += (k choose q) M'_q d^(k-q), with k = a, q = b
+            M2MTerms.Add(static_cast<uint16_t>(b), diff, static_cast<uint16_t>(a), binom);
+
+            // L2L: L'_q += (n choose q) L_n d^(n-q), with n = a, q = b
+            L2LTerms.Add(static_cast<uint16_t>(a), diff, static_cast<uint16_t>(b), binom);
+        }
+
+        // Gradient: d/dy_axis of L_n y^n = n_axis L_n y^(n - e_axis)
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            if(ea[axis] == 0)
+                continue;
+
+            std::array<int, 3> lower = { ea[0], ea[1], ea[2] };
+            --lower[axis];
+
+            GradientTerms.Add(static_cast<uint16_t>(a),
+                              static_cast<uint16_t>(Index(lower[0], lower[1], lower[2])),
+                              static_cast<uint16_t>(axis),
+                              static_cast<double>(ea[axis]));
+        }
+    }
+
+    M2MTerms.Sort(Exponents.size());
+    M2LTerms.Sort(Exponents.size());
+    L2LTerms.Sort(Exponents.size());
+    GradientTerms.Sort(3);
+}
+
+void MultipoleExpansion::Powers(const Vec3d& offset, double* out) const
+{
+    double px[MaxOrder + 1], py[MaxOrder + 1], pz[MaxOrder + 1];
+    px[0] = py[0] = pz[0] = 1.0;
+
+    for(int i = 1; i <= Order; ++i)
+    {
+        px[i] = px[i - 1] * offset.x;
+        py[i] = py[i - 1] * offset.y;
+        pz[i] = pz[i - 1] * offset.z;
+    }
+
+    for(size_t i = 0; i < Exponents.size(); ++i)
+        out[i] = px[Exponents[i][0]] * py[Exponents[i][1]] * pz[Exponents[i][2]];
+}
+
+double MultipoleExpansion::GetSeriesError(double distanceSq) const
+{
+    // The first term left out, S^3 / (7 r^7), against 1/r
+    const double ratio = Softening / distanceSq;
+
+    return ratio * ratio * ratio / 7.0;
+}
+
+void MultipoleExpansion::Derivatives(const Vec3d& r, double* out) const
+{
+    const double r2 = r.x * r.x + r.y * r.y + r.z * r.z;
+    const double invR2 = 1.0 / r2;
+    const double axis[3] = { r.x, r.y, r.z };
+
+    // Each series term r^-(2t + 1) has its own derivatives, summed weighted by (-S)^t / (2t + 1).
+    // Far out the later terms are negligible against 1/r and are left out
+    int numTerms = 1;
+
+    for(double ratio = Softening * invR2, size = ratio; numTerms < SeriesTerms && size > NegligibleTerm; size *= ratio)
+        ++numTerms;
+
+    double terms[SeriesTerms][MaxCoefficients];
+    double weights[SeriesTerms];
+
+    terms[0][0] = std::sqrt(invR2);
+    weights[0] = 1.0;
+
+    for(int t = 1; t < numTerms; ++t)
+    {
+        terms[t][0] = terms[t - 1][0] * invR2;
+        weights[t] = weights[t - 1] * -Softening * (2.0 * t - 1.0) / (2.0 * t + 1.0);
+    }
+
+    out[0] = 0.0;
+
+    for(int t = 0; t < numTerms; ++t)
+        out[0] += weights[t] * terms[t][0];
+
+    // For r^-nu, n r^2 a_k = -(2n + nu - 2) sum r_i a_(k - e_i) - (n + nu - 2) sum a_(k - 2e_i)
+    for(size_t idx = 1; idx < Exponents.size(); ++idx)
+    {
+        const Recurrence& rec = Recurrences[idx];
+
+        out[idx] = 0.0;
+
+        for(int t = 0; t < numTerms; ++t)
+        {
+            const double* a = terms[t];
+            double first = 0.0, second = 0.0;
+
+            for(int i = 0; i < 3; ++i)
+            {
+                if(rec.Lower[i] >= 0)
+                    first += axis[i] * a[rec.Lower[i]];
+
+                if(rec.Lower2[i] >= 0)
+                    second += a[rec.Lower2[i]];
+            }
+
+            terms[t][idx] = (rec.First[t] * first + rec.Second[t] * second) * invR2;
+            out[idx] += weights[t] * terms[t][idx];
+        }
+    }
+}
+
+void MultipoleExpansion::P2M(const Vec3d& centre, const ParticleStore& store, size_t begin, size_t end, double* multipole) const
+{
+    double powers[MaxCoefficients];
+
+    std::fill(multipole, multipole + Exponents.size(), 0.0);
+
+    for(size_t p = begin; p < end; ++p)
+    {
+        Vec3d offset(store.PosX[p] - centre.x, store.PosY[p] - centre.y, store.PosZ[p] - centre.z);
+        Powers(offset, powers);
+
+        const double mass = store.Mass[p];
+
+        for(size_t i = 0; i < Exponents.size(); ++i)
+            multipole[i] += mass * powers[i];
+    }
+}
+
+void MultipoleExpansion::M2M(const double* child, const Vec3d& offset, double* parent) const
+{
+    double powers[MaxCoefficients];
+    Powers(offset, powers);
+
+    M2MTerms.Apply(child, powers, parent);
+}
+
+void MultipoleExpansion::M2L(const double* multipole, const Vec3d& offset, double* local) const
+{
+    double derivatives[MaxCoefficients];
+    Derivatives(offset, derivatives);
+
+    M2LTerms.Apply(multipole, derivatives, local);
+}
+
+void MultipoleExpansion::L2L(const double* parent, const Vec3d& offset, double* child) const
+{
+    double powers[MaxCoefficients];
+    Powers(offset, powers);
+
+    L2LTerms.Apply(parent, powers, child);
+}
+
+Vec3d MultipoleExpansion::L2P(const double* local, const Vec3d& offset) const
+{
+    double powers[MaxCoefficients];
+    Powers(offset, powers);
+
+    double gradient[3] = { 0.0, 0.0, 0.0 };
+    GradientTerms.Apply(local, powers, gradient);
+
+    return Vec3d(gradient[0], gradient[1], gradient[2]);
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+#include "Core/Vec3.hpp"
+#include "ParticleStore.hpp"
+
+/*
+    Cartesian Taylor expansions of the 1/r potential, truncated at a total
+    order of at most MaxOrder. A node's coefficients are stored contiguously
+    in one array of GetNumCoefficients() doubles, ordered by total degree.
+
+    With a softening S the potential expanded is that of the softened force
+    1 / (r^2 + S) (see Phys::Gravity) instead, arctan(sqrt(S) / r) / sqrt(S).
+    It's taken as the first SeriesTerms terms of its series in S / r^2,
+    1/r - S / (3 r^3) + S^2 / (5 r^5), so M2L offsets must be well outside
+    sqrt(S), see GetSeriesError.
+
+    Multipoles are the raw moments M_k = sum m (x - c)^k of a node's particles
+    about its centre c, locals are Taylor coefficients so the potential near
+    a centre z is phi(z + y) = sum L_n y^n.
+*/
+class MultipoleExpansion
+{
+    public:
+        static const int MaxOrder = 8;
+        static const int MaxCoefficients = (MaxOrder + 1) * (MaxOrder + 2) * (MaxOrder + 3) / 6;
+
+        MultipoleExpansion(int order = 4);
+
+        void SetOrder(int order);
+        int GetOrder() const { return Order; }
+
+        // S of the softened force, 0 for the plain 1/r potential
+        void SetSoftening(double softening) { Softening = softening; }
+        double GetSoftening() const { return Softening; }
+
+        // Relative error of the truncated series at a squared distance, 0 without softening
+        double GetSeriesError(double distanceSq) const;
+        size_t GetNumCoefficients() const { return Exponents.size(); }
+
+        // Moments of the particles [begin, end) of the store about centre
+        void P2M(const Vec3d& centre, const ParticleStore& store, size_t begin, size_t end, double* multipole) const;
+
+        // Adds a child's multipole to its parent's, offset is child centre - parent centre
+        void M2M(const double* child, const Vec3d& offset, double* parent) const;
+
+        // Adds the field of a multipole to a local expansion, offset is local centre - multipole centre
+        void M2L(const double* multipole, const Vec3d& offset, double* local) const;
+
+        // Adds a parent's local expansion to its child's, offset is child centre - parent centre
+        void L2L(const double* parent, const Vec3d& offset, double* child) const;
+
+        // Gradient of the potential at offset from the local expansion's centre
+        Vec3d L2P(const double* local, const Vec3d& offset) const;
+
+    private:
+        static const int SeriesTerms = 3;
+
+        // out[Out] += Coefficient * a[A] * b[B]
+        struct Term
+        {
+            uint16_t A, B, Out;
+            double Coefficient;
+        };
+
+        // Terms grouped by output so each output is summed in a register
+        struct TermList
+        {
+            std::vector<Term> Terms;
+            std::vector<uint32_t> Begin;
+
+            void Add(uint16_t a, uint16_t b, uint16_t out, double coefficient);
+            void Sort(size_t numOutputs);
+            void Apply(const double* a, const double* b, double* out) const;
+        };
+
+        // Indices of k - e_i and k - 2e_i for the derivative recurrence, -1 where k_i is too small,
+        // and for each series term r^-(2t + 1) the factors -(2n + 2t - 1) / n and -(n + 2t - 1) / n of the two sums
+        struct Recurrence
+        {
+            double First[SeriesTerms], Second[SeriesTerms];
+            int Lower[3];
+            int Lower2[3];
+        };
+
+        int Index(int i, int j, int k) const { return IndexTable[i][j][k]; }
+
+        // out[Index(k)] = offset^k for every exponent up to the order
+        void Powers(const Vec3d& offset, double* out) const;
+
+        // out[Index(k)] = d^k phi(r) / k! for the potential phi being expanded, built with the usual recurrence on |k|
+        void Derivatives(const Vec3d& r, double* out) const;
+
+        int Order = 0;
+        double Softening = 0.0;
+
+        std::vector<std::array<uint8_t, 3>> Exponents;
+        int IndexTable[MaxOrder + 1][MaxOrder + 1][MaxOrder + 1];
+
+        std::vector<Recurrence> Recurrences;
+
+        TermList M2MTerms;
+        TermList M2LTerms;
+        TermList L2LTerms;
+        TermList GradientTerms;
+};
@@ -2,7 +2,9 @@
 #include "Services/Log.hpp"
 #include "Sim/Physics.hpp"
 
-double Octree::Theta = 2.0f;
+#include <cmath>
+
+std::atomic<double> Octree::Theta(2.0);
 
 Octree::Octree(const BoundingCube& bounds, int depth)
     : Bounds(bounds),
@@ -124,7 +126,14 @@ Vec3d Octree::CalculateForce(Particle* p)
         float r = (p->Position - CentreOfMass).Length();
         float d = Bounds.BottomRight.x - Bounds.TopLeft.x;
 
-        if(d / r < Theta)
+        // Never from inside the furthest corner from the centre of mass or the softening length past it
+        float half = d / 2;
+        float bx = std::abs(CentreOfMass.x - (Bounds.TopLeft.x + half)) + half;
+        float by = std::abs(CentreOfMass.y - (Bounds.TopLeft.y + half)) + half;
+        float bz = std::abs(CentreOfMass.z - (Bounds.TopLeft.z + half)) + half;
+        float nearest = std::sqrt(bx * bx + by * by + bz * bz) + static_cast<float>(std::sqrt(Phys::S));
+
+        if(d / r < Theta && r > nearest)
         {
             auto f = Phys::Gravity(*p, CentreOfMass, TotalMass);
             auto diff = p->Position - CentreOfMass;
@@ -144,6 +153,7 @@ Vec3d Octree::CalculateForce(Particle* p)
     return force;
 }
 
+#ifndef NBODY_HEADLESS
 void Octree::RenderDebug(Cube* cube, DirectX::GeometricPrimitive* sphere, DirectX::SimpleMath::Matrix view, DirectX::SimpleMath::Matrix proj)
 {
     if(IsLeaf && NumParticles > 0)
@@ -172,4 +182,5 @@ void Octree::RenderDebug(Cube* cube, DirectX::GeometricPrimitive* sphere, Direct
         for(auto& child : Children)
             child->RenderDebug(cube, sphere, view, proj);
     }
-}
\ No newline at end of file
+}
+#endif
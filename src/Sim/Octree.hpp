@@ -4,12 +4,16 @@
 #include <array>
 #include <list>
 #include <mutex>
-#include <GeometricPrimitive.h>
+#include <atomic>
 
 #include "Core/Vec3.hpp"
-#include "Render/Model/Cube.hpp"
 #include "Render/Misc/Particle.hpp"
 
+#ifndef NBODY_HEADLESS
+#include <GeometricPrimitive.h>
+#include "Render/Model/Cube.hpp"
+#endif
+
 struct BoundingCube
 {
     Vec3<> TopLeft;
@@ -17,8 +21,13 @@ struct BoundingCube
 
     bool Contains(Particle* p)
     {
-        return p->Position.x >= TopLeft.x     && p->Position.y >= TopLeft.y     && p->Position.z >= TopLeft.z &&
-               p->Position.x <  BottomRight.x && p->Position.y <  BottomRight.y && p->Position.z <  BottomRight.z;
+        return Contains(p->Position);
+    }
+
+    bool Contains(const DirectX::SimpleMath::Vector3& p) const
+    {
+        return p.x >= TopLeft.x     && p.y >= TopLeft.y     && p.z >= TopLeft.z &&
+               p.x <  BottomRight.x && p.y <  BottomRight.y && p.z <  BottomRight.z;
     }
 };
 
@@ -31,7 +40,9 @@ class Octree
         void Add(Particle* p);
         void CalculateMass();
         Vec3d CalculateForce(Particle *p);
+#ifndef NBODY_HEADLESS
         void RenderDebug(Cube* cube, DirectX::GeometricPrimitive* sphere, DirectX::SimpleMath::Matrix view, DirectX::SimpleMath::Matrix proj);
+#endif
 
         int Depth = 0;
         int NumParticles = 0;
@@ -39,7 +50,8 @@ class Octree
         double TotalMass = 0.0;
         DirectX::SimpleMath::Vector3 CentreOfMass;
 
-        static double Theta;
+        // Set from the UI thread while a simulation thread may be reading it
+        static std::atomic<double> Theta;
 
     private:
         bool IsLeaf = true;
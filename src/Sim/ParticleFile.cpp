@@ -0,0 +1,468 @@
+#include "ParticleFile.hpp"
+#include "Services/Log.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <cerrno>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+namespace
+{
+    static_assert(sizeof(ParticleFile::Header) == 32, "Snapshot header layout changed");
+    static_assert(sizeof(ParticleFile::Column) == 32, "Snapshot column layout changed");
+
+    // Particles per writer task, each task converts and writes one range of one column
+    const size_t WriteChunk = 1 << 18;
+
+    enum EColumn
+    {
+        Position,
+        Velocity,
+        Forces,
+        Mass,
+        Colour,
+        NumColumns
+    };
+
+    struct ColumnInfo
+    {
+        const char* Name;
+        ParticleFile::EColumnType Type;
+        uint32_t Components;
+    };
+
+    const ColumnInfo KnownColumns[NumColumns] = {
+        { "position", ParticleFile::EColumnType::Float32, 3 },
+        { "velocity", ParticleFile::EColumnType::Float64, 3 },
+        { "forces",   ParticleFile::EColumnType::Float64, 3 },
+        { "mass",     ParticleFile::EColumnType::Float64, 1 },
+        { "colour",   ParticleFile::EColumnType::Float32, 4 }
+    };
+
+    uint64_t TypeSize(ParticleFile::EColumnType type)
+    {
+        return type == ParticleFile::EColumnType::Float32 ? sizeof(float) : sizeof(double);
+    }
+
+    uint64_t AlignUp(uint64_t offset)
+    {
+        return (offset + ParticleFile::ColumnAlignment - 1) / ParticleFile::ColumnAlignment * ParticleFile::ColumnAlignment;
+    }
+
+    std::string GetPath(const std::string& name)
+    {
+        return std::string(ParticleFile::Directory) + "/" + name;
+    }
+
+    // Converts particles [begin, end) into the file layout of column
+    void PackColumn(int column, const std::vector<Particle>& particles, size_t begin, size_t end, std::vector<uint8_t>& out)
+    {
+        out.resize((end - begin) * KnownColumns[column].Components * TypeSize(KnownColumns[column].Type));
+
+        float* f = reinterpret_cast<float*>(out.data());
+        double* d = reinterpret_cast<double*>(out.data());
+
+        for(size_t i = begin; i < end; ++i)
+        {
+            const Particle& p = particles[i];
+
+            switch(column)
+            {
+                case Position: *f++ = p.Position.x; *f++ = p.Position.y; *f++ = p.Position.z; break;
+                case Velocity: *d++ = p.Velocity.x; *d++ = p.Velocity.y; *d++ = p.Velocity.z; break;
+                case Forces:   *d++ = p.Forces.x;   *d++ = p.Forces.y;   *d++ = p.Forces.z;   break;
+                case Mass:     *d++ = p.Mass; break;
+
+                // Colour is only a highlight at runtime, the original is the particle's own
+                case Colour:
+                    *f++ = p.OriginalColour.R(); *f++ = p.OriginalColour.G();
+                    *f++ = p.OriginalColour.B(); *f++ = p.OriginalColour.A();
+                    break;
+            }
+        }
+    }
+
+    // Raw Particle array, read in one go rather than a particle at a time
+    bool LoadLegacy(const std::string& path, std::vector<Particle>& particles)
+    {
+        std::ifstream infile(path, std::ios::binary | std::ios::ate);
+
+        if(!infile.is_open())
+            return false;
+
+        const uint64_t size = static_cast<uint64_t>(infile.tellg());
+
+        if(size % sizeof(Particle) != 0)
+        {
+            LOGE("Particle file " + path + " is neither a snapshot nor a whole number of legacy particles")
+            return false;
+        }
+
+        particles.resize(static_cast<size_t>(size / sizeof(Particle)));
+
+        infile.seekg(0);
+        infile.read(reinterpret_cast<char*>(particles.data()), static_cast<std::streamsize>(size));
+
+        return static_cast<bool>(infile);
+    }
+
+    void MoveToCentreOfMass(TaskScheduler& scheduler, std::vector<Particle>& particles)
+    {
+        struct Moments
+        {
+            double Mass = 0.0;
+            Vec3d Weighted;
+        };
+
+        const size_t numChunks = scheduler.GetNumThreads() * 4;
+        std::vector<Moments> chunkMoments(numChunks);
+
+        ForEachChunk(scheduler, particles.size(), numChunks, [&](size_t chunk, size_t begin, size_t end) {
+            Moments moments;
+
+            for(size_t i = begin; i < end; ++i)
+            {
+                const Particle& p = particles[i];
+
+                moments.Mass += p.Mass;
+                moments.Weighted += Vec3d(p.Position.x, p.Position.y, p.Position.z) * p.Mass;
+            }
+
+            chunkMoments[chunk] = moments;
+        });
+
+        Moments total;
+
+        for(const auto& moments : chunkMoments)
+        {
+            total.Mass += moments.Mass;
+            total.Weighted += moments.Weighted;
+        }
+
+        if(total.Mass <= 0.0)
+            return;
+
+        Vec3d centreOfMass = total.Weighted / total.Mass;
+
+        DirectX::SimpleMath::Vector3 centre(static_cast<float>(centreOfMass.x),
+                                            static_cast<float>(centreOfMass.y),
+                                            static_cast<float>(centreOfMass.z));
+
+        ParallelFor(scheduler, particles.size(), [&](size_t begin, size_t end, uint32_t) {
+            for(size_t i = begin; i < end; ++i)
+                particles[i].Position -= centre;
+        });
+    }
+}
+
+bool ParticleFile::Load(const std::string& name, std::vector<Particle>& particles, bool centre)
+{
+    const std::string path = GetPath(name);
+
+    TaskScheduler scheduler;
+
+    if(IsSnapshot(path))
+    {
+        Snapshot snapshot;
+
+        if(!snapshot.Open(path) || !snapshot.Read(scheduler, particles))
+            return false;
+    }
+    else
+    {
+        if(!LoadLegacy(path, particles))
+        {
+            LOGE("Could not read particle file " + name)
+            return false;
+        }
+
+        LOGW("Particle file " + name + " is in the legacy raw format, nbody_cli --convert rewrites it as a snapshot")
+    }
+
+    LOGM("Read " + std::to_string(particles.size()) + " particles from file")
+
+    if(particles.empty())
+        return false;
+
+    if(centre)
+        MoveToCentreOfMass(scheduler, particles);
+
+    return true;
+}
+
+bool ParticleFile::Save(const std::string& name, const std::vector<Particle>& particles)
+{
+    TaskScheduler scheduler;
+
+    return Save(name, particles, scheduler);
+}
+
+bool ParticleFile::Save(const std::string& name, const std::vector<Particle>& particles, TaskScheduler& scheduler)
+{
+    if(!MakeDirectory(Directory))
+    {
+        LOGE("Failed to create data directory")
+        return false;
+    }
+
+    const std::string path = GetPath(name);
+    const uint64_t num = particles.size();
+
+    Header header = {};
+    std::memcpy(header.Magic, Magic, sizeof(Magic));
+    header.Version = Version;
+    header.Endian = EndianMarker;
+    header.NumParticles = num;
+    header.NumColumns = NumColumns;
+
+    // Value initialised, so names are zero padded and always terminated
+    std::vector<Column> table(NumColumns);
+    uint64_t offset = AlignUp(sizeof(Header) + NumColumns * sizeof(Column));
+
+    for(int c = 0; c < NumColumns; ++c)
+    {
+        const size_t nameLength = (std::min)(std::strlen(KnownColumns[c].Name), sizeof(table[c].Name) - 1);
+        std::memcpy(table[c].Name, KnownColumns[c].Name, nameLength);
+        table[c].Type = KnownColumns[c].Type;
+        table[c].Components = KnownColumns[c].Components;
+        table[c].Offset = offset;
+
+        offset = AlignUp(offset + num * KnownColumns[c].Components * TypeSize(KnownColumns[c].Type));
+    }
+
+    const uint64_t fileSize = offset;
+
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+        if(!file.is_open())
+        {
+            LOGE("Could not write particle file " + name)
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(Column));
+
+        // Sized up front so every writer can seek straight to its range
+        file.seekp(static_cast<std::streamoff>(fileSize - 1));
+        file.put('\0');
+
+        if(!file)
+        {
+            LOGE("Could not write particle file " + name)
+            return false;
+        }
+    }
+
+    // One task per range of one column, each with its own handle on the file
+    const size_t chunksPerColumn = (static_cast<size_t>(num) + WriteChunk - 1) / WriteChunk;
+    std::atomic<bool> failed(false);
+
+    ParallelFor(scheduler, chunksPerColumn * NumColumns, [&](size_t begin, size_t end, uint32_t) {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        std::vector<uint8_t> buffer;
+
+        for(size_t task = begin; task < end && file; ++task)
+        {
+            const int column = static_cast<int>(task / chunksPerColumn);
+            const size_t first = (task % chunksPerColumn) * WriteChunk;
+            const size_t last = (std::min)(first + WriteChunk, static_cast<size_t>(num));
+
+            PackColumn(column, particles, first, last, buffer);
+
+            const uint64_t stride = KnownColumns[column].Components * TypeSize(KnownColumns[column].Type);
+
+            file.seekp(static_cast<std::streamoff>(table[column].Offset + first * stride));
+            file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        }
+
+        if(!file)
+            failed.store(true, std::memory_order_relaxed);
+    }, 1);
+
+    if(failed.load())
+    {
+        LOGE("Could not write particle file " + name)
+        return false;
+    }
+
+    return true;
+}
+
+bool ParticleFile::ConvertLegacy(const std::string& legacyName, const std::string& name)
+{
+    std::vector<Particle> particles;
+
+    if(!LoadLegacy(GetPath(legacyName), particles))
+    {
+        LOGE("Could not read legacy particle file " + legacyName)
+        return false;
+    }
+
+    if(!Save(name, particles))
+        return false;
+
+    LOGM("Converted " + std::to_string(particles.size()) + " particles from " + legacyName + " to " + name)
+
+    return true;
+}
+
+bool ParticleFile::IsSnapshot(const std::string& path)
+{
+    std::ifstream infile(path, std::ios::binary);
+    char magic[sizeof(Magic)];
+
+    return infile.read(magic, sizeof(magic)) && std::memcmp(magic, Magic, sizeof(Magic)) == 0;
+}
+
+bool ParticleFile::MakeDirectory(const std::string& path)
+{
+#ifdef _WIN32
+    int result = _mkdir(path.c_str());
+#else
+    int result = mkdir(path.c_str(), 0755);
+#endif
+
+    return result == 0 || errno == EEXIST;
+}
+
+bool ParticleFile::Snapshot::Open(const std::string& path)
+{
+    Close();
+
+    if(!File.Open(path))
+    {
+        LOGE("Could not map particle file " + path)
+        return false;
+    }
+
+    const uint8_t* data = File.GetData();
+    const uint64_t size = File.GetSize();
+
+    Header header;
+
+    if(size < sizeof(Header))
+    {
+        LOGE("Particle file " + path + " is too short for a snapshot header")
+        Close();
+        return false;
+    }
+
+    std::memcpy(&header, data, sizeof(Header));
+
+    if(std::memcmp(header.Magic, Magic, sizeof(Magic)) != 0)
+    {
+        LOGE("Particle file " + path + " is not a snapshot")
+        Close();
+        return false;
+    }
+
+    if(header.Endian != EndianMarker)
+    {
+        LOGE("Particle file " + path + " was written with the other byte order")
+        Close();
+        return false;
+    }
+
+    if(header.Version > Version)
+    {
+        LOGE("Particle file " + path + " is snapshot version " + std::to_string(header.Version) + ", newer than this build reads")
+        Close();
+        return false;
+    }
+
+    if(size < sizeof(Header) + header.NumColumns * static_cast<uint64_t>(sizeof(Column)))
+    {
+        LOGE("Particle file " + path + " is too short for its column table")
+        Close();
+        return false;
+    }
+
+    Columns.resize(header.NumColumns);
+    std::memcpy(Columns.data(), data + sizeof(Header), Columns.size() * sizeof(Column));
+
+    for(auto& column : Columns)
+    {
+        column.Name[sizeof(column.Name) - 1] = '\0';
+
+        // Unknown types are kept so the rest of the file still reads, they just never match a lookup
+        if(column.Type != EColumnType::Float32 && column.Type != EColumnType::Float64)
+            continue;
+
+        const uint64_t bytes = header.NumParticles * column.Components * TypeSize(column.Type);
+
+        if(column.Offset % ColumnAlignment != 0 || column.Offset > size || bytes > size - column.Offset)
+        {
+            LOGE("Particle file " + path + " has a column " + column.Name + " outside the file")
+            Close();
+            return false;
+        }
+    }
+
+    NumParticles = header.NumParticles;
+
+    return true;
+}
+
+void ParticleFile::Snapshot::Close()
+{
+    File.Close();
+    Columns.clear();
+    NumParticles = 0;
+}
+
+const void* ParticleFile::Snapshot::GetColumn(const char* name, EColumnType type, uint32_t components) const
+{
+    for(const auto& column : Columns)
+    {
+        if(std::strcmp(column.Name, name) == 0 && column.Type == type && column.Components == components)
+            return File.GetData() + column.Offset;
+    }
+
+    return nullptr;
+}
+
+bool ParticleFile::Snapshot::Read(TaskScheduler& scheduler, std::vector<Particle>& particles) const
+{
+    const float* position = GetColumn<float>(KnownColumns[Position].Name, 3);
+    const double* velocity = GetColumn<double>(KnownColumns[Velocity].Name, 3);
+    const double* forces = GetColumn<double>(KnownColumns[Forces].Name, 3);
+    const double* mass = GetColumn<double>(KnownColumns[Mass].Name, 1);
+    const float* colour = GetColumn<float>(KnownColumns[Colour].Name, 4);
+
+    if(!position || !mass)
+    {
+        LOGE("Particle file has no position or mass column")
+        return false;
+    }
+
+    particles.resize(static_cast<size_t>(NumParticles));
+
+    ParallelFor(scheduler, particles.size(), [&](size_t begin, size_t end, uint32_t) {
+        for(size_t i = begin; i < end; ++i)
+        {
+            Particle& p = particles[i];
+
+            p.Position = DirectX::SimpleMath::Vector3(position[3 * i], position[3 * i + 1], position[3 * i + 2]);
+            p.Mass = mass[i];
+
+            p.Velocity = velocity ? Vec3d(velocity[3 * i], velocity[3 * i + 1], velocity[3 * i + 2]) : Vec3d();
+            p.Forces = forces ? Vec3d(forces[3 * i], forces[3 * i + 1], forces[3 * i + 2]) : Vec3d();
+
+            p.OriginalColour = colour ? DirectX::SimpleMath::Color(colour[4 * i], colour[4 * i + 1], colour[4 * i + 2], colour[4 * i + 3])
+                                      : DirectX::SimpleMath::Color(1.0f, 1.0f, 1.0f, 1.0f);
+            p.Colour = p.OriginalColour;
+        }
+    });
+
+    return true;
+}
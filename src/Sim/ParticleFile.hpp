@@ -0,0 +1,111 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Core/MappedFile.hpp"
+#include "Core/TaskScheduler.hpp"
+#include "Render/Misc/Particle.hpp"
+
+/*
+    Particle files are snapshots stored under the data directory. A snapshot
+    is a header, a table of columns, then each column as one contiguous array
+    starting on a 64 byte boundary, so a mapped file is read in place (see
+    Snapshot). Readers skip columns they don't know and fill in defaults for
+    columns a file doesn't have, so changing Particle doesn't break old files.
+
+    Files from before snapshots are a raw array of Particle, Load still reads
+    them and ConvertLegacy rewrites them as snapshots.
+*/
+namespace ParticleFile
+{
+    const char Directory[] = "data";
+
+    const char Magic[8] = { 'N', 'B', 'O', 'D', 'Y', 'S', 'N', 'P' };
+
+    // Readers refuse files with a newer version, bump it for changes older readers can't skip
+    const uint32_t Version = 1;
+
+    // Written in the writer's byte order, a reader with the other order sees it reversed
+    const uint32_t EndianMarker = 0x01020304;
+
+    // Columns start on multiples of this from the start of the file
+    const uint64_t ColumnAlignment = 64;
+
+    enum class EColumnType : uint32_t
+    {
+        Float32,
+        Float64
+    };
+
+    struct Header
+    {
+        char     Magic[8];
+        uint32_t Version;
+        uint32_t Endian;
+        uint64_t NumParticles;
+        uint32_t NumColumns;
+        uint32_t Reserved;
+    };
+
+    // The column table follows the header
+    struct Column
+    {
+        char        Name[16];
+        EColumnType Type;
+        uint32_t    Components;
+        uint64_t    Offset;
+    };
+
+    // Reads data/<name>, either format, and moves the centre of mass to the origin unless centre is false
+    bool Load(const std::string& name, std::vector<Particle>& particles, bool centre = true);
+
+    // Writes data/<name> as a snapshot, creating the data directory if needed
+    bool Save(const std::string& name, const std::vector<Particle>& particles);
+
+    // Same, with the column ranges written over scheduler rather than every core
+    bool Save(const std::string& name, const std::vector<Particle>& particles, TaskScheduler& scheduler);
+
+    // Rewrites the raw Particle array data/<legacyName> as the snapshot data/<name>, which may be the same file
+    bool ConvertLegacy(const std::string& legacyName, const std::string& name);
+
+    // True if path starts with the snapshot magic
+    bool IsSnapshot(const std::string& path);
+
+    // True if the directory exists afterwards
+    bool MakeDirectory(const std::string& path);
+
+    /*
+        Snapshot mapped into memory. Columns are pointers into the mapping, so
+        nothing is read until it is touched and nothing is copied unless Read
+        turns the columns back into particles.
+    */
+    class Snapshot
+    {
+    public:
+        // Maps path and checks the header and column table, logging why it can't be read
+        bool Open(const std::string& path);
+        void Close();
+
+        uint64_t GetNumParticles() const { return NumParticles; }
+
+        // Column data in the mapping, nullptr when the file has no column with this name, type and width
+        const void* GetColumn(const char* name, EColumnType type, uint32_t components) const;
+
+        template <class T>
+        const T* GetColumn(const char* name, uint32_t components) const
+        {
+            const EColumnType type = sizeof(T) == sizeof(float) ? EColumnType::Float32 : EColumnType::Float64;
+            return static_cast<const T*>(GetColumn(name, type, components));
+        }
+
+        // Fills particles from the columns, split over scheduler
+        bool Read(TaskScheduler& scheduler, std::vector<Particle>& particles) const;
+
+    private:
+        MappedFile File;
+        std::vector<Column> Columns;
+        uint64_t NumParticles = 0;
+    };
+}
@@ -0,0 +1,145 @@
+#include "ParticleStore.hpp"
+#include "Physics.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    void IntegrateAxis(float* pos, double* vel, const double* force, const double* kick, double drift, size_t num)
+    {
+        for(size_t i = 0; i < num; ++i)
+        {
+            vel[i] += force[i] * kick[i];
+            pos[i] += static_cast<float>(vel[i] * drift);
+        }
+    }
+}
+
+void ParticleStore::Load(const std::vector<Particle>& particles)
+{
+    Resize(particles.size());
+
+    for(size_t i = 0; i < particles.size(); ++i)
+    {
+        const Particle& p = particles[i];
+
+        PosX[i] = p.Position.x;
+        PosY[i] = p.Position.y;
+        PosZ[i] = p.Position.z;
+
+        VelX[i] = p.Velocity.x;
+        VelY[i] = p.Velocity.y;
+        VelZ[i] = p.Velocity.z;
+
+        ForceX[i] = p.Forces.x;
+        ForceY[i] = p.Forces.y;
+        ForceZ[i] = p.Forces.z;
+
+        Mass[i] = p.Mass;
+        Id[i] = static_cast<uint32_t>(i);
+        Level[i] = 0;
+        Cost[i] = 0;
+    }
+}
+
+void ParticleStore::Resize(size_t num)
+{
+    PosX.resize(num);
+    PosY.resize(num);
+    PosZ.resize(num);
+    VelX.resize(num);
+    VelY.resize(num);
+    VelZ.resize(num);
+    ForceX.resize(num);
+    ForceY.resize(num);
+    ForceZ.resize(num);
+    Mass.resize(num);
+    Id.resize(num);
+    Level.resize(num);
+    Cost.resize(num);
+}
+
+void ParticleStore::Swap(ParticleStore& other)
+{
+    PosX.swap(other.PosX);
+    PosY.swap(other.PosY);
+    PosZ.swap(other.PosZ);
+    VelX.swap(other.VelX);
+    VelY.swap(other.VelY);
+    VelZ.swap(other.VelZ);
+    ForceX.swap(other.ForceX);
+    ForceY.swap(other.ForceY);
+    ForceZ.swap(other.ForceZ);
+    Mass.swap(other.Mass);
+    Id.swap(other.Id);
+    Level.swap(other.Level);
+    Cost.swap(other.Cost);
+}
+
+void ParticleStore::Gather(const ParticleStore& src, const std::vector<uint32_t>& indices, size_t begin, size_t end)
+{
+    for(size_t i = begin; i < end; ++i)
+    {
+        uint32_t s = indices[i];
+
+        PosX[i] = src.PosX[s];
+        PosY[i] = src.PosY[s];
+        PosZ[i] = src.PosZ[s];
+
+        VelX[i] = src.VelX[s];
+        VelY[i] = src.VelY[s];
+        VelZ[i] = src.VelZ[s];
+
+        ForceX[i] = src.ForceX[s];
+        ForceY[i] = src.ForceY[s];
+        ForceZ[i] = src.ForceZ[s];
+
+        Mass[i] = src.Mass[s];
+        Id[i] = src.Id[s];
+        Level[i] = src.Level[s];
+        Cost[i] = src.Cost[s];
+    }
+}
+
+void ParticleStore::ProjectPositions(std::vector<Particle>& particles, size_t begin, size_t end) const
+{
+    for(size_t i = begin; i < end; ++i)
+    {
+        particles[Id[i]].Position = DirectX::SimpleMath::Vector3(PosX[i], PosY[i], PosZ[i]);
+    }
+}
+
+void ParticleStore::Project(std::vector<Particle>& particles, size_t begin, size_t end) const
+{
+    for(size_t i = begin; i < end; ++i)
+    {
+        Particle& p = particles[Id[i]];
+
+        p.Position = DirectX::SimpleMath::Vector3(PosX[i], PosY[i], PosZ[i]);
+        p.Velocity = Vec3d(VelX[i], VelY[i], VelZ[i]);
+        p.Forces = Vec3d(ForceX[i], ForceY[i], ForceZ[i]);
+    }
+}
+
+void ParticleStore::Integrate(double dt, size_t begin, size_t end)
+{
+    // Positions are in units of StarSystemScale
+    const double drift = dt / Phys::StarSystemScale;
+
+    // Blocks small enough to stay in L1, each axis gets its own loop so the
+    // compiler only has a few columns to check for overlap before vectorising
+    const size_t BlockSize = 256;
+    double kick[BlockSize];
+
+    for(size_t block = begin; block < end; block += BlockSize)
+    {
+        const size_t num = (std::min)(BlockSize, end - block);
+
+        for(size_t i = 0; i < num; ++i)
+            kick[i] = dt / Mass[block + i];
+
+        IntegrateAxis(&PosX[block], &VelX[block], &ForceX[block], kick, drift, num);
+        IntegrateAxis(&PosY[block], &VelY[block], &ForceY[block], kick, drift, num);
+        IntegrateAxis(&PosZ[block], &VelZ[block], &ForceZ[block], kick, drift, num);
+    }
+}
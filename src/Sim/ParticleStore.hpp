@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Render/Misc/Particle.hpp"
+
+/*
+    Structure of arrays copy of the physics state of a particle array.
+    The CPU simulations run on this so the hot loops only stream the fields
+    they need, and write positions back into the render layout each step.
+    Entries may be reordered freely, Id maps each one back to its particle.
+*/
+class ParticleStore
+{
+    public:
+        void Load(const std::vector<Particle>& particles);
+        void Resize(size_t num);
+        void Swap(ParticleStore& other);
+
+        // Copies entries indices[begin, end) of src into [begin, end) of this store
+        void Gather(const ParticleStore& src, const std::vector<uint32_t>& indices, size_t begin, size_t end);
+
+        // Writes store entries [begin, end) back into the particle array
+        void ProjectPositions(std::vector<Particle>& particles, size_t begin, size_t end) const;
+        void Project(std::vector<Particle>& particles, size_t begin, size_t end) const;
+
+        // Kicks then drifts entries [begin, end) by dt with their current forces
+        void Integrate(double dt, size_t begin, size_t end);
+
+        size_t Size() const { return Mass.size(); }
+
+        // Entries per range for parallel passes which stream over the store once
+        static const size_t StreamGrain = 4096;
+
+        DirectX::SimpleMath::Vector3 GetPosition(size_t i) const
+        {
+            return DirectX::SimpleMath::Vector3(PosX[i], PosY[i], PosZ[i]);
+        }
+
+        std::vector<float>    PosX, PosY, PosZ;
+        std::vector<double>   VelX, VelY, VelZ;
+        std::vector<double>   ForceX, ForceY, ForceZ;
+        std::vector<double>   Mass;
+        std::vector<uint32_t> Id;
+
+        // Timestep level for BlockTimestep, 0 in every other simulation
+        std::vector<uint8_t>  Level;
+
+        // Interactions in the particle's last force evaluation, for load balancing, 0 until it has one
+        std::vector<uint32_t> Cost;
+};
@@ -22,27 +22,18 @@ namespace Phys
     const char StarSystemScaleStr[] = "2.3e13";
     const char GalaxyScaleStr[] = "9.46e21";
 
-    inline double Gravity(const Particle& a, const Particle& b)
+    inline double Gravity(double massA, double massB, double distanceSq)
     {
-        Vec3d ap(a.Position.x, a.Position.y, a.Position.z);
-        Vec3d bp(b.Position.x, b.Position.y, b.Position.z);
-
-        ap *= StarSystemScale; 
-        bp *= StarSystemScale;
+        return -(G * massA * massB) / (distanceSq + S);
+    }
 
-        double d = Vector3::DistanceSquared(a.Position, b.Position);
-        return -(G * a.Mass * b.Mass) / (d + S);
+    inline double Gravity(const Particle& a, const Particle& b)
+    {
+        return Gravity(a.Mass, b.Mass, Vector3::DistanceSquared(a.Position, b.Position));
     }
 
     inline double Gravity(const Particle& a, const Vector3& b, double Mass)
     {
-        Vec3d ap(a.Position.x, a.Position.y, a.Position.z);
-        Vec3d bp(b.x, b.y, b.z);
-
-        ap *= StarSystemScale; 
-        bp *= StarSystemScale;
-
-        double d = Vector3::DistanceSquared(a.Position, b);
-        return -(G * a.Mass * Mass) / (d + S);
+        return Gravity(a.Mass, Mass, Vector3::DistanceSquared(a.Position, b));
     }
 }
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "Precompute.hpp"
+#include "ParticleFile.hpp"
+#include "Trajectory.hpp"
+#include "Checkpoint.hpp"
+#include "Services/Log.hpp"
+
+#include <cctype>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+namespace
+{
+    // Lower case with spaces and punctuation removed
+    std::string Normalise(const std::string& name)
+    {
+        std::string out;
+
+        for(char c : name)
+        {
+            if(std::isalnum(static_cast<unsigned char>(c)))
+                out += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+
+        return out;
+    }
+}
+
+std::string RunPrecompute(const PrecomputeSettings& settings)
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::string name = settings.Output;
+
+    if(name.empty())
+    {
+        auto stamp = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch());
+        name = std::to_string(stamp.count()) + ".nbody";
+    }
+
+    std::vector<Particle> particles(settings.NumParticles);
+    int64_t iterations = 0;
+
+    if(settings.Resume)
+    {
+        if(!Checkpointer::Resume(name, particles, iterations))
+            return "";
+    }
+    else if(settings.File.length() > 0)
+    {
+        if(!ParticleFile::Load(settings.File, particles))
+            return "";
+    }
+    else
+    {
+        auto seeder = CreateParticleSeeder(particles, settings.Seeder);
+        seeder->Seed();
+    }
+
+    auto sim = CreateNBodySim(nullptr, settings.Sim);
+
+    if(!sim)
+        return "";
+
+    LOGM("Precomputing " + std::to_string(particles.size()) + " particles with " + NBodySimGetName(settings.Sim))
+
+    sim->Init(particles);
+
+    Trajectory::Writer recorder;
+    const int recordInterval = (std::max)(settings.RecordInterval, 1);
+
+    if(!settings.Trajectory.empty())
+    {
+        Trajectory::Settings trajectory;
+        trajectory.FrameInterval = static_cast<uint32_t>(recordInterval);
+        trajectory.Timestep = settings.Timestep;
+
+        if(!ParticleFile::MakeDirectory(ParticleFile::Directory) ||
+           !recorder.Open(std::string(ParticleFile::Directory) + "/" + settings.Trajectory, particles, trajectory))
+            return "";
+    }
+
+    std::unique_ptr<Checkpointer> checkpoints;
+
+    if(settings.CheckpointInterval > 0)
+    {
+        if(!ParticleFile::MakeDirectory(ParticleFile::Directory))
+            return "";
+
+        checkpoints = std::make_unique<Checkpointer>(name, particles.size());
+    }
+
+    auto startTime = Clock::now();
+    auto reportTime = startTime;
+
+    while(true)
+    {
+        auto now = Clock::now();
+
+        if(settings.Frames > 0)
+        {
+            if(iterations >= settings.Frames)
+                break;
+        }
+        else if(now - startTime >= std::chrono::seconds(settings.SimTime))
+        {
+            break;
+        }
+
+        if(now - reportTime >= std::chrono::seconds(1))
+        {
+            reportTime = now;
+            LOGM("Running... (" + std::to_string(iterations) + " iterations)")
+        }
+
+        // Frame 0 is the starting state
+        if(!settings.Trajectory.empty() && iterations % recordInterval == 0)
+            recorder.Record(particles);
+
+        sim->Update(settings.Timestep);
+        ++iterations;
+
+        if(checkpoints && iterations % settings.CheckpointInterval == 0)
+        {
+            // Steps only write positions back, a checkpoint needs everything to resume from
+            sim->SyncParticles();
+            checkpoints->Take(particles, iterations);
+        }
+    }
+
+    sim->SyncParticles();
+
+    if(!settings.Trajectory.empty())
+    {
+        // Only on the interval, so frames stay evenly spaced for replay
+        if(iterations % recordInterval == 0)
+            recorder.Record(particles);
+
+        if(!recorder.Close())
+            return "";
+
+        LOGM("Recorded " + std::to_string(recorder.GetNumFrames()) + " frames to " + std::string(ParticleFile::Directory) + "/" + settings.Trajectory)
+    }
+
+    if(checkpoints)
+        checkpoints->Flush();
+
+    if(!ParticleFile::Save(name, particles))
+        return "";
+
+    LOGM("Saved " + std::to_string(iterations) + " iterations to " + std::string(ParticleFile::Directory) + "/" + name)
+
+    return name;
+}
+
+bool FindNBodySim(const std::string& name, ENBodySim& sim)
+{
+    for(int i = 0; i < static_cast<int>(ENBodySim::NumSims); ++i)
+    {
+        auto type = static_cast<ENBodySim>(i);
+
+        if(Normalise(NBodySimGetName(type)) == Normalise(name))
+        {
+            sim = type;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool FindParticleSeeder(const std::string& name, EParticleSeeder& seeder)
+{
+    const std::pair<const char*, EParticleSeeder> seeders[] = {
+        { "random", EParticleSeeder::Random },
+        { "galaxy", EParticleSeeder::Galaxy },
+        { "starsystem", EParticleSeeder::StarSystem }
+    };
+
+    for(const auto& s : seeders)
+    {
+        if(Normalise(name) == s.first)
+        {
+            seeder = s.second;
+            return true;
+        }
+    }
+
+    return false;
+}
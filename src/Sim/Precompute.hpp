@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+
+#include "INBodySim.hpp"
+#include "IParticleSeeder.hpp"
+
+struct PrecomputeSettings
+{
+    ENBodySim Sim = ENBodySim::BarnesHut;
+    EParticleSeeder Seeder = EParticleSeeder::StarSystem;
+
+    float Timestep = 0.02f / 60.0f;
+    int NumParticles = 4000;
+
+    // Runs for SimTime seconds of wall clock time, or for Frames steps when Frames > 0
+    int SimTime = 10;
+    int Frames = 0;
+
+    // Starts from data/<File> instead of seeding NumParticles particles
+    std::string File;
+
+    // Saves to data/<Output>, a timestamped name when empty
+    std::string Output;
+
+    // Checkpoints every CheckpointInterval steps when above 0, see Checkpointer
+    int CheckpointInterval = 0;
+
+    // Continues from the newest checkpoint of Output instead of loading or seeding, counting its steps towards Frames
+    bool Resume = false;
+
+    // Records every RecordInterval-th step to data/<Trajectory> when set, see Trajectory
+    std::string Trajectory;
+    int RecordInterval = 1;
+};
+
+/*
+    Runs a simulation with no window or device and saves the final state as
+    a particle file. Returns the name of the file written, empty on failure.
+*/
+std::string RunPrecompute(const PrecomputeSettings& settings);
+
+// Looks up a simulation or seeder by name ignoring case, spaces and punctuation, so "barneshut" finds "Barnes-Hut"
+bool FindNBodySim(const std::string& name, ENBodySim& sim);
+bool FindParticleSeeder(const std::string& name, EParticleSeeder& seeder);
@@ -1,7 +1,6 @@
 #include "RandomSeeder.hpp"
 
 #include <random>
-#include <DirectXColors.h>
 
 template <class T>
 RandomSeeder<T>::RandomSeeder(std::vector<T>& particles, float scale) : Particles(particles), Scale(scale)
@@ -0,0 +1,132 @@
+#include "RenderStream.hpp"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace
+{
+    // Ranges small enough that the packed output of one stays in L1
+    const size_t PackGrain = 4096;
+
+    struct AxisBounds
+    {
+        float Min[3] = {  std::numeric_limits<float>::max(),  std::numeric_limits<float>::max(),  std::numeric_limits<float>::max() };
+        float Max[3] = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+    };
+
+    uint16_t Quantise(float v, float origin, float scale)
+    {
+        float q = (v - origin) * scale + 0.5f;
+
+        // Also catches NaN, which fails both comparisons
+        if(!(q > 0.0f))
+            return 0;
+
+        return q >= 65535.0f ? 65535 : static_cast<uint16_t>(q);
+    }
+
+    uint32_t PackChannel(float v)
+    {
+        float c = v * 255.0f + 0.5f;
+
+        if(!(c > 0.0f))
+            return 0;
+
+        return c >= 255.0f ? 255 : static_cast<uint32_t>(c);
+    }
+}
+
+void RenderStream::Pack(TaskScheduler& scheduler, const std::vector<Particle>& particles)
+{
+    const size_t num = particles.size();
+    const size_t numChunks = (std::max)(static_cast<size_t>(scheduler.GetNumThreads()) * 4, static_cast<size_t>(1));
+
+    std::vector<AxisBounds> chunkBounds(numChunks);
+
+    ForEachChunk(scheduler, num, numChunks, [&](size_t chunk, size_t begin, size_t end) {
+        AxisBounds bounds;
+
+        for(size_t i = begin; i < end; ++i)
+        {
+            const auto& p = particles[i].Position;
+
+            // Non finite positions are clamped when packed rather than blowing up the bounds
+            if(!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+                continue;
+
+            bounds.Min[0] = (std::min)(bounds.Min[0], p.x); bounds.Max[0] = (std::max)(bounds.Max[0], p.x);
+            bounds.Min[1] = (std::min)(bounds.Min[1], p.y); bounds.Max[1] = (std::max)(bounds.Max[1], p.y);
+            bounds.Min[2] = (std::min)(bounds.Min[2], p.z); bounds.Max[2] = (std::max)(bounds.Max[2], p.z);
+        }
+
+        chunkBounds[chunk] = bounds;
+    });
+
+    AxisBounds bounds;
+
+    for(const auto& chunk : chunkBounds)
+    {
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            bounds.Min[axis] = (std::min)(bounds.Min[axis], chunk.Min[axis]);
+            bounds.Max[axis] = (std::max)(bounds.Max[axis], chunk.Max[axis]);
+        }
+    }
+
+    float origin[3], extent[3], scale[3];
+
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        // No finite particles at all
+        if(bounds.Min[axis] > bounds.Max[axis])
+            bounds.Min[axis] = bounds.Max[axis] = 0.0f;
+
+        // Kept above 0 for particles which all sit in one plane
+        origin[axis] = bounds.Min[axis];
+        extent[axis] = (std::max)(bounds.Max[axis] - bounds.Min[axis], 1e-6f);
+        scale[axis] = 65535.0f / extent[axis];
+    }
+
+    Origin = DirectX::SimpleMath::Vector3(origin[0], origin[1], origin[2]);
+    Extent = DirectX::SimpleMath::Vector3(extent[0], extent[1], extent[2]);
+
+    Particles.resize(num);
+
+    ParallelFor(scheduler, num, [&](size_t begin, size_t end, uint32_t) {
+        for(size_t i = begin; i < end; ++i)
+        {
+            const Particle& p = particles[i];
+            PackedParticle& packed = Particles[i];
+
+            packed.Position[0] = Quantise(p.Position.x, origin[0], scale[0]);
+            packed.Position[1] = Quantise(p.Position.y, origin[1], scale[1]);
+            packed.Position[2] = Quantise(p.Position.z, origin[2], scale[2]);
+            packed.Position[3] = 0;
+            packed.Colour = PackColour(p.Colour);
+        }
+    }, PackGrain);
+}
+
+void RenderStream::SetColour(size_t i, const DirectX::SimpleMath::Color& colour)
+{
+    Particles[i].Colour = PackColour(colour);
+}
+
+DirectX::SimpleMath::Vector3 RenderStream::GetPosition(size_t i) const
+{
+    const PackedParticle& packed = Particles[i];
+
+    return DirectX::SimpleMath::Vector3(
+        Origin.x + packed.Position[0] / 65535.0f * Extent.x,
+        Origin.y + packed.Position[1] / 65535.0f * Extent.y,
+        Origin.z + packed.Position[2] / 65535.0f * Extent.z);
+}
+
+uint32_t RenderStream::PackColour(const DirectX::SimpleMath::Color& colour)
+{
+    return PackChannel(colour.R()) |
+           PackChannel(colour.G()) << 8 |
+           PackChannel(colour.B()) << 16 |
+           PackChannel(colour.A()) << 24;
+}
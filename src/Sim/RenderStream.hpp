@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+
+#include "Core/TaskScheduler.hpp"
+#include "Render/Misc/Particle.hpp"
+
+/*
+    Compact copy of the particle state the renderer draws. Positions are
+    quantised to 16 bits per axis within the bounds of the particles, measured
+    on every pack, and colours to RGBA8, so an upload streams 12 bytes a
+    particle rather than the full simulation state.
+
+    The vertex shader rebuilds a position as Origin + Position * Extent.
+*/
+class RenderStream
+{
+    public:
+        // Measures the bounds of particles then packs them, both passes split over scheduler
+        void Pack(TaskScheduler& scheduler, const std::vector<Particle>& particles);
+
+        // Repacks the colour of one particle, for highlighting without repacking everything
+        void SetColour(size_t i, const DirectX::SimpleMath::Color& colour);
+
+        // Position of particle i as the shader sees it
+        DirectX::SimpleMath::Vector3 GetPosition(size_t i) const;
+
+        size_t Size() const { return Particles.size(); }
+        const PackedParticle* Data() const { return Particles.data(); }
+
+        const DirectX::SimpleMath::Vector3& GetOrigin() const { return Origin; }
+        const DirectX::SimpleMath::Vector3& GetExtent() const { return Extent; }
+
+        static uint32_t PackColour(const DirectX::SimpleMath::Color& colour);
+
+    private:
+        std::vector<PackedParticle> Particles;
+
+        DirectX::SimpleMath::Vector3 Origin;
+        DirectX::SimpleMath::Vector3 Extent;
+};
@@ -0,0 +1,120 @@
+#include "SimulationThread.hpp"
+
+#include <chrono>
+#include <algorithm>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Longest wall clock time one step covers, slow steps or stalls slow the simulation down rather than take huge steps
+    const float MaxStepSeconds = 0.1f;
+}
+
+SimulationThread::~SimulationThread()
+{
+    Stop();
+}
+
+void SimulationThread::Start(INBodySim* sim, const std::vector<Particle>& particles)
+{
+    Stop();
+
+    Sim = sim;
+    Working = particles;
+    Sim->Init(Working);
+    PackScheduler = Sim->GetScheduler();
+
+    Buffers.Reset();
+    Steps.store(0, std::memory_order_relaxed);
+    PendingStep.store(0.0f, std::memory_order_relaxed);
+    Stopping.store(false, std::memory_order_relaxed);
+
+    // So there is something to draw before the first step finishes
+    Submit(Working);
+
+    Thread = std::thread(&SimulationThread::Run, this);
+}
+
+void SimulationThread::Stop()
+{
+    if(!Thread.joinable())
+        return;
+
+    Stopping.store(true, std::memory_order_relaxed);
+    Thread.join();
+
+    // Steps only write positions back, whoever restarts from the particles needs the rest
+    Sim->SyncParticles();
+
+    Submit(Working);
+
+    // The simulation may be destroyed once stopped
+    PackScheduler = nullptr;
+}
+
+const size_t SimulationThread::NoSelection;
+
+bool SimulationThread::Acquire()
+{
+    return Buffers.Acquire();
+}
+
+const Particle* SimulationThread::GetSelected() const
+{
+    const Frame& frame = Buffers.GetFront();
+
+    return frame.HasSelected ? &frame.Selected : nullptr;
+}
+
+void SimulationThread::Run()
+{
+    auto last = Clock::now();
+
+    while(!Stopping.load(std::memory_order_relaxed))
+    {
+        auto now = Clock::now();
+        float dt = PendingStep.exchange(0.0f, std::memory_order_relaxed);
+
+        if(!Paused.load(std::memory_order_relaxed))
+        {
+            float elapsed = std::chrono::duration<float>(now - last).count();
+            dt += (std::min)(elapsed, MaxStepSeconds) * Speed.load(std::memory_order_relaxed);
+        }
+
+        last = now;
+
+        if(dt <= 0.0f)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(StepMutex);
+
+            Sim->Update(dt);
+
+            if(Selected.load(std::memory_order_relaxed) != NoSelection)
+                Sim->SyncParticles();
+        }
+
+        Submit(Working);
+
+        Steps.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void SimulationThread::Submit(const std::vector<Particle>& particles)
+{
+    Frame& frame = Buffers.GetBack();
+    const size_t selected = Selected.load(std::memory_order_relaxed);
+
+    frame.Stream.Pack(PackScheduler ? *PackScheduler : SerialScheduler, particles);
+    frame.HasSelected = selected < particles.size();
+
+    if(frame.HasSelected)
+        frame.Selected = particles[selected];
+
+    Buffers.Publish();
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+#include "INBodySim.hpp"
+#include "RenderStream.hpp"
+#include "Core/TripleBuffer.hpp"
+#include "Core/TaskScheduler.hpp"
+
+/*
+    Steps a simulation on its own thread so it runs at its own rate rather
+    than once per rendered frame. Each step's dt is the wall clock time since
+    the last one scaled by the speed. The simulation works on the thread's
+    own copy of the particles. After every step they're packed into a
+    RenderStream in a TripleBuffer, along with a copy of the one selected
+    particle, so the render thread picks up the newest finished step without
+    waiting for the one in progress and only the packed state crosses over.
+
+    Between Start and Stop the simulation belongs to the thread, other threads
+    may only read it while holding Lock.
+*/
+class SimulationThread
+{
+public:
+    ~SimulationThread();
+
+    // Inits sim with a copy of particles and starts stepping it
+    void Start(INBodySim* sim, const std::vector<Particle>& particles);
+
+    // Finishes the current step, joins the thread and publishes it, GetParticles then has the full state (velocity, forces)
+    void Stop();
+
+    bool IsRunning() const { return Thread.joinable(); }
+
+    static const size_t NoSelection = ~static_cast<size_t>(0);
+
+    void SetSpeed(float speed) { Speed.store(speed, std::memory_order_relaxed); }
+    void SetPaused(bool paused) { Paused.store(paused, std::memory_order_relaxed); }
+
+    // Particle whose full state is published with every step, for showing it, NoSelection for none.
+    // While one is selected every step also writes back velocities and forces
+    void SetSelected(size_t index) { Selected.store(index, std::memory_order_relaxed); }
+
+    // Queues one step of dt, even while paused, dt is not scaled by the speed
+    void Step(float dt) { PendingStep.store(dt, std::memory_order_relaxed); }
+
+    // Publishes particles as a finished step, for simulations stepped on the calling thread, only while not running
+    void Submit(const std::vector<Particle>& particles);
+
+    // Takes the newest finished step as the one GetStream and GetSelected read, false when none finished since the last call
+    bool Acquire();
+
+    // Packed render state of the last acquired step, only for the thread calling Acquire
+    RenderStream& GetStream() { return Buffers.GetFront().Stream; }
+
+    // Selected particle as of the last acquired step, nullptr when none was selected then
+    const Particle* GetSelected() const;
+
+    // Full state of every particle as of the last Stop, only while not running
+    const std::vector<Particle>& GetParticles() const { return Working; }
+
+    // Holds off the next step while the lock is held
+    std::unique_lock<std::mutex> Lock() { return std::unique_lock<std::mutex>(StepMutex); }
+
+    // Steps finished since Start
+    uint64_t GetSteps() const { return Steps.load(std::memory_order_relaxed); }
+
+private:
+    struct Frame
+    {
+        RenderStream Stream;
+        Particle Selected;
+        bool HasSelected = false;
+    };
+
+    void Run();
+
+    INBodySim* Sim = nullptr;
+    std::vector<Particle> Working;
+    TripleBuffer<Frame> Buffers;
+
+    // Steps are packed on the simulation's own pool between Updates, so no more threads run than it
+    // starts itself. Without one, and for Submit while not running, they're packed on the calling thread
+    TaskScheduler* PackScheduler = nullptr;
+    TaskScheduler SerialScheduler{ 1 };
+
+    std::thread Thread;
+    std::mutex StepMutex;
+
+    std::atomic<bool> Stopping{ false };
+    std::atomic<bool> Paused{ true };
+    std::atomic<size_t> Selected{ NoSelection };
+    std::atomic<float> Speed{ 1.0f };
+    std::atomic<float> PendingStep{ 0.0f };
+    std::atomic<uint64_t> Steps{ 0 };
+};
@@ -3,7 +3,6 @@
 //#include "Core/Event.hpp"
 
 #include <random>
-#include <DirectXColors.h>
 
 #define _USE_MATH_DEFINES
 #include <math.h>
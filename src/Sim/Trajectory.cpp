@@ -0,0 +1,433 @@
+#include "Trajectory.hpp"
+#include "RenderStream.hpp"
+#include "Services/Log.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+    static_assert(sizeof(Trajectory::Header) == 40, "Trajectory header layout changed");
+    static_assert(sizeof(Trajectory::FrameHeader) == 8, "Trajectory frame header layout changed");
+    static_assert(sizeof(Trajectory::Footer) == 16, "Trajectory footer layout changed");
+
+    const char FooterTag[4] = { 'T', 'I', 'D', 'X' };
+
+    void PutVarint(std::vector<uint8_t>& out, int64_t value)
+    {
+        // Zigzag so small negative steps stay small
+        uint64_t v = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+
+        while(v >= 0x80)
+        {
+            out.push_back(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+
+        out.push_back(static_cast<uint8_t>(v));
+    }
+
+    bool GetVarint(const uint8_t*& in, const uint8_t* end, int64_t& value)
+    {
+        uint64_t v = 0;
+
+        for(int shift = 0; shift < 64; shift += 7)
+        {
+            if(in == end)
+                return false;
+
+            uint8_t byte = *in++;
+            v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+            if((byte & 0x80) == 0)
+            {
+                value = static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    uint64_t StaticBytes(uint64_t numParticles)
+    {
+        return numParticles * (sizeof(double) + sizeof(uint32_t));
+    }
+}
+
+Trajectory::Writer::~Writer()
+{
+    Close();
+}
+
+bool Trajectory::Writer::Open(const std::string& path, const std::vector<Particle>& particles, const Settings& settings)
+{
+    Close();
+
+    File.open(path, std::ios::binary | std::ios::trunc);
+
+    if(!File.is_open())
+    {
+        LOGE("Could not write trajectory " + path)
+        return false;
+    }
+
+    Config = settings;
+    NumParticles = particles.size();
+    NumFrames = 0;
+    Cells.assign(NumParticles * 3, 0);
+    Index.clear();
+
+    Header header = {};
+    std::memcpy(header.Magic, Magic, sizeof(Magic));
+    header.Version = Version;
+    header.Endian = EndianMarker;
+    header.NumParticles = NumParticles;
+    header.FrameInterval = settings.FrameInterval;
+    header.Timestep = settings.Timestep;
+    header.Quantum = settings.Quantum;
+    header.KeyframeInterval = (std::max)(settings.KeyframeInterval, 1u);
+    Config.KeyframeInterval = header.KeyframeInterval;
+
+    File.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<double> masses(NumParticles);
+    std::vector<uint32_t> colours(NumParticles);
+
+    for(size_t i = 0; i < NumParticles; ++i)
+    {
+        masses[i] = particles[i].Mass;
+        colours[i] = RenderStream::PackColour(particles[i].OriginalColour);
+    }
+
+    File.write(reinterpret_cast<const char*>(masses.data()), masses.size() * sizeof(double));
+    File.write(reinterpret_cast<const char*>(colours.data()), colours.size() * sizeof(uint32_t));
+
+    if(!File)
+    {
+        LOGE("Could not write trajectory " + path)
+        File.close();
+        return false;
+    }
+
+    Closing = false;
+    Thread = std::thread(&Writer::Run, this);
+
+    return true;
+}
+
+void Trajectory::Writer::Record(const std::vector<Particle>& particles)
+{
+    if(!Thread.joinable() || particles.size() != NumParticles)
+        return;
+
+    std::vector<float> positions;
+
+    {
+        std::unique_lock<std::mutex> lock(QueueMutex);
+        QueueChanged.wait(lock, [this]() { return Queue.size() < MaxQueued; });
+
+        if(!FreeFrames.empty())
+        {
+            positions = std::move(FreeFrames.back());
+            FreeFrames.pop_back();
+        }
+    }
+
+    positions.resize(NumParticles * 3);
+
+    for(size_t i = 0; i < NumParticles; ++i)
+    {
+        positions[i] = particles[i].Position.x;
+        positions[NumParticles + i] = particles[i].Position.y;
+        positions[2 * NumParticles + i] = particles[i].Position.z;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(QueueMutex);
+        Queue.push_back(std::move(positions));
+    }
+
+    QueueChanged.notify_all();
+}
+
+bool Trajectory::Writer::Close()
+{
+    if(!Thread.joinable())
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock(QueueMutex);
+        Closing = true;
+    }
+
+    QueueChanged.notify_all();
+    Thread.join();
+
+    Footer footer = {};
+    footer.IndexOffset = static_cast<uint64_t>(File.tellp());
+    footer.NumFrames = NumFrames;
+    std::memcpy(footer.Tag, FooterTag, sizeof(FooterTag));
+
+    File.write(reinterpret_cast<const char*>(Index.data()), Index.size() * sizeof(uint64_t));
+    File.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+
+    bool ok = static_cast<bool>(File);
+    File.close();
+
+    FreeFrames.clear();
+
+    if(!ok)
+        LOGE("Writing trajectory failed")
+
+    return ok;
+}
+
+void Trajectory::Writer::Run()
+{
+    while(true)
+    {
+        std::vector<float> positions;
+
+        {
+            std::unique_lock<std::mutex> lock(QueueMutex);
+            QueueChanged.wait(lock, [this]() { return !Queue.empty() || Closing; });
+
+            if(Queue.empty())
+                return;
+
+            positions = std::move(Queue.front());
+            Queue.pop_front();
+        }
+
+        QueueChanged.notify_all();
+
+        Encode(positions);
+
+        std::lock_guard<std::mutex> lock(QueueMutex);
+        FreeFrames.push_back(std::move(positions));
+    }
+}
+
+void Trajectory::Writer::Encode(const std::vector<float>& positions)
+{
+    const bool keyframe = NumFrames % Config.KeyframeInterval == 0;
+    const double scale = 1.0 / Config.Quantum;
+
+    Encoded.clear();
+
+    for(size_t i = 0; i < positions.size(); ++i)
+    {
+        double cell = std::floor(positions[i] * scale + 0.5);
+
+        // Particles which aren't finite or are off the grid keep their last cell
+        int64_t next = std::fabs(cell) < 4e18 ? static_cast<int64_t>(cell) : Cells[i];
+
+        PutVarint(Encoded, keyframe ? next : next - Cells[i]);
+        Cells[i] = next;
+    }
+
+    FrameHeader frame = { keyframe ? 1u : 0u, static_cast<uint32_t>(Encoded.size()) };
+
+    Index.push_back(static_cast<uint64_t>(File.tellp()));
+
+    File.write(reinterpret_cast<const char*>(&frame), sizeof(frame));
+    File.write(reinterpret_cast<const char*>(Encoded.data()), Encoded.size());
+
+    ++NumFrames;
+}
+
+bool Trajectory::Reader::Open(const std::string& path)
+{
+    Close();
+
+    if(!File.Open(path) || File.GetSize() < sizeof(Header))
+    {
+        LOGE("Could not read trajectory " + path)
+        Close();
+        return false;
+    }
+
+    std::memcpy(&Info, File.GetData(), sizeof(Header));
+
+    if(std::memcmp(Info.Magic, Magic, sizeof(Magic)) != 0 || Info.Endian != EndianMarker || Info.Version > Version)
+    {
+        LOGE("Trajectory " + path + " is not a trajectory this build can read")
+        Close();
+        return false;
+    }
+
+    const uint64_t size = File.GetSize();
+    const uint64_t framesStart = sizeof(Header) + StaticBytes(Info.NumParticles);
+
+    if(Info.NumParticles > size || framesStart > size || Info.KeyframeInterval == 0)
+    {
+        LOGE("Trajectory " + path + " is truncated")
+        Close();
+        return false;
+    }
+
+    Footer footer;
+    bool indexed = false;
+
+    if(size >= framesStart + sizeof(Footer))
+    {
+        std::memcpy(&footer, File.GetData() + size - sizeof(Footer), sizeof(Footer));
+
+        // Bound each field before adding them, a corrupt footer must not wrap the sum round to size
+        const uint64_t indexEnd = size - sizeof(Footer);
+
+        indexed = std::memcmp(footer.Tag, FooterTag, sizeof(FooterTag)) == 0 &&
+                  footer.IndexOffset >= framesStart &&
+                  footer.IndexOffset <= indexEnd &&
+                  footer.NumFrames <= (indexEnd - footer.IndexOffset) / sizeof(uint64_t) &&
+                  footer.IndexOffset + footer.NumFrames * sizeof(uint64_t) == indexEnd;
+    }
+
+    if(indexed)
+    {
+        Index.resize(footer.NumFrames);
+        std::memcpy(Index.data(), File.GetData() + footer.IndexOffset, Index.size() * sizeof(uint64_t));
+    }
+    else
+    {
+        // Never closed, walk the frames which were written in full
+        LOGW("Trajectory " + path + " has no index, it was not closed")
+
+        uint64_t offset = framesStart;
+
+        while(offset + sizeof(FrameHeader) <= size)
+        {
+            FrameHeader frame;
+            std::memcpy(&frame, File.GetData() + offset, sizeof(frame));
+
+            if(frame.Bytes > size - offset - sizeof(FrameHeader))
+                break;
+
+            Index.push_back(offset);
+            offset += sizeof(FrameHeader) + frame.Bytes;
+        }
+    }
+
+    // Frame sizes are checked when they are decoded
+    for(uint64_t offset : Index)
+    {
+        if(offset < framesStart || offset + sizeof(FrameHeader) > size)
+        {
+            LOGE("Trajectory " + path + " has a frame outside the file")
+            Close();
+            return false;
+        }
+    }
+
+    Cells.assign(static_cast<size_t>(Info.NumParticles) * 3, 0);
+    Current = -1;
+
+    return true;
+}
+
+void Trajectory::Reader::Close()
+{
+    File.Close();
+    Index.clear();
+    Cells.clear();
+    Current = -1;
+    Info = {};
+}
+
+void Trajectory::Reader::GetParticles(std::vector<Particle>& particles) const
+{
+    const size_t num = GetNumParticles();
+    const uint8_t* data = File.GetData() + sizeof(Header);
+
+    particles.resize(num);
+
+    for(size_t i = 0; i < num; ++i)
+    {
+        Particle& p = particles[i];
+
+        uint32_t colour;
+        std::memcpy(&p.Mass, data + i * sizeof(double), sizeof(double));
+        std::memcpy(&colour, data + num * sizeof(double) + i * sizeof(uint32_t), sizeof(uint32_t));
+
+        p.OriginalColour = DirectX::SimpleMath::Color((colour & 0xFF) / 255.0f,
+                                                      ((colour >> 8) & 0xFF) / 255.0f,
+                                                      ((colour >> 16) & 0xFF) / 255.0f,
+                                                      ((colour >> 24) & 0xFF) / 255.0f);
+        p.Colour = p.OriginalColour;
+        p.Velocity = Vec3d();
+        p.Forces = Vec3d();
+    }
+}
+
+bool Trajectory::Reader::ReadFrame(uint32_t frame, std::vector<Particle>& particles)
+{
+    if(frame >= Index.size() || particles.size() != GetNumParticles())
+        return false;
+
+    if(static_cast<int64_t>(frame) != Current)
+    {
+        // Decode forward when the frame is after the current one and no keyframe is closer
+        uint32_t start = frame - frame % Info.KeyframeInterval;
+
+        if(Current >= static_cast<int64_t>(start) && Current < static_cast<int64_t>(frame))
+            start = static_cast<uint32_t>(Current) + 1;
+
+        for(uint32_t f = start; f <= frame; ++f)
+        {
+            if(!Decode(f))
+            {
+                Current = -1;
+                return false;
+            }
+        }
+    }
+
+    const size_t num = GetNumParticles();
+    const float quantum = Info.Quantum;
+
+    for(size_t i = 0; i < num; ++i)
+    {
+        particles[i].Position = DirectX::SimpleMath::Vector3(
+            static_cast<float>(Cells[i] * static_cast<double>(quantum)),
+            static_cast<float>(Cells[num + i] * static_cast<double>(quantum)),
+            static_cast<float>(Cells[2 * num + i] * static_cast<double>(quantum)));
+    }
+
+    return true;
+}
+
+bool Trajectory::Reader::Decode(uint32_t frame)
+{
+    const uint8_t* data = File.GetData() + Index[frame];
+
+    FrameHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    const uint8_t* in = data + sizeof(FrameHeader);
+    const uint8_t* end = File.GetData() + File.GetSize();
+
+    if(static_cast<uint64_t>(end - in) < header.Bytes)
+        return false;
+
+    end = in + header.Bytes;
+
+    // Deltas only apply on top of the frame before
+    if(!header.Keyframe && Current != static_cast<int64_t>(frame) - 1)
+        return false;
+
+    for(auto& cell : Cells)
+    {
+        int64_t value;
+
+        if(!GetVarint(in, end, value))
+            return false;
+
+        cell = header.Keyframe ? value : cell + value;
+    }
+
+    Current = frame;
+
+    return true;
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <thread>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <condition_variable>
+
+#include "Core/MappedFile.hpp"
+#include "Render/Misc/Particle.hpp"
+
+/*
+    Trajectories record the positions of a run every few steps so it can be
+    replayed without simulating it again. Positions are snapped to a grid of
+    Quantum and each frame stores the change in grid cell since the frame
+    before as zigzag varints, which are a byte or two for most particles.
+    Every KeyframeInterval frames the cells are stored whole so a reader can
+    seek without decoding from the start. The grid is exact in integers, so
+    the error is at most half a Quantum however long the run.
+
+    Layout: header, mass and RGBA8 colour per particle, frames (a FrameHeader
+    then the x, y and z varints), then an index of frame offsets and a footer.
+    A file without a footer, from a writer which never closed, is indexed by
+    walking the frames.
+*/
+namespace Trajectory
+{
+    const char Magic[8] = { 'N', 'B', 'O', 'D', 'Y', 'T', 'R', 'J' };
+    const uint32_t Version = 1;
+    const uint32_t EndianMarker = 0x01020304;
+
+    struct Header
+    {
+        char     Magic[8];
+        uint32_t Version;
+        uint32_t Endian;
+        uint64_t NumParticles;
+
+        // Steps between frames and the timestep they were taken with, for replaying at the recorded speed
+        uint32_t FrameInterval;
+        float    Timestep;
+
+        float    Quantum;
+        uint32_t KeyframeInterval;
+    };
+
+    struct FrameHeader
+    {
+        uint32_t Keyframe;
+        uint32_t Bytes;
+    };
+
+    struct Footer
+    {
+        uint64_t IndexOffset;
+        uint32_t NumFrames;
+        char     Tag[4];
+    };
+
+    struct Settings
+    {
+        uint32_t FrameInterval = 1;
+        float Timestep = 0.0f;
+
+        // Grid positions are snapped to, in the units of Particle::Position
+        float Quantum = 1e-3f;
+        uint32_t KeyframeInterval = 64;
+    };
+
+    /*
+        Record copies the positions and returns, a background thread does the
+        encoding and writing. At most MaxQueued frames wait for it, Record
+        blocks while the queue is full.
+    */
+    class Writer
+    {
+    public:
+        ~Writer();
+
+        // Creates path and writes the header and the particles' masses and colours
+        bool Open(const std::string& path, const std::vector<Particle>& particles, const Settings& settings);
+
+        // Queues the particles' current positions as the next frame, particles must match the ones given to Open
+        void Record(const std::vector<Particle>& particles);
+
+        // Writes the queued frames and the index, false if any write failed
+        bool Close();
+
+        // Frames written, only once Close has returned
+        uint32_t GetNumFrames() const { return NumFrames; }
+
+        static const size_t MaxQueued = 4;
+
+    private:
+        void Run();
+        void Encode(const std::vector<float>& positions);
+
+        std::ofstream File;
+        Settings Config;
+        size_t NumParticles = 0;
+        uint32_t NumFrames = 0;
+
+        // Owned by the writer thread once it runs
+        std::vector<int64_t> Cells;
+        std::vector<uint64_t> Index;
+        std::vector<uint8_t> Encoded;
+
+        std::thread Thread;
+        std::mutex QueueMutex;
+        std::condition_variable QueueChanged;
+        std::deque<std::vector<float>> Queue;
+        std::vector<std::vector<float>> FreeFrames;
+        bool Closing = false;
+    };
+
+    /*
+        Maps a trajectory and decodes frames from it. Reading frames in order
+        decodes one frame each, any other frame decodes from the keyframe
+        before it.
+    */
+    class Reader
+    {
+    public:
+        bool Open(const std::string& path);
+        void Close();
+
+        uint32_t GetNumFrames() const { return static_cast<uint32_t>(Index.size()); }
+        size_t GetNumParticles() const { return static_cast<size_t>(Info.NumParticles); }
+
+        // Simulated seconds between frames
+        double GetFrameTime() const { return static_cast<double>(Info.Timestep) * Info.FrameInterval; }
+
+        // Sizes particles and fills in masses and colours, positions are left to ReadFrame
+        void GetParticles(std::vector<Particle>& particles) const;
+
+        // Writes the positions of frame into particles, sized by GetParticles
+        bool ReadFrame(uint32_t frame, std::vector<Particle>& particles);
+
+    private:
+        bool Decode(uint32_t frame);
+
+        MappedFile File;
+        Header Info = {};
+        std::vector<uint64_t> Index;
+
+        std::vector<int64_t> Cells;
+        int64_t Current = -1;
+    };
+}
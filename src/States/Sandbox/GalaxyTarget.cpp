@@ -4,6 +4,7 @@
 #include "Sim/IParticleSeeder.hpp"
 
 #include <random>
+#include <utility>
 #include <imgui.h>
 
 GalaxyTarget::GalaxyTarget(ID3D11DeviceContext* context, DX::DeviceResources* resources, ICamera* camera, ID3D11RenderTargetView* rtv)
@@ -29,6 +30,12 @@ GalaxyTarget::GalaxyTarget(ID3D11DeviceContext* context, DX::DeviceResources* re
     SeedParticles.resize(PARTICLES_PER_GALAXY);
 }
 
+GalaxyTarget::~GalaxyTarget()
+{
+    // The seed task writes SeedParticles and SeedIndex, which go before the base class's scheduler
+    FinishTask(EWorkerTask::Seed);
+}
+
 void GalaxyTarget::Seed(uint64_t seed)
 {
     GalaxyRenderer->InitialSeed((Parent->GetSeed() << 21) + seed);
@@ -103,7 +110,7 @@ void GalaxyTarget::OnStartTransitionDownChild(Vector3 location)
 
     GalaxyRenderer->Scale(50.0f);
 
-    DispatchTask(EWorkerTask::Seed, [&]() {
+    DispatchTask(EWorkerTask::Seed, [this, seed, col]() {
         const float Variation = 0.12f;
 
         auto seeder = CreateParticleSeeder(SeedParticles, EParticleSeeder::Galaxy, 0.1f);
@@ -111,13 +118,16 @@ void GalaxyTarget::OnStartTransitionDownChild(Vector3 location)
         seeder->SetGreenDist(col.G() - Variation, col.G() + Variation);
         seeder->SetBlueDist(col.B() - Variation, col.B() + Variation);
         seeder->Seed(seed);
+
+        // Building the index takes a while for this many particles, so it's done here rather than on the transition's last frame
+        SeedIndex.Build(SeedParticles);
     });
 }
 
 void GalaxyTarget::OnEndTransitionDownChild()
 {
     FinishTask(EWorkerTask::Seed);
-    GalaxyRenderer->FinishSeed(SeedParticles);
+    GalaxyRenderer->FinishSeed(SeedParticles, std::move(SeedIndex));
 }
 
 void GalaxyTarget::RenderLerp(float t, float scale, Vector3 voffset, bool single)
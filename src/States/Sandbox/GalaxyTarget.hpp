@@ -9,6 +9,7 @@ class GalaxyTarget : public SandboxTarget
 {
 public:
     GalaxyTarget(ID3D11DeviceContext* context, DX::DeviceResources* resources, ICamera* camera, ID3D11RenderTargetView* rtv);
+    ~GalaxyTarget();
 
     void Render() override;
     void RenderUI() override;
@@ -49,6 +50,7 @@ private:
     };
 
     std::vector<LWParticle> SeedParticles;
+    SpatialIndex SeedIndex;
     std::vector<BillboardInstance> SeedDustClouds;
 
     std::unique_ptr<Galaxy> GalaxyRenderer;
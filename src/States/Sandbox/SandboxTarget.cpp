@@ -10,8 +10,7 @@ SandboxTarget::SandboxTarget(ID3D11DeviceContext* context, std::string name, std
       Resources(resources),
       Camera(camera),
       SkyBox(context),
-      RenderTarget(rtv),
-      Pool(std::bind(&SandboxTarget::Worker, this, std::placeholders::_1))
+      RenderTarget(rtv)
 {
     Context->GetDevice(&Device);
     
@@ -138,24 +137,19 @@ void SandboxTarget::DispatchTask(EWorkerTask task, std::function<void()> func)
 {
     CTimer timer("dispatch");
 
-    auto id = static_cast<uint32_t>(task);
+    auto& group = Tasks[static_cast<int>(task)];
 
-    if (Pool.IsWorking(id))
+    if (!group.IsDone())
     {
         CTimer timer("finishing task " + std::to_string(static_cast<int>(task)));
-        Pool.Join(static_cast<uint32_t>(task));
+        Scheduler.Wait(group);
     }
 
-    Pool.Dispatch(id, func);
+    Scheduler.Run(group, func);
 }
 
 void SandboxTarget::FinishTask(EWorkerTask task)
 {
     CTimer timer("finishing task " + std::to_string(static_cast<int>(task)));
-    Pool.Join(static_cast<uint32_t>(task));
-}
-
-void SandboxTarget::Worker(std::function<void()> func)
-{
-    func();
+    Scheduler.Wait(Tasks[static_cast<int>(task)]);
 }
@@ -3,7 +3,7 @@
 #include "App/DeviceResources.hpp"
 
 #include "Core/Maths.hpp"
-#include "Core/ThreadPool.hpp"
+#include "Core/TaskScheduler.hpp"
 
 #include "Render/Model/Model.hpp"
 #include "Render/Model/Skybox.hpp"
@@ -81,7 +81,7 @@ public:
     float EndTransitionDist = 400.0f;
     
 protected:
-    enum class EWorkerTask { Seed };
+    enum class EWorkerTask { Seed, NumTasks };
 
     virtual void OnStartTransitionUpParent() {}
     virtual void OnStartTransitionDownParent(Vector3 object) {}
@@ -122,7 +122,8 @@ private:
     } State;
     
     uint64_t SeedValue;
-    CThreadPool<std::function<void()>> Pool;
 
-    void Worker(std::function<void()> func);
+    // Declared before the scheduler, which runs any tasks still queued when it is destroyed
+    TaskGroup Tasks[static_cast<int>(EWorkerTask::NumTasks)];
+    TaskScheduler Scheduler;
 };
\ No newline at end of file
@@ -114,7 +114,8 @@ std::string StarTarget::GetObjectName() const
 
 Vector3 StarTarget::GetClosestObject(Vector3 pos)
 {
-    return Maths::ClosestParticle(pos, Particles, &CurrentClosestObjectID).Position;
+    CurrentClosestObjectID = ParticleIndex.Nearest(pos);
+    return Particles[CurrentClosestObjectID].Position;
 }
 
 Vector3 StarTarget::GetLightDirection() const
@@ -209,6 +210,8 @@ void StarTarget::Seed(uint64_t seed)
     auto seeder = CreateParticleSeeder(Particles, EParticleSeeder::Random, 4.0f);
     seeder->Seed(seed);
 
+    ParticleIndex.Build(Particles);
+
     SeedQueue.clear();
     Orbits.clear();
     Planets.resize(Particles.size());
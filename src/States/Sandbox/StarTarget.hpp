@@ -5,6 +5,7 @@
 #include <CommonStates.h>
 
 #include "Render/Planet/Planet.hpp"
+#include "Core/SpatialIndex.hpp"
 
 class StarTarget : public SandboxTarget
 {
@@ -80,6 +81,7 @@ private:
 
     std::deque<uint64_t> SeedQueue;
     std::vector<LWParticle> Particles;
+    SpatialIndex ParticleIndex;
     std::vector<std::unique_ptr<CPlanet>> Planets;
     std::vector<CPlanetSeeder> ParticleInfo;
     std::unique_ptr<CPostProcess> PostProcess;
@@ -44,6 +44,7 @@ void UniverseTarget::MoveObjects(Vector3 v)
     for (auto& galaxy : Galaxies)
         galaxy->Move(v);
 
+    GalaxyIndex.Translate(v);
     Centre += v;
 }
 
@@ -58,6 +59,7 @@ void UniverseTarget::ResetObjectPositions()
     for (auto& galaxy : Galaxies)
         galaxy->Move(-Centre);
 
+    GalaxyIndex.Translate(-Centre);
     Centre = Vector3::Zero;
 }
 
@@ -69,7 +71,8 @@ Vector3 UniverseTarget::GetRandomObjectPosition() const
 
 Vector3 UniverseTarget::GetClosestObject(Vector3 pos)
 {
-    return Maths::ClosestObject(pos, Galaxies, &CurrentClosestObjectID)->GetPosition();
+    CurrentClosestObjectID = GalaxyIndex.Nearest(pos);
+    return Galaxies[CurrentClosestObjectID]->GetPosition();
 }
 
 void UniverseTarget::RenderLerp(float t, bool single)
@@ -108,6 +111,13 @@ void UniverseTarget::Seed(uint64_t seed)
         Galaxies.back()->Move(particle.Position / 0.014f);
         Galaxies.back()->SetFades(false);
     }
+
+    std::vector<Vector3> positions;
+
+    for (const auto& galaxy : Galaxies)
+        positions.push_back(galaxy->GetPosition());
+
+    GalaxyIndex.Build(positions);
 }
 
 void UniverseTarget::BakeSkybox(Vector3 object)
@@ -1,6 +1,7 @@
 #include "SandboxTarget.hpp"
 #include "Render/Misc/Splatting.hpp"
 #include "Render/Universe/Galaxy.hpp"
+#include "Core/SpatialIndex.hpp"
 
 #include <memory>
 #include <CommonStates.h>
@@ -37,4 +38,7 @@ private:
     std::unique_ptr<DirectX::CommonStates> CommonStates;
     
     std::vector<std::unique_ptr<Galaxy>> Galaxies;
+
+    // Over the galaxies' positions, follows MoveObjects
+    SpatialIndex GalaxyIndex;
 };
\ No newline at end of file
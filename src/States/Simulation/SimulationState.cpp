@@ -1,8 +1,7 @@
 #include "SimulationState.hpp"
 #include "Services/Log.hpp"
-
-#include <fstream>
-#include <direct.h>
+#include "Sim/ParticleFile.hpp"
+#include "Sim/Precompute.hpp"
 
 void SimulationState::Init(DX::DeviceResources* resources, DirectX::Mouse* mouse, DirectX::Keyboard* keyboard, StateData& data)
 {
@@ -23,6 +22,7 @@ void SimulationState::Init(DX::DeviceResources* resources, DirectX::Mouse* mouse
 
 void SimulationState::Cleanup()
 {
+    SimThread.Stop();
     UI.reset();
 
     EventStream::UnregisterAll(EEvent::SimSpeedChanged);
@@ -35,6 +35,7 @@ void SimulationState::Cleanup()
     EventStream::UnregisterAll(EEvent::DrawDebugChanged);
     EventStream::UnregisterAll(EEvent::TrackParticle);
     EventStream::UnregisterAll(EEvent::LoadParticleFile);
+    EventStream::UnregisterAll(EEvent::LoadTrajectory);
     EventStream::UnregisterAll(EEvent::UseSplattingChanged);
     EventStream::UnregisterAll(EEvent::BenchmarkResult);
 }
@@ -43,21 +44,64 @@ void SimulationState::Update(float dt)
 {
     auto mouse_state = Mouse->GetState();
 
-    CheckParticleSelected(mouse_state);
-
     Camera->Events(Mouse, mouse_state, dt);
     Camera->Update(dt);
     UI->Update(dt);
 
-    if (!bIsPaused)
-        Sim->Update(dt * SimSpeed);
+    bool changed = bParticlesChanged;
+
+    if (bReplaying)
+    {
+        if (!bIsPaused)
+            StepReplay(dt * SimSpeed);
+    }
+    else if (SimType == ENBodySim::BruteForceGPU)
+    {
+        // Steps on the device context, so it stays on the render thread
+        if (!bIsPaused)
+            Sim->Update(dt * SimSpeed);
+
+        // The UI shows the velocity and forces of the selected particle
+        bool selected = SelectedParticle != SimulationThread::NoSelection;
+
+        if (selected)
+            Sim->SyncParticles();
+
+        if (!bIsPaused || selected)
+            SimThread.Submit(Particles);
+    }
+
+    // Only the packed stream and the selected particle come over from the simulation, Particles isn't updated
+    bool fresh = SimThread.Acquire();
+
+    if (fresh && SimThread.GetSelected())
+        SelectedState = *SimThread.GetSelected();
+
+    changed |= fresh;
+    changed |= CheckParticleSelected(mouse_state, fresh);
+    bParticlesChanged = false;
+
+    // Nothing new to draw since the last upload
+    if (!changed)
+        return;
 
     auto context = DeviceResources->GetD3DDeviceContext();
 
+    // Only the packed stream goes to the GPU, not the full simulation state
+    const RenderStream& stream = SimThread.GetStream();
+
     D3D11_MAPPED_SUBRESOURCE mapped;
     context->Map(ParticleBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
-    memcpy(mapped.pData, Particles.data(), Particles.size() * sizeof(Particle));
+    memcpy(mapped.pData, stream.Data(), (std::min)(stream.Size(), static_cast<size_t>(NumParticles)) * sizeof(PackedParticle));
     context->Unmap(ParticleBuffer.Get(), 0);
+
+    const auto& origin = stream.GetOrigin();
+    const auto& extent = stream.GetExtent();
+
+    VSBuffer->SetData(context, VSConstantBuffer {
+        DirectX::SimpleMath::Vector4(origin.x, origin.y, origin.z, 0.0f),
+        DirectX::SimpleMath::Vector4(extent.x, extent.y, extent.z, 0.0f)
+    });
 }
 
 void SimulationState::Render()
@@ -78,7 +122,10 @@ void SimulationState::Render()
     Context->GSSetShader(nullptr, 0, 0);
 
     if (bDrawDebug)
+    {
+        auto lock = SimThread.Lock();
         Sim->RenderDebug(Camera->GetViewMatrix(), Camera->GetProjectionMatrix());
+    }
 
     PostProcess->Render(renderTarget, dsv, DeviceResources->GetSceneTexture());
 
@@ -92,9 +139,10 @@ void SimulationState::RenderParticles()
 
     ParticlePipeline.SetState(Context, [&]() {
         unsigned int offset = 0;
-        unsigned int stride = sizeof(Particle);
+        unsigned int stride = sizeof(PackedParticle);
 
         Context->IASetVertexBuffers(0, 1, ParticleBuffer.GetAddressOf(), &stride, &offset);
+        Context->VSSetConstantBuffers(0, 1, VSBuffer->GetBuffer());
         GSBuffer->SetData(Context, GSConstantBuffer { view * proj, view.Invert() });
         Context->GSSetConstantBuffers(0, 1, GSBuffer->GetBuffer());
         Context->OMSetBlendState(CommonStates->Additive(), DirectX::Colors::Black, 0xFFFFFFFF);
@@ -104,19 +152,20 @@ void SimulationState::RenderParticles()
 
 void SimulationState::CreateDeviceDependentResources()
 {
-    Sim = CreateNBodySim(Context, ENBodySim::BarnesHut);
+    Sim = CreateNBodySim(Context, SimType);
     UI = std::make_unique<CUI>(Context, DeviceResources->GetWindow());
     CommonStates = std::make_unique<DirectX::CommonStates>(Device);
 
     ParticlePipeline.Topology = D3D_PRIMITIVE_TOPOLOGY_POINTLIST;
-    ParticlePipeline.LoadVertex(L"shaders/PassThruGS.vsh");
+    ParticlePipeline.LoadVertex(L"shaders/Particles/PackedParticle.vsh");
     ParticlePipeline.LoadPixel(L"shaders/Standard/PlainColour.psh");
     ParticlePipeline.LoadGeometry(L"shaders/Particles/DrawParticle.gsh");
     ParticlePipeline.CreateDepthState(Device, EDepthState::Read);
     ParticlePipeline.CreateRasteriser(Device, ECullMode::None);
-    ParticlePipeline.CreateInputLayout(Device, CreateInputLayoutPositionColourScale());
+    ParticlePipeline.CreateInputLayout(Device, CreateInputLayoutPackedParticle());
 
     GSBuffer = std::make_unique<ConstantBuffer<GSConstantBuffer>>(Device);
+    VSBuffer = std::make_unique<ConstantBuffer<VSConstantBuffer>>(Device);
 
     InitParticles();
 }
@@ -157,6 +206,7 @@ void SimulationState::RegisterEvents()
 {
     EventStream::Register(EEvent::SimSpeedChanged, [this](const EventData& data) {
         SimSpeed = EventValue<FloatEventData>(data);
+        SimThread.SetSpeed(SimSpeed);
     });
 
     EventStream::Register(EEvent::NumParticlesChanged, [this](const EventData& data) {
@@ -165,13 +215,18 @@ void SimulationState::RegisterEvents()
     });
 
     EventStream::Register(EEvent::SimTypeChanged, [this](const EventData& data) {
+        StopSim();
+
+        SimType = EventValue<SimTypeEventData>(data);
         Sim.reset();
-        Sim = CreateNBodySim(DeviceResources->GetD3DDeviceContext(), EventValue<SimTypeEventData>(data));
-        Sim->Init(Particles);
+        Sim = CreateNBodySim(DeviceResources->GetD3DDeviceContext(), SimType);
+
+        StartSim();
     });
 
     EventStream::Register(EEvent::IsPausedChanged, [this](const EventData& data) {
         bIsPaused = static_cast<const BoolEventData&>(data).Value;
+        SimThread.SetPaused(bIsPaused);
     });
 
     EventStream::Register(EEvent::SeederChanged, [this](const EventData& data) {
@@ -181,11 +236,26 @@ void SimulationState::RegisterEvents()
 
     EventStream::Register(EEvent::ForceFrame, [this](const EventData& data) {
         float dt = EventValue<FloatEventData>(data);
-        Sim->Update(dt * SimSpeed);
+
+        if (bReplaying)
+        {
+            StepReplay(dt * SimSpeed);
+        }
+        else if (SimThread.IsRunning())
+        {
+            SimThread.Step(dt * SimSpeed);
+        }
+        else
+        {
+            Sim->Update(dt * SimSpeed);
+            SimThread.Submit(Particles);
+        }
     });
 
     EventStream::Register(EEvent::RunBenchmark, [this](const EventData& data) {
+        StopSim();
         RunBenchmark();
+        StartSim();
     });
 
     EventStream::Register(EEvent::DrawDebugChanged, [this](const EventData& data) {
@@ -199,17 +269,54 @@ void SimulationState::RegisterEvents()
     });
 
     EventStream::Register(EEvent::LoadParticleFile, [this](const EventData& data) {
+        StopSim();
+
         if (InitParticlesFromFile(EventValue<StringEventData>(data), Particles))
         {
             NumParticles = static_cast<unsigned int>(Particles.size());
+            Deselect();
 
-            Sim->Init(Particles);
+            StartSim();
             ParticleBuffer.Reset();
 
-            CreateParticleBuffer(DeviceResources->GetD3DDevice(), ParticleBuffer.ReleaseAndGetAddressOf(), Particles);
+            CreateParticleBuffer<PackedParticle>(DeviceResources->GetD3DDevice(), ParticleBuffer.ReleaseAndGetAddressOf(), NumParticles);
+        }
+        else
+        {
+            StartSim();
         }
     });
 
+    EventStream::Register(EEvent::LoadTrajectory, [this](const EventData& data) {
+        StopSim();
+
+        std::string name = EventValue<StringEventData>(data);
+
+        if (!Replay.Open(std::string(ParticleFile::Directory) + "/" + name) || Replay.GetNumFrames() == 0)
+        {
+            StartSim();
+            return;
+        }
+
+        // Only decoding from here on, the simulation sits idle until something restarts it
+        Replay.GetParticles(Particles);
+        Replay.ReadFrame(0, Particles);
+
+        NumParticles = static_cast<unsigned int>(Particles.size());
+        Deselect();
+
+        bReplaying = true;
+        ReplayTime = 0.0;
+        ReplayFrame = 0;
+
+        SimThread.Submit(Particles);
+        ParticleBuffer.Reset();
+
+        CreateParticleBuffer<PackedParticle>(DeviceResources->GetD3DDevice(), ParticleBuffer.ReleaseAndGetAddressOf(), NumParticles);
+
+        LOGM("Replaying " + std::to_string(Replay.GetNumFrames()) + " frames from " + name)
+    });
+
     EventStream::Register(EEvent::UseSplattingChanged, [this](const EventData& data) {
         bUseSplatting = EventValue<BoolEventData>(data);
     });
@@ -217,118 +324,85 @@ void SimulationState::RegisterEvents()
 
 void SimulationState::InitParticles()
 {
-    UI->SetSelectedParticle(nullptr);
+    StopSim();
+
+    Deselect();
     Particles.resize(NumParticles);
     Seeder->Seed();
-    Sim->Init(Particles);
+
+    StartSim();
     ParticleBuffer.Reset();
 
-    CreateParticleBuffer(DeviceResources->GetD3DDevice(), ParticleBuffer.ReleaseAndGetAddressOf(), Particles);
+    CreateParticleBuffer<PackedParticle>(DeviceResources->GetD3DDevice(), ParticleBuffer.ReleaseAndGetAddressOf(), NumParticles);
 }
 
-bool SimulationState::InitParticlesFromFile(std::string fname, std::vector<Particle>& particles)
+void SimulationState::StartSim()
 {
-    std::ifstream infile("data/" + fname, std::ios::binary);
-
-    if (!infile.is_open())
-    {
-        LOGE("Could not read particle file " + fname)
-        return false;
-    }
-
-    particles.clear();
+    bParticlesChanged = true;
 
-    while (true)
-    {
-        Particle p;
-        infile.read(reinterpret_cast<char*>(&p), sizeof(Particle));
-
-        if (!infile)
-            break;
-
-        particles.push_back(p);
-    }
-
-    infile.close();
-
-    LOGM("Read " + std::to_string(particles.size()) + " particles from file")
-
-    long double TotalMass = 0.0;
-    Vec3d CentreOfMass;
+    // Anything which restarts the simulation ends a replay, it carries on from the frame shown
+    bReplaying = false;
+    Replay.Close();
 
-    for (const auto& particle : particles)
+    // The GPU simulation steps on the device context, so it stays on the render thread
+    if (SimType == ENBodySim::BruteForceGPU)
     {
-        Vec3d pos(particle.Position.x, particle.Position.y, particle.Position.z);
-
-        TotalMass += particle.Mass;
-        CentreOfMass += pos * particle.Mass;
+        Sim->Init(Particles);
+        SimThread.Submit(Particles);
+        return;
     }
 
-    CentreOfMass /= TotalMass;
-
-    DirectX::SimpleMath::Vector3 Centre(static_cast<float>(CentreOfMass.x),
-        static_cast<float>(CentreOfMass.y),
-        static_cast<float>(CentreOfMass.z));
-
-    for (auto& particle : particles)
-        particle.Position -= Centre;
-
-    return true;
+    SimThread.SetPaused(bIsPaused);
+    SimThread.SetSpeed(SimSpeed);
+    SimThread.Start(Sim.get(), Particles);
 }
 
-void SimulationState::RunSimulation(float dt, int time, int numparticles, std::string fileName)
+void SimulationState::StepReplay(float dt)
 {
-    std::vector<Particle> particles(numparticles);
+    const double frameTime = Replay.GetFrameTime();
+    const uint32_t lastFrame = Replay.GetNumFrames() - 1;
 
-    if (fileName.length() > 0)
-        InitParticlesFromFile(fileName, particles);
+    ReplayTime += dt;
 
-    auto sim = CreateNBodySim(nullptr, ENBodySim::BarnesHut);
-    auto seeder = CreateParticleSeeder(particles, EParticleSeeder::StarSystem);
+    // Holds on the last frame rather than looping
+    uint32_t frame = frameTime > 0.0 ? static_cast<uint32_t>((std::min)(ReplayTime / frameTime, static_cast<double>(lastFrame)))
+                                     : (std::min)(ReplayFrame + 1, lastFrame);
 
-    seeder->Seed();
-    sim->Init(particles);
+    if (frame == ReplayFrame)
+        return;
 
-    LARGE_INTEGER startTime, endTime, timer, tstart;
-    QueryPerformanceCounter(&startTime);
-    QueryPerformanceCounter(&tstart);
+    ReplayFrame = frame;
 
-    long iterations = 0;
-
-    while (true)
-    {
-        ++iterations;
-
-        QueryPerformanceCounter(&endTime);
-        timer = endTime;
-
-        if (static_cast<int>((endTime.QuadPart - startTime.QuadPart) / 10000000) >= time)
-            break;
+    if (Replay.ReadFrame(frame, Particles))
+        SimThread.Submit(Particles);
+}
 
-        if (static_cast<int>(((timer.QuadPart - tstart.QuadPart) / 10000000) >= 1))
-        {
-            QueryPerformanceCounter(&tstart);
-            LOGM("Running... (" + std::to_string(iterations) + " iterations)")
-        }
+void SimulationState::StopSim()
+{
+    if (!SimThread.IsRunning())
+        return;
 
-        sim->Update(dt);
-    }
+    SimThread.Stop();
+    SimThread.Acquire();
 
-    if (!_mkdir("data"))
-        LOGE("Failed to create data directory")
+    // Whatever runs next starts from where the simulation got to
+    Particles = SimThread.GetParticles();
+}
 
-    auto filename = "data/" + std::to_string(endTime.QuadPart) + ".nbody";
-    std::ofstream file(filename, std::ios::binary);
+bool SimulationState::InitParticlesFromFile(std::string fname, std::vector<Particle>& particles)
+{
+    return ParticleFile::Load(fname, particles);
+}
 
-    if (file.is_open())
-    {
-        for (const auto& p : particles)
-        {
-            file.write(reinterpret_cast<const char*>(&p), sizeof(p));
-        }
+void SimulationState::RunSimulation(float dt, int time, int numparticles, std::string fileName)
+{
+    PrecomputeSettings settings;
+    settings.Timestep = dt;
+    settings.SimTime = time;
+    settings.NumParticles = numparticles;
+    settings.File = fileName;
 
-        file.close();
-    }
+    RunPrecompute(settings);
 }
 
 void SimulationState::RunBenchmark()
@@ -361,36 +435,63 @@ void SimulationState::RunBenchmark()
     LOGM("Benchmark finished")
 }
 
-void SimulationState::CheckParticleSelected(DirectX::Mouse::State& ms)
+bool SimulationState::CheckParticleSelected(DirectX::Mouse::State& ms, bool fresh)
 {
     DirectX::SimpleMath::Vector2 mouse(static_cast<float>(ms.x),
         static_cast<float>(ms.y));
 
-    bool found = false;
+    // Positions as drawn, Particles only has the ones the simulation started from
+    RenderStream& stream = SimThread.GetStream();
+    const size_t num = (std::min)(Particles.size(), stream.Size());
 
-    for (auto& particle : Particles)
+    size_t hovered = SimulationThread::NoSelection;
+
+    for (size_t i = 0; i < num; ++i)
     {
         int x, y;
 
-        if (Camera->PixelFromWorldPoint(particle.Position, x, y))
+        if (Camera->PixelFromWorldPoint(stream.GetPosition(i), x, y))
         {
             DirectX::SimpleMath::Vector2 screenPos(static_cast<float>(x), static_cast<float>(y));
 
-            if (!found && DirectX::SimpleMath::Vector2::DistanceSquared(mouse, screenPos) < 100.0f)
-            {
-                particle.Colour = DirectX::Colors::Aqua;
-                found = true;
-
-                if (ms.leftButton)
-                {
-                    SelectedParticle = &particle;
-                    UI->SetSelectedParticle(SelectedParticle);
-                }
-            }
-            else
+            if (DirectX::SimpleMath::Vector2::DistanceSquared(mouse, screenPos) < 100.0f)
             {
-                particle.Colour = particle.OriginalColour;
+                hovered = i;
+                break;
             }
         }
     }
-}
\ No newline at end of file
+
+    if (hovered != SimulationThread::NoSelection && ms.leftButton)
+    {
+        SelectedParticle = hovered;
+        SelectedState = Particles[hovered];
+        SelectedState.Position = stream.GetPosition(hovered);
+
+        SimThread.SetSelected(hovered);
+        UI->SetSelectedParticle(&SelectedState);
+    }
+
+    // A fresh stream comes with the simulation's colours, so the highlight is put back on it
+    if (hovered == HighlightedParticle && !fresh)
+        return false;
+
+    if (HighlightedParticle < num)
+        stream.SetColour(HighlightedParticle, Particles[HighlightedParticle].OriginalColour);
+
+    if (hovered < num)
+        stream.SetColour(hovered, DirectX::SimpleMath::Color(DirectX::Colors::Aqua));
+
+    HighlightedParticle = hovered;
+
+    return true;
+}
+
+void SimulationState::Deselect()
+{
+    SelectedParticle = SimulationThread::NoSelection;
+    HighlightedParticle = SimulationThread::NoSelection;
+
+    SimThread.SetSelected(SimulationThread::NoSelection);
+    UI->SetSelectedParticle(nullptr);
+}
@@ -5,6 +5,8 @@
 #include "UI/UI.hpp"
 #include "Sim/INBodySim.hpp"
 #include "Sim/IParticleSeeder.hpp"
+#include "Sim/SimulationThread.hpp"
+#include "Sim/Trajectory.hpp"
 
 #include "Render/Cameras/ArcballCamera.hpp"
 #include "Render/Misc/Particle.hpp"
@@ -40,9 +42,13 @@ private:
     void Clear();
     void RegisterEvents();
     void InitParticles();
+    void StartSim();
+    void StopSim();
+    void StepReplay(float dt);
     void RenderParticles();
     void RunBenchmark();
-    void CheckParticleSelected(DirectX::Mouse::State& ms);
+    bool CheckParticleSelected(DirectX::Mouse::State& ms, bool fresh);
+    void Deselect();
 
     struct GSConstantBuffer
     {
@@ -50,6 +56,13 @@ private:
         DirectX::SimpleMath::Matrix InvView;
     };
 
+    // Bounds the render stream was quantised to
+    struct VSConstantBuffer
+    {
+        DirectX::SimpleMath::Vector4 Origin;
+        DirectX::SimpleMath::Vector4 Extent;
+    };
+
     ID3D11Device*                                     Device;
     ID3D11DeviceContext*                              Context;
     DX::DeviceResources*                              DeviceResources;
@@ -65,15 +78,29 @@ private:
     Microsoft::WRL::ComPtr<ID3D11Buffer>              ParticleBuffer;
 
     std::unique_ptr<ConstantBuffer<GSConstantBuffer>> GSBuffer;
+    std::unique_ptr<ConstantBuffer<VSConstantBuffer>> VSBuffer;
     std::vector<Particle>                             Particles;
     unsigned int                                      NumParticles = 1000;
-    Particle*                                         SelectedParticle = nullptr;             
+
+    // Indices into Particles, the selected particle's state comes from the simulation with each step
+    size_t                                            SelectedParticle = SimulationThread::NoSelection;
+    size_t                                            HighlightedParticle = SimulationThread::NoSelection;
+    Particle                                          SelectedState;
                                                       
     std::unique_ptr<INBodySim>                        Sim;
+    SimulationThread                                  SimThread;
+    ENBodySim                                         SimType = ENBodySim::BarnesHut;
+
+    // Plays a recorded trajectory instead of simulating while set
+    Trajectory::Reader                                Replay;
+    bool                                              bReplaying = false;
+    double                                            ReplayTime = 0.0;
+    uint32_t                                          ReplayFrame = 0;
     std::unique_ptr<IParticleSeeder>                  Seeder;
     float                                             SimSpeed = 0.02f;
     bool                                              bIsPaused = true;
     bool                                              bDrawDebug = false;
     bool                                              bUseBloom = true;
     bool                                              bUseSplatting = false;
+    bool                                              bParticlesChanged = true;
 };
\ No newline at end of file
@@ -53,6 +53,8 @@ void CUI::Render()
     float newBloomBaseSat = BloomBaseSat;
     float newGaussianBlur = GaussianBlur;
     float newBHTheta = BHTheta;
+    float newBHRebuildThreshold = BHRebuildThreshold;
+    int newFMMOrder = FMMOrder;
 
     bool runBenchmark = false;
 
@@ -91,13 +93,14 @@ void CUI::Render()
 
     for(int sim = 0; sim < static_cast<int>(ENBodySim::NumSims); ++sim)
     {
-        SimType = static_cast<ENBodySim>(sim);
+        auto type = static_cast<ENBodySim>(sim);
 
         if(sim % 2 != 0)
             ImGui::SameLine();
 
-        if(ImGui::Button(NBodySimGetName(SimType).c_str()))
+        if(ImGui::Button(NBodySimGetName(type).c_str()))
         {
+            SimType = type;
             EventStream::Report(EEvent::SimTypeChanged, SimTypeEventData(SimType));
         }
     }
@@ -105,6 +108,27 @@ void CUI::Render()
     if(SimType == ENBodySim::BarnesHut)
     {
         ImGui::SliderFloat("Theta", &newBHTheta, 0.1f, 6.0f);
+
+        if(ImGui::Combo("Criterion", &BHCriterion, "Classic\0Barnes\0Bmax\0"))
+        {
+            EventStream::Report(EEvent::BHCriterionChanged, IntEventData(BHCriterion));
+        }
+
+        if(ImGui::Checkbox("Quadrupoles", &BHQuadrupoles))
+        {
+            EventStream::Report(EEvent::BHQuadrupolesChanged, BoolEventData(BHQuadrupoles));
+        }
+
+        ImGui::SliderFloat("Rebuild threshold", &newBHRebuildThreshold, 0.0f, 1.0f);
+    }
+    else if(SimType == ENBodySim::FastMultipole)
+    {
+        ImGui::SliderInt("Order", &newFMMOrder, 1, 8);
+
+        if(ImGui::Checkbox("Mixed precision", &FMMMixedPrecision))
+        {
+            EventStream::Report(EEvent::FMMMixedPrecisionChanged, BoolEventData(FMMMixedPrecision));
+        }
     }
 
     ImGui::Separator();
@@ -155,6 +179,13 @@ void CUI::Render()
         EventStream::Report(EEvent::LoadParticleFile, StringEventData(FileBuf));
     }
 
+    ImGui::SameLine();
+
+    if(ImGui::Button("Replay"))
+    {
+        EventStream::Report(EEvent::LoadTrajectory, StringEventData(FileBuf));
+    }
+
     ImGui::Separator();
     ImGui::Text("Benchmarking");
 
@@ -191,6 +222,8 @@ void CUI::Render()
     UIPROPCHANGE(BloomSat, Float)
     UIPROPCHANGE(BloomBaseSat, Float)
     UIPROPCHANGE(BHTheta, Float)
+    UIPROPCHANGE(BHRebuildThreshold, Float)
+    UIPROPCHANGE(FMMOrder, Int)
 
     if(runBenchmark)
     {
@@ -32,6 +32,11 @@ private:
     bool Paused = true, DrawDebug = false;
     float SimSpeed = 0.02f;
     float BHTheta = 3.0f;
+    int BHCriterion = 0;
+    bool BHQuadrupoles = false;
+    float BHRebuildThreshold = 0.25f;
+    int FMMOrder = 4;
+    bool FMMMixedPrecision = false;
     int NumParticles = 1000;
     int SelectedSeeder = 0;
     bool UseBloom = true;
@@ -0,0 +1,62 @@
+#include "gtest/gtest.h"
+#include "Sim/BarnesHut.hpp"
+
+#include <random>
+#include <algorithm>
+
+namespace
+{
+    // Zones must start at the first leaf, end past the last and never go backwards, so every leaf is in exactly one
+    void CheckCoverage(const std::vector<size_t>& zones, size_t numLeaves, size_t numZones)
+    {
+        ASSERT_EQ(zones.size(), numZones + 1) << "One zone per thread expected";
+        ASSERT_EQ(zones.front(), 0u) << "First leaf not in a zone";
+        ASSERT_EQ(zones.back(), numLeaves) << "Last leaf not in a zone";
+
+        for(size_t z = 0; z < numZones; ++z)
+            ASSERT_LE(zones[z], zones[z + 1]) << "Zone " << z << " ends before it starts";
+    }
+}
+
+TEST(IndependentMethod, BarnesHutPartitionZones)
+{
+    // A dense core of expensive leaves in a sparse halo, some leaves with no active particles
+    std::vector<uint64_t> costs(2000);
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<uint64_t> halo(0, 50), core(1500, 2500);
+
+    for(size_t l = 0; l < costs.size(); ++l)
+        costs[l] = l >= 700 && l < 800 ? core(gen) : halo(gen);
+
+    const size_t numZones = 8;
+    std::vector<size_t> zones;
+    BarnesHut::PartitionCosts(costs, numZones, zones);
+
+    CheckCoverage(zones, costs.size(), numZones);
+
+    uint64_t total = 0, maxCost = 0;
+
+    for(uint64_t cost : costs)
+    {
+        total += cost;
+        maxCost = (std::max)(maxCost, cost);
+    }
+
+    for(size_t z = 0; z < numZones; ++z)
+    {
+        uint64_t zoneCost = 0;
+
+        for(size_t l = zones[z]; l < zones[z + 1]; ++l)
+            zoneCost += costs[l];
+
+        ASSERT_LE(zoneCost, total / numZones + maxCost) << "Zone " << z << " is over its share by more than one leaf";
+    }
+
+    // The core alone is most of the cost, so it must be spread over several zones
+    const size_t coreZones = std::upper_bound(zones.begin(), zones.end(), 800) - std::upper_bound(zones.begin(), zones.end(), 700);
+    ASSERT_GE(coreZones, numZones / 2) << "Dense core left on too few threads";
+
+    // Fewer leaves than threads, the extra zones are empty
+    BarnesHut::PartitionCosts({ 5, 1, 7 }, numZones, zones);
+    CheckCoverage(zones, 3, numZones);
+}
@@ -0,0 +1,182 @@
+#include "gtest/gtest.h"
+#include "Sim/Physics.hpp"
+#include "Sim/BlockTimestep.hpp"
+
+#include <cmath>
+
+namespace
+{
+    // A heavy star at the origin with light bodies on circular orbits in the xz plane
+    ParticleStore CreateOrbits(const std::vector<double>& radii)
+    {
+        ParticleStore store;
+        store.Resize(radii.size() + 1);
+
+        store.PosX[0] = store.PosY[0] = store.PosZ[0] = 0.0f;
+        store.VelX[0] = store.VelY[0] = store.VelZ[0] = 0.0;
+        store.Mass[0] = 1e30;
+
+        for(size_t i = 0; i < radii.size(); ++i)
+        {
+            const double r = radii[i];
+            const double a = -Phys::Gravity(1.0, 1e30, r * r);
+            const double v = std::sqrt(a * r / Phys::StarSystemScale) * Phys::StarSystemScale;
+
+            store.PosX[i + 1] = static_cast<float>(r);
+            store.PosY[i + 1] = store.PosZ[i + 1] = 0.0f;
+            store.VelX[i + 1] = store.VelY[i + 1] = 0.0;
+            store.VelZ[i + 1] = v;
+            store.Mass[i + 1] = 1e20;
+        }
+
+        for(size_t i = 0; i < store.Size(); ++i)
+            store.Id[i] = static_cast<uint32_t>(i);
+
+        return store;
+    }
+
+    void CalculateForces(ParticleStore& store, const std::vector<uint32_t>& active)
+    {
+        for(auto i : active)
+        {
+            Vec3d force;
+
+            for(size_t j = 0; j < store.Size(); ++j)
+            {
+                if(i == j)
+                    continue;
+
+                auto diff = store.GetPosition(i) - store.GetPosition(j);
+                double d2 = diff.LengthSquared();
+                double f = Phys::Gravity(store.Mass[i], store.Mass[j], d2) / std::sqrt(d2);
+
+                force += Vec3d(f * diff.x, f * diff.y, f * diff.z);
+            }
+
+            store.ForceX[i] = force.x;
+            store.ForceY[i] = force.y;
+            store.ForceZ[i] = force.z;
+        }
+    }
+
+    // Only the star's pull, cheap enough for stores large enough to split over threads
+    void CalculateCentralForces(ParticleStore& store, const std::vector<uint32_t>& active)
+    {
+        for(auto i : active)
+        {
+            if(i == 0)
+                continue;
+
+            auto diff = store.GetPosition(i) - store.GetPosition(0);
+            double d2 = diff.LengthSquared();
+            double f = Phys::Gravity(store.Mass[i], store.Mass[0], d2) / std::sqrt(d2);
+
+            store.ForceX[i] = f * diff.x;
+            store.ForceY[i] = f * diff.y;
+            store.ForceZ[i] = f * diff.z;
+        }
+    }
+
+    double TotalEnergy(const ParticleStore& store)
+    {
+        double energy = 0.0;
+
+        for(size_t i = 0; i < store.Size(); ++i)
+        {
+            double v2 = store.VelX[i] * store.VelX[i] + store.VelY[i] * store.VelY[i] + store.VelZ[i] * store.VelZ[i];
+            energy += 0.5 * store.Mass[i] * v2 / (Phys::StarSystemScale * Phys::StarSystemScale);
+
+            for(size_t j = i + 1; j < store.Size(); ++j)
+            {
+                double d2 = DirectX::SimpleMath::Vector3::DistanceSquared(store.GetPosition(i), store.GetPosition(j));
+                energy -= Phys::G * store.Mass[i] * store.Mass[j] / std::sqrt(d2 + Phys::S);
+            }
+        }
+
+        return energy;
+    }
+
+    using ForceFunc = void (*)(ParticleStore&, const std::vector<uint32_t>&);
+
+    size_t Step(BlockTimestep& steps, ParticleStore& store, double dt, ForceFunc forces = CalculateForces)
+    {
+        size_t substeps = 0;
+
+        steps.Begin(store, dt);
+
+        while(steps.NextSubstep(store))
+        {
+            forces(store, steps.FindActive(store));
+            steps.Kick(store);
+            ++substeps;
+        }
+
+        return substeps;
+    }
+}
+
+TEST(IndependentMethod, BlockTimestepLevelsFollowAcceleration)
+{
+    auto store = CreateOrbits({ 1.0, 200.0 });
+
+    TaskScheduler scheduler(4);
+    BlockTimestep steps(scheduler);
+    steps.Reset();
+
+    for(int i = 0; i < 4; ++i)
+        Step(steps, store, 1e-3);
+
+    ASSERT_GT(store.Level[1], store.Level[2]) << "The inner orbit should take shorter steps than the outer one";
+    ASSERT_LT(steps.GetForceEvaluations(), store.Size() * (1 << BlockTimestep::MaxLevel)) << "Not every particle should be on the finest level";
+}
+
+TEST(IndependentMethod, BlockTimestepConservesEnergy)
+{
+    auto store = CreateOrbits({ 0.5, 2.0, 10.0, 50.0, 300.0 });
+    const double initial = TotalEnergy(store);
+
+    TaskScheduler scheduler(4);
+    BlockTimestep steps(scheduler);
+    steps.Reset();
+
+    for(int i = 0; i < 50; ++i)
+        Step(steps, store, 1e-3);
+
+    ASSERT_NEAR(TotalEnergy(store), initial, std::abs(initial) * 1e-4) << "Energy drifted over the leapfrog steps";
+}
+
+TEST(IndependentMethod, BlockTimestepParallelMatchesSerial)
+{
+    std::vector<double> radii;
+
+    for(int i = 0; i < 20000; ++i)
+        radii.push_back(0.5 + i * 0.015);
+
+    auto serialStore = CreateOrbits(radii);
+    auto parallelStore = serialStore;
+
+    TaskScheduler serialScheduler(1), parallelScheduler(4);
+    BlockTimestep serialSteps(serialScheduler), parallelSteps(parallelScheduler);
+
+    serialSteps.Reset();
+    parallelSteps.Reset();
+
+    for(int i = 0; i < 3; ++i)
+    {
+        // Changes dt on the last step so the opening kicks are redone too
+        const double dt = i < 2 ? 1e-3 : 2e-3;
+
+        Step(serialSteps, serialStore, dt, CalculateCentralForces);
+        Step(parallelSteps, parallelStore, dt, CalculateCentralForces);
+    }
+
+    ASSERT_EQ(parallelSteps.GetForceEvaluations(), serialSteps.GetForceEvaluations()) << "Different particles were active";
+
+    for(size_t i = 0; i < serialStore.Size(); ++i)
+    {
+        ASSERT_EQ(parallelStore.Level[i], serialStore.Level[i]) << "Level of particle " << i << " differs";
+        ASSERT_EQ(parallelStore.PosX[i], serialStore.PosX[i]) << "Position of particle " << i << " differs";
+        ASSERT_EQ(parallelStore.PosZ[i], serialStore.PosZ[i]) << "Position of particle " << i << " differs";
+        ASSERT_EQ(parallelStore.VelZ[i], serialStore.VelZ[i]) << "Velocity of particle " << i << " differs";
+    }
+}
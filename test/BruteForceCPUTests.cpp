@@ -0,0 +1,24 @@
+#include "gtest/gtest.h"
+#include "Sim/BruteForceCPU.hpp"
+#include "Sim/ForceAccuracy.hpp"
+#include "Sim/IParticleSeeder.hpp"
+
+TEST(IndependentMethod, BruteForceCPUTiledMatchesAllPairs)
+{
+    // Not a multiple of the tile size, so the last tile is partial
+    std::vector<Particle> particles(1000);
+    CreateParticleSeeder(particles, EParticleSeeder::Galaxy)->Seed();
+
+    // Every particle, so a pair applied to only one of its bodies shows up
+    auto samples = ForceAccuracy::SampleParticles(particles.size(), particles.size());
+    auto reference = ForceAccuracy::ReferenceForces(particles, samples);
+
+    // Tile pairs are split between threads, each with its own accumulators summed afterwards
+    TaskScheduler::NumThreads = 4;
+    BruteForceCPU sim(nullptr);
+    TaskScheduler::NumThreads = 0;
+
+    auto result = ForceAccuracy::Measure(sim, particles, samples, reference, 0.0f, 0);
+
+    ASSERT_LT(result.Max, 1e-12) << "Tiled forces differ from the all pairs sum";
+}
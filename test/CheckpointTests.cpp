@@ -0,0 +1,56 @@
+#include "gtest/gtest.h"
+#include "Sim/Checkpoint.hpp"
+#include "Sim/ParticleFile.hpp"
+#include "Sim/IParticleSeeder.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+TEST(IndependentMethod, CheckpointResume)
+{
+    std::vector<Particle> particles(1000);
+    CreateParticleSeeder(particles, EParticleSeeder::Galaxy)->Seed();
+
+    const std::string name = "test_checkpoint.nbody";
+    const std::string data = std::string(ParticleFile::Directory) + "/";
+
+    ASSERT_TRUE(ParticleFile::MakeDirectory(ParticleFile::Directory)) << "No data directory";
+
+    std::vector<Particle> first, second;
+
+    {
+        Checkpointer checkpoints(name, particles.size());
+
+        ASSERT_TRUE(checkpoints.Take(particles, 10)) << "First checkpoint should be taken";
+        ASSERT_TRUE(checkpoints.Flush()) << "First checkpoint failed";
+        first = particles;
+
+        for(auto& p : particles)
+            p.Position.x += 1.0f;
+
+        ASSERT_TRUE(checkpoints.Take(particles, 20)) << "Second checkpoint should be taken";
+        ASSERT_TRUE(checkpoints.Flush()) << "Second checkpoint failed";
+        second = particles;
+    }
+
+    std::vector<Particle> resumed;
+    int64_t step = 0;
+
+    ASSERT_TRUE(Checkpointer::Resume(name, resumed, step)) << "Resume failed";
+    ASSERT_EQ(step, 20) << "Should resume from the newest checkpoint";
+    ASSERT_EQ(resumed[5].Position, second[5].Position) << "Resumed positions should be exact, not recentred";
+    ASSERT_EQ(resumed[5].Velocity.y, second[5].Velocity.y) << "Resumed velocities differ";
+
+    // A damaged newest checkpoint falls back to the one before
+    {
+        std::ofstream damaged(data + name + ".ckpt.1.nbody", std::ios::binary | std::ios::trunc);
+        damaged << "NBODYSNP";
+    }
+
+    ASSERT_TRUE(Checkpointer::Resume(name, resumed, step)) << "Resume should fall back to the older checkpoint";
+    ASSERT_EQ(step, 10) << "Should resume from the older checkpoint";
+    ASSERT_EQ(resumed[5].Position, first[5].Position) << "Older checkpoint positions differ";
+
+    for(const char* suffix : { ".ckpt", ".ckpt.0.nbody", ".ckpt.1.nbody" })
+        std::remove((data + name + suffix).c_str());
+}
@@ -0,0 +1,159 @@
+#include "gtest/gtest.h"
+#include "Sim/ForceAccuracy.hpp"
+#include "Sim/FastMultipole.hpp"
+#include "Sim/LinearOctree.hpp"
+#include "Sim/IParticleSeeder.hpp"
+
+TEST(IndependentMethod, ForceAccuracySampleParticles)
+{
+    auto samples = ForceAccuracy::SampleParticles(1000, 10);
+
+    ASSERT_EQ(samples.size(), 10u) << "Wrong number of samples";
+    ASSERT_EQ(samples.front(), 0u) << "Samples should start at the first particle";
+    ASSERT_EQ(samples[1] - samples[0], 100u) << "Samples should be evenly spaced";
+
+    ASSERT_EQ(ForceAccuracy::SampleParticles(5, 10).size(), 5u) << "Should sample every particle when there are fewer than asked for";
+}
+
+TEST(IndependentMethod, ForceAccuracyBruteForce)
+{
+    std::vector<Particle> particles(2000);
+    CreateParticleSeeder(particles, EParticleSeeder::Galaxy)->Seed();
+
+    auto samples = ForceAccuracy::SampleParticles(particles.size(), 200);
+    auto reference = ForceAccuracy::ReferenceForces(particles, samples);
+
+    // Brute force sums in double, so it should only differ from the reference by rounding
+    auto sim = CreateNBodySim(nullptr, ENBodySim::BruteForceCPU);
+    auto result = ForceAccuracy::Measure(*sim, particles, samples, reference, 0.0f, 0);
+
+    ASSERT_LT(result.Max, 1e-12) << "Brute force differs from the reference";
+
+    // Barnes-Hut approximates, but should still be close at the default theta
+    sim = CreateNBodySim(nullptr, ENBodySim::BarnesHut);
+    result = ForceAccuracy::Measure(*sim, particles, samples, reference, 0.0f, 0);
+
+    ASSERT_GT(result.RMS, 0.0) << "Barnes-Hut should not be exact";
+    ASSERT_LE(result.RMS, result.Max) << "RMS error above the maximum";
+    ASSERT_LE(result.P99, result.Max) << "99th percentile above the maximum";
+    ASSERT_LT(result.RMS, 0.1) << "Barnes-Hut too far off at the default theta";
+    ASSERT_LT(result.P99, 0.5) << "Barnes-Hut too far off at the default theta";
+
+    // And closer at a tighter one
+    const double theta = Octree::Theta;
+    Octree::Theta = 0.5;
+
+    sim = CreateNBodySim(nullptr, ENBodySim::BarnesHut);
+    result = ForceAccuracy::Measure(*sim, particles, samples, reference, 0.0f, 0);
+
+    Octree::Theta = theta;
+
+    ASSERT_LT(result.RMS, 1e-2) << "Barnes-Hut too far off at theta 0.5";
+    ASSERT_LT(result.P99, 3e-2) << "Barnes-Hut too far off at theta 0.5";
+}
+
+TEST(IndependentMethod, ForceAccuracyStarSystemBarnesHut)
+{
+    // Bodies on one line, the pulls from either side nearly cancel so a particle's force is a small difference
+    // and needs a small theta (see EOpeningCriterion). Neighbours are well inside the softening length
+    std::vector<Particle> particles(3000);
+    CreateParticleSeeder(particles, EParticleSeeder::StarSystem)->Seed();
+
+    auto samples = ForceAccuracy::SampleParticles(particles.size(), 300);
+    auto reference = ForceAccuracy::ReferenceForces(particles, samples);
+
+    const double theta = Octree::Theta;
+    Octree::Theta = 0.1;
+
+    for(bool quadrupoles : { false, true })
+    {
+        LinearOctree::UseQuadrupoles = quadrupoles;
+
+        auto run = particles;
+        auto sim = CreateNBodySim(nullptr, ENBodySim::BarnesHut);
+        auto result = ForceAccuracy::Measure(*sim, run, samples, reference, 0.0f, 0);
+
+        ASSERT_LT(result.RMS, 5e-2) << "Barnes-Hut too far off on the star system, quadrupoles " << quadrupoles;
+        ASSERT_LT(result.P99, 0.2) << "Barnes-Hut too far off on the star system, quadrupoles " << quadrupoles;
+    }
+
+    LinearOctree::UseQuadrupoles = false;
+    Octree::Theta = theta;
+}
+
+TEST(IndependentMethod, ForceAccuracyEscapedParticle)
+{
+    std::vector<Particle> particles(2000);
+    CreateParticleSeeder(particles, EParticleSeeder::Galaxy)->Seed();
+
+    double totalMass = 0.0;
+
+    for(const auto& p : particles)
+        totalMass += p.Mass;
+
+    // Far outside the rest and heavy enough that its pull is most of every other particle's force
+    particles[0].Position = DirectX::SimpleMath::Vector3(1e5f, 0.0f, 0.0f);
+    particles[0].Mass = 1e8 * totalMass;
+
+    auto samples = ForceAccuracy::SampleParticles(particles.size(), 200);
+    auto reference = ForceAccuracy::ReferenceForces(particles, samples);
+
+    for(ENBodySim type : { ENBodySim::BarnesHut, ENBodySim::FastMultipole })
+    {
+        auto run = particles;
+        auto sim = CreateNBodySim(nullptr, type);
+        auto result = ForceAccuracy::Measure(*sim, run, samples, reference, 0.0f, 0);
+
+        ASSERT_LT(result.P99, 1e-2) << "Escaped particle's force missing in simulation " << static_cast<int>(type);
+    }
+}
+
+TEST(IndependentMethod, ForceAccuracyStarSystemFMM)
+{
+    // Neighbouring bodies sit well inside the softening length, where the softened law is far from 1/r^2
+    std::vector<Particle> particles(3000);
+    CreateParticleSeeder(particles, EParticleSeeder::StarSystem)->Seed();
+
+    auto samples = ForceAccuracy::SampleParticles(particles.size(), 300);
+    auto reference = ForceAccuracy::ReferenceForces(particles, samples);
+
+    auto sim = CreateNBodySim(nullptr, ENBodySim::FastMultipole);
+    auto result = ForceAccuracy::Measure(*sim, particles, samples, reference, 0.0f, 0);
+
+    ASSERT_LT(result.RMS, 0.1) << "Far field doesn't follow the softened force";
+    ASSERT_LT(result.P99, 0.3) << "Far field doesn't follow the softened force";
+}
+
+TEST(IndependentMethod, ForceAccuracyMixedPrecisionFMM)
+{
+    std::vector<Particle> particles(4000);
+    CreateParticleSeeder(particles, EParticleSeeder::Galaxy)->Seed();
+
+    auto samples = ForceAccuracy::SampleParticles(particles.size(), 200);
+    auto reference = ForceAccuracy::ReferenceForces(particles, samples);
+
+    const bool oldMixed = FastMultipole::MixedPrecision;
+
+    auto sim = CreateNBodySim(nullptr, ENBodySim::FastMultipole);
+
+    FastMultipole::MixedPrecision = false;
+    auto doubleRun = particles;
+    auto doubleResult = ForceAccuracy::Measure(*sim, doubleRun, samples, reference, 0.0f, 0);
+
+    FastMultipole::MixedPrecision = true;
+    auto mixedRun = particles;
+    auto mixedResult = ForceAccuracy::Measure(*sim, mixedRun, samples, reference, 0.0f, 0);
+
+    FastMultipole::MixedPrecision = oldMixed;
+
+    std::vector<Vec3d> doubleForces;
+
+    for(uint32_t i : samples)
+        doubleForces.push_back(doubleRun[i].Forces);
+
+    auto drift = ForceAccuracy::Compare(mixedRun, samples, doubleForces);
+
+    ASSERT_GT(drift.Max, 0.0) << "Mixed precision should round differently from the double path";
+    ASSERT_LT(drift.Max, 1e-5) << "Mixed precision P2P too far from the double path";
+    ASSERT_NEAR(mixedResult.RMS, doubleResult.RMS, doubleResult.RMS * 0.01) << "Mixed precision changed the expansion error";
+}
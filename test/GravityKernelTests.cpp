@@ -0,0 +1,37 @@
+#include "gtest/gtest.h"
+#include "Sim/Kernels/Gravity.hpp"
+
+#include <cmath>
+#include <vector>
+
+TEST(IndependentMethod, GravityKernelMatchesScalar)
+{
+    // Not a multiple of any vector width so the tail paths run too
+    const size_t num = 37;
+
+    std::vector<float> x(num), y(num), z(num), mass(num);
+
+    for(size_t i = 0; i < num; ++i)
+    {
+        x[i] = static_cast<float>(i % 5) * 3.0f - 7.0f;
+        y[i] = static_cast<float>(i % 7) * -2.0f + 4.0f;
+        z[i] = static_cast<float>(i % 3) * 5.0f;
+        mass[i] = 0.1f + static_cast<float>(i) / num;
+    }
+
+    Kernels::GravitySources sources = { x.data(), y.data(), z.data(), mass.data(), num, 10.0f };
+    Kernels::GravityTargets targets = { x.data(), y.data(), z.data(), num };
+
+    std::vector<double> expectedX(num), expectedY(num), expectedZ(num);
+    std::vector<double> actualX(num), actualY(num), actualZ(num);
+
+    Kernels::GravityScalar(sources, targets, expectedX.data(), expectedY.data(), expectedZ.data());
+    Kernels::SelectGravityKernel(nullptr)(sources, targets, actualX.data(), actualY.data(), actualZ.data());
+
+    for(size_t i = 0; i < num; ++i)
+    {
+        ASSERT_NEAR(actualX[i], expectedX[i], 1e-4 * (std::abs(expectedX[i]) + 1e-3)) << "x differs at " << i;
+        ASSERT_NEAR(actualY[i], expectedY[i], 1e-4 * (std::abs(expectedY[i]) + 1e-3)) << "y differs at " << i;
+        ASSERT_NEAR(actualZ[i], expectedZ[i], 1e-4 * (std::abs(expectedZ[i]) + 1e-3)) << "z differs at " << i;
+    }
+}
@@ -0,0 +1,51 @@
+#include "gtest/gtest.h"
+#include "Sim/BruteForceCPU.hpp"
+#include "Sim/GravityPolicy.hpp"
+#include "Sim/ForceAccuracy.hpp"
+#include "Sim/IParticleSeeder.hpp"
+
+#include <cmath>
+
+TEST(IndependentMethod, GravityPolicyKernels)
+{
+    for(double d2 : { 0.01, 1.0, 10.0, 1e4 })
+    {
+        double expected = -Phys::Gravity(1.0, 1.0, d2) / Phys::G / std::sqrt(d2);
+
+        ASSERT_NEAR(Phys::Plummer<double>::Kernel(d2), expected, expected * 1e-12) << "Plummer differs from Phys::Gravity at " << d2;
+    }
+
+    ASSERT_NEAR(Phys::SplineLength, 2.8 * std::sqrt(Phys::S), 1e-9) << "Spline length out of step with S";
+
+    // Newtonian outside the spline and continuous where its pieces meet
+    const double h = Phys::SplineLength;
+
+    for(double r : { h, 1.5 * h, 10.0 * h })
+        ASSERT_NEAR(Phys::Spline<double>::Kernel(r * r), Phys::Unsoftened<double>::Kernel(r * r), 1e-9 / (r * r * r)) << "Spline should be Newtonian at " << r;
+
+    for(double u : { 0.5, 1.0 })
+    {
+        double below = Phys::Spline<double>::Kernel((u - 1e-7) * h * (u - 1e-7) * h);
+        double above = Phys::Spline<double>::Kernel((u + 1e-7) * h * (u + 1e-7) * h);
+
+        ASSERT_NEAR(below, above, 1e-5 * above) << "Spline jumps at u = " << u;
+    }
+
+    ASSERT_TRUE(std::isfinite(Phys::Spline<float>::Kernel(1e-12f))) << "Spline should stay finite for close pairs";
+}
+
+TEST(IndependentMethod, GravityPolicyFloatBruteForce)
+{
+    std::vector<Particle> particles(2000);
+    CreateParticleSeeder(particles, EParticleSeeder::Galaxy)->Seed();
+
+    auto samples = ForceAccuracy::SampleParticles(particles.size(), 200);
+    auto reference = ForceAccuracy::ReferenceForces(particles, samples);
+
+    // Same law as the reference, only the precision of the sums differs
+    BruteForceCPUSim<Phys::Plummer<float>> sim(nullptr);
+    auto result = ForceAccuracy::Measure(sim, particles, samples, reference, 0.0f, 0);
+
+    ASSERT_GT(result.Max, 0.0) << "Float sums should not match the reference exactly";
+    ASSERT_LT(result.P99, 1e-4) << "Float sums too far from the reference";
+}
@@ -0,0 +1,273 @@
+#include "gtest/gtest.h"
+#include "Sim/Physics.hpp"
+#include "Sim/LinearOctree.hpp"
+#include "Sim/Morton.hpp"
+
+#include <cmath>
+#include <random>
+
+namespace
+{
+    // Error of the force on a far particle from a tight cluster, which is always taken as a multipole
+    double ClusterForceError(bool quadrupoles)
+    {
+        BoundingCube bounds = { { -100.0f, -100.0f, -100.0f }, { 100.0f, 100.0f, 100.0f } };
+
+        ParticleStore store;
+        store.Resize(5);
+
+        const float cluster[4][3] = { { 2.0f, 0.0f, 0.0f }, { -1.0f, 1.0f, 0.0f }, { 0.0f, -2.0f, 1.0f }, { 1.0f, 1.0f, -3.0f } };
+
+        for(size_t i = 0; i < 4; ++i)
+        {
+            store.PosX[i] = -60.0f + cluster[i][0];
+            store.PosY[i] = -60.0f + cluster[i][1];
+            store.PosZ[i] = -60.0f + cluster[i][2];
+            store.Mass[i] = 1e20 * (i + 1);
+        }
+
+        store.PosX[4] = 70.0f;
+        store.PosY[4] = 50.0f;
+        store.PosZ[4] = 60.0f;
+        store.Mass[4] = 1e20;
+
+        Vec3d exact;
+
+        for(size_t i = 0; i < 4; ++i)
+        {
+            auto diff = store.GetPosition(4) - store.GetPosition(i);
+            double f = Phys::Gravity(store.Mass[4], store.Mass[i], diff.LengthSquared());
+            diff.Normalize();
+
+            exact += Vec3d(f * diff.x, f * diff.y, f * diff.z);
+        }
+
+        // Loose enough to take the cluster's octant as one node but not the root
+        double theta = Octree::Theta;
+        Octree::Theta = 1.0;
+        LinearOctree::UseQuadrupoles = quadrupoles;
+
+        LinearOctree tree;
+        tree.Build(bounds, store);
+
+        // Toggled after the build as the UI may mid step, the walk keeps to the build's setting
+        LinearOctree::UseQuadrupoles = !quadrupoles;
+        EXPECT_EQ(tree.HasQuadrupoles(), quadrupoles) << "Tree should keep the setting it was built with";
+
+        uint32_t interactions = 0;
+        Vec3d force = tree.CalculateForce(4, &interactions);
+
+        Octree::Theta = theta;
+        LinearOctree::UseQuadrupoles = false;
+
+        EXPECT_EQ(interactions, 1U) << "Cluster should be a single interaction";
+
+        Vec3d diff(force.x - exact.x, force.y - exact.y, force.z - exact.z);
+
+        return std::sqrt(diff.x * diff.x + diff.y * diff.y + diff.z * diff.z) /
+               std::sqrt(exact.x * exact.x + exact.y * exact.y + exact.z * exact.z);
+    }
+}
+
+TEST(IndependentMethod, LinearOctreeQuadrupole)
+{
+    double monopole = ClusterForceError(false);
+    double quadrupole = ClusterForceError(true);
+
+    ASSERT_LT(quadrupole, monopole * 0.5) << "Quadrupole should improve the far force";
+}
+
+TEST(IndependentMethod, LinearOctreeRefit)
+{
+    BoundingCube bounds = { { -100.0f, -100.0f, -100.0f }, { 100.0f, 100.0f, 100.0f } };
+
+    ParticleStore store;
+    store.Resize(200);
+
+    for(size_t i = 0; i < store.Size(); ++i)
+    {
+        store.PosX[i] = static_cast<float>((i * 37) % 180) - 90.0f;
+        store.PosY[i] = static_cast<float>((i * 53) % 170) - 85.0f;
+        store.PosZ[i] = static_cast<float>((i * 71) % 190) - 95.0f;
+        store.Mass[i] = 1e20 * (1 + i % 3);
+    }
+
+    LinearOctree tree;
+    tree.Build(bounds, store);
+
+    // Every tenth particle jumps across the cube, the rest stay in their leaf
+    for(size_t i = 0; i < store.Size(); i += 10)
+        store.PosX[i] = -store.PosX[i] * 0.5f + 3.0f;
+
+    uint32_t moved = tree.Refit();
+
+    ASSERT_GT(moved, 0U) << "Particles which crossed cells should have moved";
+    ASSERT_LE(moved, 20U) << "Only the displaced particles should have moved";
+
+    double totalMass = 0.0;
+    Vec3d centre;
+
+    for(size_t i = 0; i < store.Size(); ++i)
+    {
+        totalMass += store.Mass[i];
+        centre += Vec3d(store.PosX[i], store.PosY[i], store.PosZ[i]) * store.Mass[i];
+    }
+
+    centre = centre / totalMass;
+
+    const auto& nodes = tree.GetNodes();
+    ASSERT_EQ(nodes[0].NumParticles, store.Size()) << "Refit lost particles";
+    ASSERT_NEAR(nodes[0].TotalMass, totalMass, totalMass * 1e-12) << "Root mass is wrong after refit";
+    ASSERT_NEAR(nodes[0].CentreOfMass.x, centre.x, 1e-3) << "Root centre of mass is wrong after refit";
+
+    for(const auto& node : nodes)
+    {
+        if(!node.IsLeaf())
+            continue;
+
+        for(uint32_t p = node.FirstParticle; p != LinearOctree::NullIndex; p = tree.GetNextParticle(p))
+        {
+            ASSERT_LE(std::abs(store.PosX[p] - node.Centre.x), node.HalfSize) << "Particle outside its leaf after refit";
+            ASSERT_LE(std::abs(store.PosY[p] - node.Centre.y), node.HalfSize) << "Particle outside its leaf after refit";
+            ASSERT_LE(std::abs(store.PosZ[p] - node.Centre.z), node.HalfSize) << "Particle outside its leaf after refit";
+        }
+    }
+
+    store.PosY[5] = 500.0f;
+    ASSERT_EQ(tree.Refit(), LinearOctree::NullIndex) << "A particle leaving the bounds should need a rebuild";
+}
+
+TEST(IndependentMethod, LinearOctreeMatchesOctree)
+{
+    BoundingCube bounds = { { -100.0f, -100.0f, -100.0f }, { 100.0f, 100.0f, 100.0f } };
+
+    // A diffuse cloud with a dense clump, so the tree has both shallow and deep branches
+    std::vector<Particle> particles(1500);
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    for(size_t i = 0; i < particles.size(); ++i)
+    {
+        const float spread = i % 3 == 0 ? 5.0f : 90.0f;
+        const float offset = i % 3 == 0 ? 40.0f : 0.0f;
+
+        particles[i].Position = DirectX::SimpleMath::Vector3(offset + spread * unit(gen), offset + spread * unit(gen), -offset + spread * unit(gen));
+        particles[i].Mass = 1e20 * (1.5 + unit(gen));
+    }
+
+    ParticleStore store;
+    store.Load(particles);
+
+    const auto criterion = LinearOctree::Criterion.load();
+    LinearOctree::Criterion = EOpeningCriterion::Classic;
+    LinearOctree::UseQuadrupoles = false;
+
+    LinearOctree tree;
+    tree.Build(bounds, store);
+
+    Octree octree(bounds);
+
+    for(auto& p : particles)
+        octree.Add(&p);
+
+    octree.CalculateMass();
+
+    // Every node near the top against an Octree over the same cube
+    for(const auto& node : tree.GetNodes())
+    {
+        if(node.Depth > 3 || node.NumParticles == 0)
+            continue;
+
+        BoundingCube cube = { node.Centre - Vec3<>(node.HalfSize, node.HalfSize, node.HalfSize),
+                              node.Centre + Vec3<>(node.HalfSize, node.HalfSize, node.HalfSize) };
+        Octree reference(cube, static_cast<int>(node.Depth));
+
+        for(auto& p : particles)
+        {
+            if(cube.Contains(p.Position))
+                reference.Add(&p);
+        }
+
+        reference.CalculateMass();
+
+        ASSERT_EQ(node.NumParticles, static_cast<uint32_t>(reference.NumParticles)) << "Node at depth " << node.Depth << " has the wrong particles";
+        ASSERT_NEAR(node.TotalMass, reference.TotalMass, reference.TotalMass * 1e-12) << "Node mass differs at depth " << node.Depth;
+        ASSERT_LT((node.CentreOfMass - reference.CentreOfMass).Length(), 1e-3f) << "Node centre of mass differs at depth " << node.Depth;
+    }
+
+    ASSERT_NEAR(tree.GetNodes()[0].TotalMass, octree.TotalMass, octree.TotalMass * 1e-12) << "Root mass differs";
+
+    // Same opening test, so only rounding in the centres of mass separates the forces
+    double maxError = 0.0;
+
+    for(uint32_t i = 0; i < particles.size(); ++i)
+    {
+        Vec3d expected = octree.CalculateForce(&particles[i]);
+        Vec3d force = tree.CalculateForce(i);
+
+        Vec3d diff(force.x - expected.x, force.y - expected.y, force.z - expected.z);
+        double error = std::sqrt(diff.x * diff.x + diff.y * diff.y + diff.z * diff.z) /
+                       std::sqrt(expected.x * expected.x + expected.y * expected.y + expected.z * expected.z);
+
+        maxError = (std::max)(maxError, error);
+    }
+
+    LinearOctree::Criterion = criterion;
+
+    ASSERT_LT(maxError, 1e-4) << "Forces differ from Octree";
+}
+
+TEST(IndependentMethod, LinearOctreeLeavesInMortonOrder)
+{
+    // Clumped, so branches end at many depths and the node array is far from Morton order
+    ParticleStore store;
+    store.Resize(20000);
+
+    std::mt19937 gen(7);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+
+    for(size_t i = 0; i < store.Size(); ++i)
+    {
+        const float spread = i % 4 == 0 ? 200.0f : 10.0f;
+        const float offset = static_cast<float>(i % 5) * 80.0f;
+
+        store.PosX[i] = offset + spread * normal(gen);
+        store.PosY[i] = -offset + spread * normal(gen);
+        store.PosZ[i] = spread * normal(gen);
+        store.Mass[i] = 1e20;
+    }
+
+    TaskScheduler scheduler(4);
+    MortonSorter sorter;
+
+    auto bounds = Morton::FitBounds(store, scheduler);
+    size_t numInside = sorter.Sort(store, bounds, scheduler);
+
+    LinearOctree tree;
+    tree.BuildSorted(bounds, store, sorter.GetKeys(), numInside, 32);
+
+    std::vector<uint32_t> leaves;
+    tree.GetLeaves(leaves);
+
+    const auto& nodes = tree.GetNodes();
+    size_t numLeaves = 0;
+
+    for(const auto& node : nodes)
+        numLeaves += node.IsLeaf() ? 1 : 0;
+
+    ASSERT_EQ(leaves.size(), numLeaves) << "Every leaf should be listed once";
+
+    // Particles are sorted by key, so leaves in Morton order hold consecutive ranges
+    uint32_t next = 0;
+
+    for(uint32_t leaf : leaves)
+    {
+        if(nodes[leaf].NumParticles == 0)
+            continue;
+
+        ASSERT_EQ(nodes[leaf].FirstParticle, next) << "Leaf " << leaf << " is out of Morton order";
+        next += nodes[leaf].NumParticles;
+    }
+
+    ASSERT_EQ(next, numInside) << "Leaves don't cover the sorted particles";
+}
@@ -0,0 +1,79 @@
+#include "gtest/gtest.h"
+#include "Sim/Morton.hpp"
+
+#include <random>
+
+TEST(IndependentMethod, MortonEncode)
+{
+    ASSERT_EQ(Morton::Encode(1, 0, 0), 1ULL) << "x should be the lowest bit";
+    ASSERT_EQ(Morton::Encode(0, 1, 0), 2ULL) << "y should be the second bit";
+    ASSERT_EQ(Morton::Encode(0, 0, 1), 4ULL) << "z should be the third bit";
+    ASSERT_EQ(Morton::Encode(3, 0, 0), 9ULL) << "Bits not interleaved";
+}
+
+TEST(IndependentMethod, MortonOctant)
+{
+    BoundingCube bounds = { { -10.0f, -10.0f, -10.0f }, { 10.0f, 10.0f, 10.0f } };
+
+    auto key = Morton::Key(DirectX::SimpleMath::Vector3(5.0f, -5.0f, 5.0f), bounds);
+
+    ASSERT_EQ(Morton::Octant(key, 0), 5U) << "Wrong root octant";
+    ASSERT_EQ(Morton::Key(DirectX::SimpleMath::Vector3(20.0f, 0.0f, 0.0f), bounds), Morton::InvalidKey) << "Key outside bounds";
+}
+
+TEST(IndependentMethod, MortonFitBounds)
+{
+    std::vector<Particle> particles(1000);
+
+    for(size_t i = 0; i < particles.size(); ++i)
+    {
+        float t = static_cast<float>(i) / particles.size();
+        particles[i].Position = DirectX::SimpleMath::Vector3(100.0f + 50.0f * t, -20.0f * t, 10.0f);
+        particles[i].Mass = 1.0;
+    }
+
+    particles.back().Position = DirectX::SimpleMath::Vector3(1e6f, 0.0f, 0.0f);
+
+    ParticleStore store;
+    store.Load(particles);
+
+    TaskScheduler scheduler(4);
+    auto bounds = Morton::FitBounds(store, scheduler);
+
+    for(size_t i = 0; i + 1 < particles.size(); ++i)
+        ASSERT_TRUE(bounds.Contains(particles[i].Position)) << "Particle " << i << " outside the fitted bounds";
+
+    ASSERT_FALSE(bounds.Contains(particles.back().Position)) << "Far particle should escape the bounds";
+    ASSERT_LT(bounds.BottomRight.x - bounds.TopLeft.x, 60.0f) << "Bounds not fitted to the particles";
+
+    // Fewer than 1/256 of them far out, so all would escape if they weren't capped
+    particles.assign(100000, Particle());
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    for(size_t i = 0; i < particles.size(); ++i)
+    {
+        particles[i].Position = DirectX::SimpleMath::Vector3(unit(gen), unit(gen), unit(gen));
+        particles[i].Mass = 1.0;
+    }
+
+    const size_t numFar = 300;
+
+    for(size_t i = 0; i < numFar; ++i)
+    {
+        DirectX::SimpleMath::Vector3 dir(unit(gen), unit(gen), unit(gen));
+        dir.Normalize();
+        particles[i].Position = 1e5f * dir;
+    }
+
+    store.Load(particles);
+    bounds = Morton::FitBounds(store, scheduler);
+
+    size_t escaped = 0;
+
+    for(const auto& p : particles)
+        escaped += bounds.Contains(p.Position) ? 0 : 1;
+
+    ASSERT_GT(escaped, 0u) << "The furthest particles should still escape";
+    ASSERT_LE(escaped, Morton::MaxEscaped) << "Escaped particles not capped";
+}
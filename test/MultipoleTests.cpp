@@ -0,0 +1,86 @@
+#include "gtest/gtest.h"
+#include "Sim/Multipole.hpp"
+
+#include <cmath>
+
+namespace
+{
+    // Relative error of the field of a small cluster after P2M, M2M, M2L, L2L and L2P, against the
+    // force softened by exactSoftening, expanding with expansionSoftening
+    double ExpansionError(int order, double exactSoftening = 0.0, double expansionSoftening = 0.0)
+    {
+        ParticleStore store;
+        store.Resize(8);
+
+        for(size_t i = 0; i < 8; ++i)
+        {
+            store.PosX[i] = (i & 1) ? 0.9f : 0.1f;
+            store.PosY[i] = (i & 2) ? 0.8f : 0.3f;
+            store.PosZ[i] = (i & 4) ? 0.7f : 0.2f;
+            store.Mass[i] = 1.0 + i;
+        }
+
+        const Vec3d target(8.3, -1.2, 3.1);
+        Vec3d exact;
+
+        for(size_t i = 0; i < 8; ++i)
+        {
+            Vec3d diff(target.x - store.PosX[i], target.y - store.PosY[i], target.z - store.PosZ[i]);
+            double r = std::sqrt(diff.x * diff.x + diff.y * diff.y + diff.z * diff.z);
+
+            exact += diff * (-store.Mass[i] / (r * (r * r + exactSoftening)));
+        }
+
+        MultipoleExpansion expansion(order);
+        expansion.SetSoftening(expansionSoftening);
+
+        double child[MultipoleExpansion::MaxCoefficients] = {};
+        double parent[MultipoleExpansion::MaxCoefficients] = {};
+        double local[MultipoleExpansion::MaxCoefficients] = {};
+        double childLocal[MultipoleExpansion::MaxCoefficients] = {};
+
+        expansion.P2M(Vec3d(0.5, 0.5, 0.5), store, 0, 8, child);
+        expansion.M2M(child, Vec3d(0.5, 0.5, 0.5), parent);
+        expansion.M2L(parent, Vec3d(8.0, -1.0, 3.0), local);
+        expansion.L2L(local, Vec3d(0.2, -0.1, 0.05), childLocal);
+
+        Vec3d gradient = expansion.L2P(childLocal, Vec3d(0.1, -0.1, 0.05));
+        Vec3d diff = gradient - exact;
+
+        return std::sqrt(diff.x * diff.x + diff.y * diff.y + diff.z * diff.z) /
+               std::sqrt(exact.x * exact.x + exact.y * exact.y + exact.z * exact.z);
+    }
+}
+
+TEST(IndependentMethod, MultipoleConverges)
+{
+    double previous = ExpansionError(1);
+
+    for(int order = 2; order <= MultipoleExpansion::MaxOrder; ++order)
+    {
+        double error = ExpansionError(order);
+
+        ASSERT_LT(error, previous) << "Error should fall with order " << order;
+        previous = error;
+    }
+
+    ASSERT_LT(previous, 1e-5) << "Highest order expansion too inaccurate";
+}
+
+TEST(IndependentMethod, MultipoleSoftened)
+{
+    // The cluster is about 9 away, far outside sqrt(S) but close enough for softening to show
+    const double softening = 0.5;
+
+    double plain = ExpansionError(MultipoleExpansion::MaxOrder, softening, 0.0);
+    double softened = ExpansionError(MultipoleExpansion::MaxOrder, softening, softening);
+
+    ASSERT_GT(plain, 1e-3) << "Softening should be visible at this distance";
+    ASSERT_LT(softened, 1e-5) << "Softened expansion doesn't match the softened force";
+
+    MultipoleExpansion expansion;
+    expansion.SetSoftening(softening);
+
+    ASSERT_LT(expansion.GetSeriesError(80.0), 1e-7) << "Series error should be tiny far out";
+    ASSERT_GT(expansion.GetSeriesError(1.0), 1e-3) << "Series error should be large near sqrt(S)";
+}
@@ -0,0 +1,86 @@
+#include "gtest/gtest.h"
+#include "Sim/ParticleFile.hpp"
+#include "Sim/IParticleSeeder.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+    std::string DataPath(const std::string& name)
+    {
+        return std::string(ParticleFile::Directory) + "/" + name;
+    }
+}
+
+TEST(IndependentMethod, ParticleFileSnapshotRoundTrip)
+{
+    std::vector<Particle> particles(3000);
+    CreateParticleSeeder(particles, EParticleSeeder::Galaxy)->Seed();
+
+    for(size_t i = 0; i < particles.size(); ++i)
+        particles[i].Forces = Vec3d(1.0 * i, 2.0 * i, 3.0 * i);
+
+    const std::string name = "test_snapshot.nbody";
+    ASSERT_TRUE(ParticleFile::Save(name, particles)) << "Save failed";
+    ASSERT_TRUE(ParticleFile::IsSnapshot(DataPath(name))) << "Saved file should be a snapshot";
+
+    // Columns read in place from the mapping
+    ParticleFile::Snapshot snapshot;
+    ASSERT_TRUE(snapshot.Open(DataPath(name))) << "Snapshot should map";
+    ASSERT_EQ(snapshot.GetNumParticles(), particles.size()) << "Wrong particle count in header";
+
+    const double* mass = snapshot.GetColumn<double>("mass", 1);
+    ASSERT_NE(mass, nullptr) << "Mass column missing";
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(mass) % ParticleFile::ColumnAlignment, 0u) << "Columns should be aligned in the mapping";
+    ASSERT_EQ(mass[1234], particles[1234].Mass) << "Mass column differs";
+    ASSERT_EQ(snapshot.GetColumn<float>("mass", 1), nullptr) << "Lookups should check the column type";
+
+    TaskScheduler scheduler(4);
+    std::vector<Particle> loaded;
+    ASSERT_TRUE(snapshot.Read(scheduler, loaded)) << "Read failed";
+    ASSERT_EQ(loaded.size(), particles.size()) << "Read the wrong number of particles";
+
+    for(size_t i = 0; i < particles.size(); ++i)
+    {
+        ASSERT_EQ(loaded[i].Position, particles[i].Position) << "Position of particle " << i;
+        ASSERT_EQ(loaded[i].Velocity.x, particles[i].Velocity.x) << "Velocity of particle " << i;
+        ASSERT_EQ(loaded[i].Forces.z, particles[i].Forces.z) << "Forces of particle " << i;
+        ASSERT_EQ(loaded[i].OriginalColour, particles[i].OriginalColour) << "Colour of particle " << i;
+    }
+
+    snapshot.Close();
+    std::remove(DataPath(name).c_str());
+}
+
+TEST(IndependentMethod, ParticleFileLegacyConversion)
+{
+    std::vector<Particle> particles(500);
+    CreateParticleSeeder(particles, EParticleSeeder::Random)->Seed();
+
+    const std::string legacy = "test_legacy.nbody";
+    const std::string converted = "test_converted.nbody";
+
+    ASSERT_TRUE(ParticleFile::MakeDirectory(ParticleFile::Directory)) << "No data directory";
+
+    {
+        std::ofstream file(DataPath(legacy), std::ios::binary);
+        file.write(reinterpret_cast<const char*>(particles.data()), particles.size() * sizeof(Particle));
+    }
+
+    std::vector<Particle> fromLegacy, fromSnapshot;
+    ASSERT_TRUE(ParticleFile::Load(legacy, fromLegacy)) << "Legacy files should still load";
+    ASSERT_TRUE(ParticleFile::ConvertLegacy(legacy, converted)) << "Conversion failed";
+    ASSERT_TRUE(ParticleFile::Load(converted, fromSnapshot)) << "Converted file should load";
+
+    ASSERT_EQ(fromSnapshot.size(), fromLegacy.size()) << "Conversion changed the particle count";
+
+    for(size_t i = 0; i < fromLegacy.size(); ++i)
+    {
+        ASSERT_EQ(fromSnapshot[i].Position, fromLegacy[i].Position) << "Position of particle " << i;
+        ASSERT_EQ(fromSnapshot[i].Mass, fromLegacy[i].Mass) << "Mass of particle " << i;
+    }
+
+    std::remove(DataPath(legacy).c_str());
+    std::remove(DataPath(converted).c_str());
+}
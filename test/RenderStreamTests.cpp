@@ -0,0 +1,43 @@
+#include "gtest/gtest.h"
+#include "Sim/RenderStream.hpp"
+#include "Sim/IParticleSeeder.hpp"
+
+#include <cmath>
+
+TEST(IndependentMethod, RenderStreamPacking)
+{
+    std::vector<Particle> particles(20000);
+    CreateParticleSeeder(particles, EParticleSeeder::Galaxy)->Seed();
+
+    TaskScheduler scheduler(4);
+    RenderStream stream;
+    stream.Pack(scheduler, particles);
+
+    ASSERT_EQ(stream.Size(), particles.size()) << "Every particle should be packed";
+    ASSERT_EQ(sizeof(PackedParticle), 12u) << "Packed particles should stay 12 bytes";
+
+    const auto& extent = stream.GetExtent();
+
+    for(size_t i = 0; i < particles.size(); ++i)
+    {
+        auto position = stream.GetPosition(i);
+        const auto& expected = particles[i].Position;
+
+        // Half a quantisation step, plus float rounding in the rebuild
+        ASSERT_NEAR(position.x, expected.x, extent.x / 65535.0f * 0.51f + 1e-3f) << "x of particle " << i;
+        ASSERT_NEAR(position.y, expected.y, extent.y / 65535.0f * 0.51f + 1e-3f) << "y of particle " << i;
+        ASSERT_NEAR(position.z, expected.z, extent.z / 65535.0f * 0.51f + 1e-3f) << "z of particle " << i;
+    }
+
+    ASSERT_EQ(RenderStream::PackColour(DirectX::SimpleMath::Color(1.0f, 0.0f, 0.5f, 1.0f)), 0xFF8000FFu) << "Colours should pack as RGBA8 with red lowest";
+
+    // A particle far outside the others is still inside the measured bounds
+    particles[0].Position = DirectX::SimpleMath::Vector3(1e6f, -1e6f, 0.0f);
+    particles[1].Position.x = std::nanf("");
+
+    stream.Pack(scheduler, particles);
+
+    ASSERT_NEAR(stream.GetPosition(0).x, 1e6f, 1e6f * 1e-4f) << "Outlier should set the bounds";
+    ASSERT_NEAR(stream.GetPosition(0).y, -1e6f, 1e6f * 1e-4f) << "Outlier should set the bounds";
+    ASSERT_TRUE(std::isfinite(stream.GetPosition(1).x)) << "NaN positions should be clamped";
+}
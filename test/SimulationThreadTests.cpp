@@ -0,0 +1,61 @@
+#include "gtest/gtest.h"
+#include "Sim/SimulationThread.hpp"
+#include "Sim/IParticleSeeder.hpp"
+
+#include <chrono>
+
+TEST(IndependentMethod, SimulationThreadSteps)
+{
+    std::vector<Particle> particles(500);
+    CreateParticleSeeder(particles, EParticleSeeder::Galaxy)->Seed();
+
+    const auto initial = particles;
+
+    auto sim = CreateNBodySim(nullptr, ENBodySim::BruteForceCPU);
+    SimulationThread thread;
+
+    thread.SetPaused(true);
+    thread.SetSelected(10);
+    thread.Start(sim.get(), particles);
+
+    ASSERT_TRUE(thread.Acquire()) << "Starting should publish the initial state";
+    ASSERT_EQ(thread.GetStream().Size(), particles.size()) << "The initial state should be packed";
+    ASSERT_NE(thread.GetSelected(), nullptr) << "The selected particle should be published";
+    ASSERT_EQ(thread.GetSelected()->Position, initial[10].Position) << "Wrong particle published";
+
+    // Paused, so only the queued step runs
+    thread.Step(0.01f);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+    while(!thread.Acquire())
+    {
+        ASSERT_LT(std::chrono::steady_clock::now(), deadline) << "No step finished";
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    ASSERT_EQ(thread.GetSteps(), 1u) << "A paused thread should only take the queued step";
+    ASSERT_NE(thread.GetSelected()->Position, initial[10].Position) << "The step should have moved the particles";
+    ASSERT_NE(thread.GetStream().GetPosition(10), thread.GetStream().GetPosition(11)) << "The step should have been packed";
+
+    thread.SetSpeed(1.0f);
+    thread.SetPaused(false);
+
+    while(thread.GetSteps() < 3)
+    {
+        ASSERT_LT(std::chrono::steady_clock::now(), deadline) << "Unpaused thread isn't stepping";
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    thread.Stop();
+
+    ASSERT_TRUE(thread.Acquire()) << "Stopping should publish the final state";
+    ASSERT_NE(thread.GetParticles()[20].Velocity.x, initial[20].Velocity.x) << "The final state should include velocities";
+
+    thread.SetSelected(SimulationThread::NoSelection);
+    thread.Submit(thread.GetParticles());
+
+    ASSERT_TRUE(thread.Acquire()) << "Submit should publish";
+    ASSERT_EQ(thread.GetSelected(), nullptr) << "Nothing should be published once deselected";
+    ASSERT_FALSE(thread.IsRunning()) << "Thread should be joined";
+}
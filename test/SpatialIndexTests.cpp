@@ -0,0 +1,137 @@
+#include "gtest/gtest.h"
+#include "Core/Maths.hpp"
+#include "Core/SpatialIndex.hpp"
+#include "Sim/IParticleSeeder.hpp"
+
+#include <random>
+#include <algorithm>
+
+using DirectX::SimpleMath::Vector3;
+
+namespace
+{
+    std::vector<Particle> SeedParticles(size_t num)
+    {
+        std::vector<Particle> particles(num);
+        CreateParticleSeeder(particles, EParticleSeeder::Galaxy)->Seed();
+
+        return particles;
+    }
+
+    // Queries around and well outside the particles
+    std::vector<Vector3> RandomQueries(size_t num, float extent)
+    {
+        std::default_random_engine gen(7);
+        std::uniform_real_distribution<float> dist(-extent, extent);
+
+        std::vector<Vector3> queries(num);
+
+        for(auto& q : queries)
+            q = Vector3(dist(gen), dist(gen), dist(gen));
+
+        return queries;
+    }
+}
+
+TEST(IndependentMethod, SpatialIndexNearest)
+{
+    auto particles = SeedParticles(5000);
+
+    SpatialIndex index;
+    index.Build(particles);
+
+    ASSERT_EQ(index.Size(), particles.size()) << "Wrong number of points";
+
+    for(const auto& q : RandomQueries(500, 2000.0f))
+    {
+        size_t expected;
+        const auto& closest = Maths::ClosestParticle(q, particles, &expected);
+
+        size_t id = index.Nearest(q);
+
+        ASSERT_LT(id, particles.size()) << "Index out of range";
+        ASSERT_EQ(Vector3::DistanceSquared(q, particles[id].Position), Vector3::DistanceSquared(q, closest.Position)) << "Not the closest particle";
+    }
+
+    // A query exactly on a particle finds that particle
+    ASSERT_EQ(index.Nearest(particles[1234].Position), 1234U) << "Should find the particle queried at";
+}
+
+TEST(IndependentMethod, SpatialIndexKNearest)
+{
+    auto particles = SeedParticles(2000);
+
+    SpatialIndex index;
+    index.Build(particles);
+
+    std::vector<size_t> found;
+
+    for(const auto& q : RandomQueries(50, 1000.0f))
+    {
+        index.Nearest(q, 10, found);
+
+        ASSERT_EQ(found.size(), 10U) << "Wrong number of neighbours";
+
+        std::vector<float> distances(particles.size());
+
+        for(size_t i = 0; i < particles.size(); ++i)
+            distances[i] = Vector3::DistanceSquared(q, particles[i].Position);
+
+        std::vector<float> expected = distances;
+        std::partial_sort(expected.begin(), expected.begin() + 10, expected.end());
+
+        for(size_t i = 0; i < found.size(); ++i)
+            ASSERT_EQ(distances[found[i]], expected[i]) << "Neighbour " << i << " out of order or missing";
+    }
+
+    index.Nearest(Vector3::Zero, 5000, found);
+    ASSERT_EQ(found.size(), particles.size()) << "Should return every point when there are fewer than k";
+}
+
+TEST(IndependentMethod, SpatialIndexTransform)
+{
+    auto particles = SeedParticles(3000);
+
+    SpatialIndex index;
+    index.Build(particles);
+
+    // Moved and scaled wholesale the way Galaxy does, the index follows without a rebuild
+    const Vector3 move(250.0f, -40.0f, 12.5f);
+    const float scale = 5000.0f;
+
+    for(auto& p : particles)
+    {
+        p.Position /= scale;
+        p.Position += move;
+    }
+
+    index.Scale(1.0f / scale);
+    index.Translate(move);
+
+    for(const auto& q : RandomQueries(200, 1.0f))
+    {
+        Vector3 pos = q + move;
+
+        size_t expected;
+        const auto& closest = Maths::ClosestParticle(pos, particles, &expected);
+
+        size_t id = index.Nearest(pos);
+        float d = Vector3::DistanceSquared(pos, closest.Position);
+
+        ASSERT_NEAR(Vector3::DistanceSquared(pos, particles[id].Position), d, d * 1e-4f + 1e-12f) << "Not the closest particle after moving";
+    }
+}
+
+TEST(IndependentMethod, SpatialIndexEmpty)
+{
+    SpatialIndex index;
+    std::vector<size_t> found;
+
+    ASSERT_EQ(index.Nearest(Vector3::Zero), SpatialIndex::NoPoint) << "Empty index should find nothing";
+
+    index.Nearest(Vector3::Zero, 3, found);
+    ASSERT_TRUE(found.empty()) << "Empty index should find nothing";
+
+    index.Build(std::vector<Vector3>{ Vector3(1.0f, 2.0f, 3.0f) });
+    ASSERT_EQ(index.Nearest(Vector3(100.0f, 0.0f, 0.0f)), 0U) << "Single point should always be the closest";
+}
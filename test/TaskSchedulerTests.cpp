@@ -0,0 +1,135 @@
+#include "gtest/gtest.h"
+#include "Core/TaskScheduler.hpp"
+
+#include <atomic>
+#include <vector>
+#include <thread>
+
+TEST(IndependentMethod, WorkStealingQueueOrder)
+{
+    WorkStealingQueue<int> queue(2);
+    int items[4] = { 0, 1, 2, 3 };
+
+    // Past the starting capacity so the buffer grows
+    for(auto& item : items)
+        queue.Push(&item);
+
+    ASSERT_EQ(queue.Steal(), &items[0]) << "Thieves should take the oldest item";
+    ASSERT_EQ(queue.Pop(), &items[3]) << "The owner should take the newest item";
+    ASSERT_EQ(queue.Pop(), &items[2]) << "The owner should take the newest item";
+    ASSERT_EQ(queue.Steal(), &items[1]) << "Thieves should take the oldest item";
+    ASSERT_EQ(queue.Pop(), nullptr) << "Queue should be empty";
+    ASSERT_EQ(queue.Steal(), nullptr) << "Queue should be empty";
+}
+
+TEST(IndependentMethod, WorkStealingQueueConcurrentSteal)
+{
+    const int numItems = 100000;
+
+    WorkStealingQueue<int> queue;
+    std::vector<int> items(numItems);
+    std::vector<std::atomic<int>> taken(numItems);
+
+    for(auto& t : taken)
+        t = 0;
+
+    std::atomic<bool> done(false);
+
+    auto thief = [&]() {
+        while(!done)
+        {
+            if(int* item = queue.Steal())
+                ++taken[item - items.data()];
+        }
+
+        while(int* item = queue.Steal())
+            ++taken[item - items.data()];
+    };
+
+    std::thread thieves[3] = { std::thread(thief), std::thread(thief), std::thread(thief) };
+
+    for(int i = 0; i < numItems; ++i)
+    {
+        queue.Push(&items[i]);
+
+        if(i % 3 == 0)
+        {
+            if(int* item = queue.Pop())
+                ++taken[item - items.data()];
+        }
+    }
+
+    while(int* item = queue.Pop())
+        ++taken[item - items.data()];
+
+    done = true;
+
+    for(auto& t : thieves)
+        t.join();
+
+    for(int i = 0; i < numItems; ++i)
+        ASSERT_EQ(taken[i], 1) << "Item " << i << " was taken " << taken[i] << " times";
+}
+
+TEST(IndependentMethod, ParallelForCoversRange)
+{
+    TaskScheduler scheduler(4);
+
+    for(size_t count : { 0, 1, 7, 1000, 100003 })
+    {
+        std::vector<std::atomic<int>> visits(count);
+
+        for(auto& v : visits)
+            v = 0;
+
+        std::atomic<bool> badThread(false);
+
+        ParallelFor(scheduler, count, [&](size_t begin, size_t end, uint32_t thread) {
+            if(thread >= scheduler.GetNumThreads())
+                badThread = true;
+
+            for(size_t i = begin; i < end; ++i)
+                ++visits[i];
+        }, count / 64);
+
+        ASSERT_FALSE(badThread) << "Thread index out of range";
+
+        for(size_t i = 0; i < count; ++i)
+            ASSERT_EQ(visits[i], 1) << "Index " << i << " of " << count << " visited " << visits[i] << " times";
+    }
+}
+
+TEST(IndependentMethod, TaskSchedulerNestedTasks)
+{
+    TaskScheduler scheduler(4);
+    std::atomic<int> total(0);
+
+    // Tasks started from workers go on their own deques and waits inside tasks run other tasks
+    ParallelFor(scheduler, 16, [&](size_t begin, size_t end, uint32_t) {
+        for(size_t i = begin; i < end; ++i)
+        {
+            TaskGroup inner;
+
+            for(int j = 0; j < 8; ++j)
+                scheduler.Run(inner, [&]() { ++total; });
+
+            scheduler.Wait(inner);
+        }
+    }, 1);
+
+    ASSERT_EQ(total, 16 * 8) << "Nested tasks didn't all run";
+
+    // Tasks nobody waits for still run before the scheduler is gone
+    std::atomic<int> unwaited(0);
+    TaskGroup group;
+
+    {
+        TaskScheduler local(2);
+
+        for(int i = 0; i < 100; ++i)
+            local.Run(group, [&]() { ++unwaited; });
+    }
+
+    ASSERT_EQ(unwaited, 100) << "Queued tasks were dropped on destruction";
+    ASSERT_TRUE(group.IsDone()) << "Group should be done";
+}
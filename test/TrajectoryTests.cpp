@@ -0,0 +1,113 @@
+#include "gtest/gtest.h"
+#include "Sim/Trajectory.hpp"
+#include "Sim/IParticleSeeder.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+    // Moves every particle a little, different amounts per particle
+    void Advance(std::vector<Particle>& particles, int frame)
+    {
+        for(size_t i = 0; i < particles.size(); ++i)
+        {
+            particles[i].Position.x += 0.01f * std::sin(0.1f * frame + i);
+            particles[i].Position.y -= 0.02f * std::cos(0.3f * frame + i);
+            particles[i].Position.z += 0.005f * (i % 7);
+        }
+    }
+}
+
+TEST(IndependentMethod, TrajectoryRoundTrip)
+{
+    std::vector<Particle> particles(2000);
+    CreateParticleSeeder(particles, EParticleSeeder::Galaxy)->Seed();
+
+    const std::string path = "test_trajectory.nbtraj";
+    const int numFrames = 50;
+
+    Trajectory::Settings settings;
+    settings.FrameInterval = 5;
+    settings.Timestep = 0.01f;
+    settings.KeyframeInterval = 16;
+
+    std::vector<std::vector<Particle>> expected;
+
+    {
+        Trajectory::Writer writer;
+        ASSERT_TRUE(writer.Open(path, particles, settings)) << "Open failed";
+
+        for(int frame = 0; frame < numFrames; ++frame)
+        {
+            writer.Record(particles);
+            expected.push_back(particles);
+            Advance(particles, frame);
+        }
+
+        ASSERT_TRUE(writer.Close()) << "Close failed";
+        ASSERT_EQ(writer.GetNumFrames(), static_cast<uint32_t>(numFrames)) << "Frames lost";
+    }
+
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        const double perParticle = static_cast<double>(file.tellg()) / (numFrames * particles.size());
+
+        // Raw float positions take 12
+        ASSERT_LT(perParticle, 6.0) << "Deltas should take far fewer bytes than the raw positions";
+    }
+
+    Trajectory::Reader reader;
+    ASSERT_TRUE(reader.Open(path)) << "Reader failed to open";
+    ASSERT_EQ(reader.GetNumFrames(), static_cast<uint32_t>(numFrames)) << "Index has the wrong frame count";
+    ASSERT_NEAR(reader.GetFrameTime(), 0.05, 1e-6) << "Frame time should be the timestep times the interval";
+
+    std::vector<Particle> replay;
+    reader.GetParticles(replay);
+    ASSERT_EQ(replay[7].Mass, expected[0][7].Mass) << "Masses should be stored";
+
+    // In order, then seeks backwards and across keyframes
+    for(uint32_t frame : { 0u, 1u, 2u, 17u, 40u, 3u, 49u, 16u })
+    {
+        ASSERT_TRUE(reader.ReadFrame(frame, replay)) << "Failed to read frame " << frame;
+
+        for(size_t i = 0; i < replay.size(); i += 97)
+        {
+            ASSERT_NEAR(replay[i].Position.x, expected[frame][i].Position.x, settings.Quantum * 0.5f + 1e-3f) << "Frame " << frame << " particle " << i;
+            ASSERT_NEAR(replay[i].Position.y, expected[frame][i].Position.y, settings.Quantum * 0.5f + 1e-3f) << "Frame " << frame << " particle " << i;
+            ASSERT_NEAR(replay[i].Position.z, expected[frame][i].Position.z, settings.Quantum * 0.5f + 1e-3f) << "Frame " << frame << " particle " << i;
+        }
+    }
+
+    ASSERT_FALSE(reader.ReadFrame(numFrames, replay)) << "Reading past the end should fail";
+
+    reader.Close();
+
+    {
+        // A footer whose offset plus index length wraps round to the file size must not be trusted
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekg(-16, std::ios::end);
+
+        uint64_t indexOffset;
+        uint32_t frames;
+        file.read(reinterpret_cast<char*>(&indexOffset), sizeof(indexOffset));
+        file.read(reinterpret_cast<char*>(&frames), sizeof(frames));
+
+        const uint32_t extra = static_cast<uint32_t>(indexOffset / sizeof(uint64_t) + 1);
+        indexOffset -= extra * sizeof(uint64_t);
+        frames += extra;
+
+        file.seekp(-16, std::ios::end);
+        file.write(reinterpret_cast<const char*>(&indexOffset), sizeof(indexOffset));
+        file.write(reinterpret_cast<const char*>(&frames), sizeof(frames));
+    }
+
+    ASSERT_TRUE(reader.Open(path)) << "Reader should fall back to walking the frames";
+    ASSERT_LE(reader.GetNumFrames(), static_cast<uint32_t>(2 * numFrames + 1)) << "Wrapped footer was trusted";
+    ASSERT_TRUE(reader.ReadFrame(numFrames - 1, replay)) << "Frames should still be found by walking them";
+    ASSERT_NEAR(replay[0].Position.x, expected[numFrames - 1][0].Position.x, settings.Quantum * 0.5f + 1e-3f) << "Walked frame decoded wrong";
+    reader.Close();
+
+    std::remove(path.c_str());
+}
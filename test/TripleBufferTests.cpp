@@ -0,0 +1,63 @@
+#include "gtest/gtest.h"
+#include "Core/TripleBuffer.hpp"
+
+#include <thread>
+
+TEST(IndependentMethod, TripleBufferNewestValue)
+{
+    TripleBuffer<int> buffer;
+
+    ASSERT_FALSE(buffer.Acquire()) << "Nothing has been published";
+
+    buffer.GetBack() = 1;
+    buffer.Publish();
+    buffer.GetBack() = 2;
+    buffer.Publish();
+
+    ASSERT_TRUE(buffer.Acquire()) << "A value was published";
+    ASSERT_EQ(buffer.GetFront(), 2) << "The consumer should get the newest value";
+    ASSERT_FALSE(buffer.Acquire()) << "Nothing new since the last acquire";
+    ASSERT_EQ(buffer.GetFront(), 2) << "The front should stay put";
+
+    buffer.GetBack() = 3;
+    buffer.Publish();
+
+    ASSERT_TRUE(buffer.Acquire()) << "A value was published";
+    ASSERT_EQ(buffer.GetFront(), 3) << "The consumer should get the newest value";
+}
+
+TEST(IndependentMethod, TripleBufferConcurrent)
+{
+    const int numValues = 200000;
+
+    // Every element of a published value is the same, a torn hand over would mix two
+    TripleBuffer<std::vector<int>> buffer;
+
+    std::thread producer([&]() {
+        for(int i = 1; i <= numValues; ++i)
+        {
+            buffer.GetBack().assign(16, i);
+            buffer.Publish();
+        }
+    });
+
+    int last = 0;
+
+    while(last < numValues)
+    {
+        if(!buffer.Acquire())
+            continue;
+
+        const auto& value = buffer.GetFront();
+
+        ASSERT_EQ(value.size(), 16u) << "Value is missing elements";
+        ASSERT_GT(value[0], last) << "Values went backwards";
+
+        for(int v : value)
+            ASSERT_EQ(v, value[0]) << "Value was written while the consumer held it";
+
+        last = value[0];
+    }
+
+    producer.join();
+}